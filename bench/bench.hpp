@@ -0,0 +1,71 @@
+/// @file bench.hpp
+/// @brief Minimal benchmark harness used by enderman_bench.
+/// @brief Results can be written as JSON in the format of Google Benchmark so that its comparison tooling can be used across releases.
+
+#ifndef ENDERMAN_BENCH_HPP
+#define ENDERMAN_BENCH_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace enderman_bench
+{
+    /// @brief Prevent the compiler from optimizing away a value computed by a benchmark.
+    template <typename T>
+    inline void do_not_optimize(T const &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /// @brief Function running the measured operation the given number of times.
+    using BenchmarkFunction = std::function<void(size_t iterations)>;
+
+    struct Benchmark
+    {
+        std::string name;
+        BenchmarkFunction func;
+        /// @brief Bytes processed by one iteration, 0 if throughput in bytes is meaningless.
+        size_t bytes_per_iteration = 0;
+    };
+
+    struct Result
+    {
+        std::string name;
+        size_t iterations = 0;
+        /// @brief Median wall time per iteration in nanoseconds across repetitions.
+        double real_time = 0;
+        /// @brief Median CPU time per iteration in nanoseconds across repetitions.
+        double cpu_time = 0;
+        double min_real_time = 0;
+        double max_real_time = 0;
+        double items_per_second = 0;
+        double bytes_per_second = 0;
+    };
+
+    class Registry
+    {
+    private:
+        std::vector<Benchmark> benchmarks;
+
+    public:
+        /// @brief Register a benchmark.
+        /// @param name Name of the benchmark, segments separated by '/', e.g. "dispatch/routes:100/middlewares:5".
+        /// @param func Function running the operation the given number of times.
+        /// @param bytes_per_iteration Bytes processed by one iteration, used to report throughput.
+        void add(const std::string &name, BenchmarkFunction func, size_t bytes_per_iteration = 0)
+        {
+            benchmarks.push_back(Benchmark{name, std::move(func), bytes_per_iteration});
+        }
+        const std::vector<Benchmark> &all() const { return benchmarks; }
+    };
+
+    void register_uri_benchmarks(Registry &registry);
+    void register_path_benchmarks(Registry &registry);
+    void register_dispatch_benchmarks(Registry &registry);
+    void register_response_benchmarks(Registry &registry);
+    void register_body_benchmarks(Registry &registry);
+}
+
+#endif // ENDERMAN_BENCH_HPP
@@ -0,0 +1,95 @@
+#include "bench.hpp"
+
+#include "enderman/body.hpp"
+#include "enderman/standard_bodies/standard_bodies.hpp"
+#ifdef ENDERMAN_BENCH_JSON
+#include "enderman/json/json.hpp"
+#endif
+
+#include <string>
+#include <vector>
+
+void enderman_bench::register_body_benchmarks(Registry &registry)
+{
+    static const std::vector<char> binary(64 * 1024, '\x7f');
+    static const std::vector<char> text = []
+    {
+        std::string s;
+        while (s.size() < 16 * 1024)
+            s += "The quick brown fox jumps over the lazy dog. ";
+        return std::vector<char>(s.begin(), s.end());
+    }();
+    static const std::vector<char> form = []
+    {
+        std::string s;
+        for (int i = 0; i < 32; ++i)
+            s += (i ? "&field" : "field") + std::to_string(i) + "=value%20" + std::to_string(i) + "+with+spaces";
+        return std::vector<char>(s.begin(), s.end());
+    }();
+
+    registry.add("bodies/raw/parse_from", [](size_t iterations)
+                 {
+                     for (size_t i = 0; i < iterations; ++i)
+                     {
+                         enderman::RawBody body;
+                         body.parse_from(binary);
+                         do_not_optimize(body);
+                     } },
+                 binary.size());
+    registry.add("bodies/binary/set_data", [](size_t iterations)
+                 {
+                     for (size_t i = 0; i < iterations; ++i)
+                     {
+                         enderman::BinaryBody body;
+                         body.set_data(binary);
+                         do_not_optimize(body);
+                     } },
+                 binary.size());
+    static const enderman::SharedBuffer shared = enderman::SharedBody::make_buffer(binary);
+    registry.add("bodies/shared/construct", [](size_t iterations)
+                 {
+                     for (size_t i = 0; i < iterations; ++i)
+                     {
+                         enderman::SharedBody body(shared);
+                         do_not_optimize(body);
+                     } },
+                 binary.size());
+    registry.add("bodies/text/parse_from", [](size_t iterations)
+                 {
+                     for (size_t i = 0; i < iterations; ++i)
+                     {
+                         enderman::TextBody body;
+                         body.parse_from(text);
+                         do_not_optimize(body);
+                     } },
+                 text.size());
+    registry.add("bodies/url_encoded_form/parse_from", [](size_t iterations)
+                 {
+                     for (size_t i = 0; i < iterations; ++i)
+                     {
+                         enderman::UrlEncodedFormDataBody body;
+                         body.parse_from(form);
+                         do_not_optimize(body);
+                     } },
+                 form.size());
+
+#ifdef ENDERMAN_BENCH_JSON
+    static const std::vector<char> json = []
+    {
+        std::string s = "{\"items\":[";
+        for (int i = 0; i < 100; ++i)
+            s += (i ? ",{\"id\":" : "{\"id\":") + std::to_string(i) + ",\"name\":\"item " + std::to_string(i) + "\",\"price\":" + std::to_string(i * 1.5) + ",\"tags\":[\"a\",\"b\"]}";
+        s += "]}";
+        return std::vector<char>(s.begin(), s.end());
+    }();
+    registry.add("bodies/json/parse_from", [](size_t iterations)
+                 {
+                     for (size_t i = 0; i < iterations; ++i)
+                     {
+                         enderman::JsonBody body;
+                         body.parse_from(json);
+                         do_not_optimize(body);
+                     } },
+                 json.size());
+#endif
+}
@@ -0,0 +1,43 @@
+#include "bench.hpp"
+
+#include "enderman/enderman.hpp"
+#include "enderman/loopback.hpp"
+
+#include <memory>
+#include <string>
+
+void enderman_bench::register_dispatch_benchmarks(Registry &registry)
+{
+    for (int routes : {10, 100, 1000})
+    {
+        for (int middlewares : {0, 5, 20})
+        {
+            // The request targets the last registered route, so route matching scans the whole table.
+            auto app = std::make_shared<enderman::Enderman>();
+            for (int i = 0; i < middlewares; ++i)
+            {
+                app->use("/", [](enderman::Request &, enderman::Response &, const enderman::Next &next)
+                         { next(nullptr); });
+            }
+            for (int i = 0; i < routes; ++i)
+            {
+                app->get("/route" + std::to_string(i) + "/items/:id", [](enderman::Request &req, enderman::Response &res)
+                         { res.set_status(200).set_header("X-Item", req.path_params().at("id")).send(); });
+            }
+            auto loopback = std::make_shared<enderman::Loopback>(*app);
+            auto request = std::make_shared<enderman::LoopbackRequest>();
+            request->uri = "/route" + std::to_string(routes - 1) + "/items/42?expand=true";
+            request->headers = {{"host", "localhost"}, {"user-agent", "enderman_bench"}, {"accept", "*/*"}};
+
+            registry.add("dispatch/routes:" + std::to_string(routes) + "/middlewares:" + std::to_string(middlewares),
+                         [app, loopback, request](size_t iterations)
+                         {
+                             for (size_t i = 0; i < iterations; ++i)
+                             {
+                                 auto response = loopback->dispatch(*request);
+                                 do_not_optimize(response);
+                             }
+                         });
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#include "bench.hpp"
+
+#include "utils.hpp"
+
+#include <string>
+#include <vector>
+
+void enderman_bench::register_path_benchmarks(Registry &registry)
+{
+    static const std::vector<std::string> path = {"api", "v1", "users", "42", "posts", "7"};
+    static const std::vector<std::string> pattern = {"api", "v1", "users", ":user_id", "posts", ":post_id"};
+    static const std::vector<std::string> prefix = {"api", "v1", "*"};
+    static const std::vector<std::string> mismatch = {"api", "v2", "users", ":user_id", "posts", ":post_id"};
+
+    registry.add("path_tools/match_full_path/match", [](size_t iterations)
+                 {
+                     for (size_t i = 0; i < iterations; ++i)
+                     {
+                         bool matched = enderman::utils::PathTools::match_full_path(path, pattern);
+                         do_not_optimize(matched);
+                     } });
+    registry.add("path_tools/match_full_path/mismatch", [](size_t iterations)
+                 {
+                     for (size_t i = 0; i < iterations; ++i)
+                     {
+                         bool matched = enderman::utils::PathTools::match_full_path(path, mismatch);
+                         do_not_optimize(matched);
+                     } });
+    registry.add("path_tools/match_prefix", [](size_t iterations)
+                 {
+                     for (size_t i = 0; i < iterations; ++i)
+                     {
+                         bool matched = enderman::utils::PathTools::match_prefix(path, prefix);
+                         do_not_optimize(matched);
+                     } });
+    registry.add("path_tools/extract_path_params", [](size_t iterations)
+                 {
+                     for (size_t i = 0; i < iterations; ++i)
+                     {
+                         auto params = enderman::utils::PathTools::extract_path_params(path, pattern);
+                         do_not_optimize(params);
+                     } });
+}
@@ -0,0 +1,57 @@
+#include "bench.hpp"
+
+#include "enderman/response.hpp"
+#include "enderman/body.hpp"
+
+#include "response_writer.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+void enderman_bench::register_response_benchmarks(Registry &registry)
+{
+    registry.add("response/set_headers", [](size_t iterations)
+                 {
+                     for (size_t i = 0; i < iterations; ++i)
+                     {
+                         enderman::Response res;
+                         res.set_status(200)
+                             .set_header("Cache-Control", "no-cache")
+                             .set_header("X-Request-Id", "0123456789abcdef")
+                             .set_header("Vary", "Origin")
+                             .set_header("Access-Control-Allow-Origin", "*")
+                             .set_header("X-Frame-Options", "DENY");
+                         do_not_optimize(res);
+                     } });
+
+    for (size_t size : {size_t(64), size_t(16 * 1024), size_t(1024 * 1024)})
+    {
+        auto body = std::make_shared<enderman::RawBody>();
+        body->parse_from(std::vector<char>(size, 'x'));
+        registry.add("response/write/body:" + std::to_string(size), [body](size_t iterations)
+                     {
+                         for (size_t i = 0; i < iterations; ++i)
+                         {
+                             enderman::Response res;
+                             res.set_status(200).set_header("Cache-Control", "no-cache").set_body(body);
+                             auto headers = enderman::ResponseWriter::get_headers(res);
+                             auto data = enderman::ResponseWriter::get_body(res);
+                             do_not_optimize(headers);
+                             do_not_optimize(data);
+                         } },
+                     size);
+        registry.add("response/serialize/body:" + std::to_string(size), [body](size_t iterations)
+                     {
+                         std::string out;
+                         for (size_t i = 0; i < iterations; ++i)
+                         {
+                             enderman::Response res;
+                             res.set_status(200).set_header("Cache-Control", "no-cache").set_body(body);
+                             out.clear();
+                             enderman::ResponseWriter::serialize(res, out);
+                             do_not_optimize(out);
+                         } },
+                     size);
+    }
+}
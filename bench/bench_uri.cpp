@@ -0,0 +1,42 @@
+#include "bench.hpp"
+
+#include "utils.hpp"
+
+#include <string>
+
+void enderman_bench::register_uri_benchmarks(Registry &registry)
+{
+    static const std::string short_uri = "/users/42";
+    static const std::string long_uri = [] {
+        std::string uri;
+        for (int i = 0; i < 20; ++i)
+            uri += "/segment" + std::to_string(i);
+        uri += "?";
+        for (int i = 0; i < 10; ++i)
+            uri += (i ? "&key" : "key") + std::to_string(i) + "=value" + std::to_string(i);
+        return uri;
+    }();
+    static const std::string escaped_uri = [] {
+        std::string uri;
+        for (int i = 0; i < 10; ++i)
+            uri += "/%E2%9C%93%20caf%C3%A9%2Fpath" + std::to_string(i);
+        uri += "?q=%3Csearch%3E%20%26%20more%20%25%20text&name=J%C3%BCrgen+M%C3%BCller";
+        return uri;
+    }();
+
+    auto parse = [](const std::string &uri)
+    {
+        return [&uri](size_t iterations)
+        {
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                auto parsed = enderman::utils::UriParser::parse_uri(uri);
+                do_not_optimize(parsed);
+            }
+        };
+    };
+
+    registry.add("uri_parser/parse_uri/short", parse(short_uri), short_uri.size());
+    registry.add("uri_parser/parse_uri/long", parse(long_uri), long_uri.size());
+    registry.add("uri_parser/parse_uri/escaped", parse(escaped_uri), escaped_uri.size());
+}
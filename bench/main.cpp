@@ -0,0 +1,207 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        std::string filter;
+        double min_time = 0.5;
+        int repetitions = 3;
+        std::string json_path;
+    };
+
+    double cpu_seconds()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+
+    struct Measurement
+    {
+        double real_seconds;
+        double cpu_seconds;
+    };
+
+    Measurement measure(const enderman_bench::Benchmark &benchmark, size_t iterations)
+    {
+        double cpu_start = cpu_seconds();
+        auto start = std::chrono::steady_clock::now();
+        benchmark.func(iterations);
+        auto end = std::chrono::steady_clock::now();
+        return Measurement{std::chrono::duration<double>(end - start).count(), cpu_seconds() - cpu_start};
+    }
+
+    enderman_bench::Result run(const enderman_bench::Benchmark &benchmark, const Options &options)
+    {
+        // Grow the iteration count until one run is long enough to be timed reliably, then size the runs to min_time.
+        size_t iterations = 1;
+        Measurement m = measure(benchmark, iterations);
+        while (m.real_seconds < options.min_time / 10 && iterations < (size_t(1) << 40))
+        {
+            iterations *= 10;
+            m = measure(benchmark, iterations);
+        }
+        double per_iteration = m.real_seconds / iterations;
+        if (per_iteration > 0)
+            iterations = std::max<size_t>(1, static_cast<size_t>(options.min_time / per_iteration));
+
+        std::vector<double> real_times;
+        std::vector<double> cpu_times;
+        for (int i = 0; i < options.repetitions; ++i)
+        {
+            Measurement rep = measure(benchmark, iterations);
+            real_times.push_back(rep.real_seconds * 1e9 / iterations);
+            cpu_times.push_back(rep.cpu_seconds * 1e9 / iterations);
+        }
+        std::sort(real_times.begin(), real_times.end());
+        std::sort(cpu_times.begin(), cpu_times.end());
+
+        enderman_bench::Result result;
+        result.name = benchmark.name;
+        result.iterations = iterations;
+        result.real_time = real_times[real_times.size() / 2];
+        result.cpu_time = cpu_times[cpu_times.size() / 2];
+        result.min_real_time = real_times.front();
+        result.max_real_time = real_times.back();
+        result.items_per_second = result.real_time > 0 ? 1e9 / result.real_time : 0;
+        result.bytes_per_second = result.items_per_second * benchmark.bytes_per_iteration;
+        return result;
+    }
+
+    std::string json_escape(const std::string &value)
+    {
+        std::string out;
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+                out += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    void write_json(std::ostream &out, const std::vector<enderman_bench::Result> &results, const Options &options)
+    {
+        char date[64];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+        out << "{\n  \"context\": {\n";
+        out << "    \"date\": \"" << date << "\",\n";
+        out << "    \"executable\": \"enderman_bench\",\n";
+        out << "    \"library_version\": \"" << ENDERMAN_BENCH_VERSION << "\",\n";
+        out << "    \"build_type\": \"" << json_escape(ENDERMAN_BENCH_BUILD_TYPE) << "\",\n";
+        out << "    \"compiler\": \"" << json_escape(__VERSION__) << "\",\n";
+        out << "    \"min_time\": " << options.min_time << ",\n";
+        out << "    \"repetitions\": " << options.repetitions << "\n";
+        out << "  },\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto &r = results[i];
+            out << "    {\n";
+            out << "      \"name\": \"" << json_escape(r.name) << "\",\n";
+            out << "      \"run_type\": \"aggregate\",\n";
+            out << "      \"aggregate_name\": \"median\",\n";
+            out << "      \"iterations\": " << r.iterations << ",\n";
+            out << "      \"real_time\": " << r.real_time << ",\n";
+            out << "      \"cpu_time\": " << r.cpu_time << ",\n";
+            out << "      \"min_real_time\": " << r.min_real_time << ",\n";
+            out << "      \"max_real_time\": " << r.max_real_time << ",\n";
+            out << "      \"time_unit\": \"ns\",\n";
+            out << "      \"items_per_second\": " << r.items_per_second;
+            if (r.bytes_per_second > 0)
+                out << ",\n      \"bytes_per_second\": " << r.bytes_per_second;
+            out << "\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+    void print_usage()
+    {
+        std::cout << "Usage: enderman_bench [--filter <substring>] [--min-time <seconds>] [--repetitions <n>] [--json <file|->]\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--filter" && has_value)
+            options.filter = argv[++i];
+        else if (arg == "--min-time" && has_value)
+            options.min_time = std::atof(argv[++i]);
+        else if (arg == "--repetitions" && has_value)
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--json" && has_value)
+            options.json_path = argv[++i];
+        else
+        {
+            print_usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    enderman_bench::Registry registry;
+    enderman_bench::register_uri_benchmarks(registry);
+    enderman_bench::register_path_benchmarks(registry);
+    enderman_bench::register_dispatch_benchmarks(registry);
+    enderman_bench::register_response_benchmarks(registry);
+    enderman_bench::register_body_benchmarks(registry);
+
+    std::vector<enderman_bench::Result> results;
+    bool json_to_stdout = options.json_path == "-";
+    for (const auto &benchmark : registry.all())
+    {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos)
+            continue;
+        results.push_back(run(benchmark, options));
+        if (!json_to_stdout)
+        {
+            const auto &r = results.back();
+            std::printf("%-50s %14.1f ns %14.1f ns(cpu) %14zu it\n", r.name.c_str(), r.real_time, r.cpu_time, r.iterations);
+        }
+    }
+
+    if (json_to_stdout)
+    {
+        write_json(std::cout, results, options);
+    }
+    else if (!options.json_path.empty())
+    {
+        std::ofstream file(options.json_path);
+        if (!file)
+        {
+            std::cerr << "Unable to open " << options.json_path << std::endl;
+            return 1;
+        }
+        write_json(file, results, options);
+    }
+    return 0;
+}
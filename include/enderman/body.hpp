@@ -5,11 +5,57 @@
 #ifndef ENDERMAN_BODY_HPP
 #define ENDERMAN_BODY_HPP
 
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <typeinfo>
 
 namespace enderman
 {
+    /// @brief Read-only view of a contiguous part of a body, in the spirit of an iovec.
+    struct ConstBuffer
+    {
+        const char *data = nullptr;
+        size_t size = 0;
+    };
+
+    /// @brief Pull interface reading a body chunk by chunk, so that it never has to be copied into one piece.
+    class BodyReader
+    {
+    public:
+        virtual ~BodyReader() = default;
+        /// @brief Read the next chunk of the body.
+        /// @return View of the chunk, valid until the next call. Empty once the body is exhausted.
+        virtual std::string_view next() = 0;
+    };
+
+    /// @brief Reader returning memory it does not own as a single chunk.
+    class MemoryBodyReader : public BodyReader
+    {
+    private:
+        std::string_view remaining;
+
+    public:
+        /// @param data Data to read. Must outlive the reader.
+        explicit MemoryBodyReader(std::string_view data) : remaining(data) {}
+        std::string_view next() override { return std::exchange(remaining, std::string_view()); }
+    };
+
+    /// @brief Read the rest of a body into one string, for parsers that need the whole body at once.
+    /// @param reader Reader of the body, exhausted afterwards.
+    /// @return The bytes the reader returned.
+    inline std::string read_body(BodyReader &reader)
+    {
+        std::string data;
+        for (std::string_view chunk = reader.next(); !chunk.empty(); chunk = reader.next())
+            data.append(chunk.data(), chunk.size());
+        return data;
+    }
+
     /// @brief Abstract base class representing the body of a Request or Response.
     class Body
     {
@@ -24,6 +70,37 @@ namespace enderman
         /// This will be used to set the Content-Type header of the message.
         /// @return Content type as a string.
         virtual const std::string type() const = 0;
+        /// @brief Expose the body as read-only buffers so that it can be written without being copied into a vector first.
+        /// Override it in bodies that already hold their bytes; the default makes the framework fall back to serialize().
+        /// @param out Vector the buffers are appended to. They must stay valid as long as the body is alive and unmodified.
+        /// @return True if the buffers were appended, false if the body has to be serialized.
+        virtual bool buffers(std::vector<ConstBuffer> &/*out*/) const { return false; }
+        /// @brief Exact size of the serialized body, if it is known without serializing it.
+        /// @return Size in bytes, or std::nullopt if it is unknown.
+        virtual std::optional<size_t> content_length() const { return std::nullopt; }
+        /// @brief Open a reader over the body. The body must outlive the reader and stay unmodified while it is read.
+        /// The default serializes the body and returns it as one chunk; bodies kept in memory or in a file read it in place.
+        /// @return Reader positioned at the start of the body.
+        virtual std::unique_ptr<BodyReader> reader() const
+        {
+            class SerializedBodyReader : public BodyReader
+            {
+            private:
+                std::vector<char> data;
+                bool done = false;
+
+            public:
+                explicit SerializedBodyReader(std::vector<char> serialized) : data(std::move(serialized)) {}
+                std::string_view next() override
+                {
+                    if (done)
+                        return std::string_view();
+                    done = true;
+                    return std::string_view(data.data(), data.size());
+                }
+            };
+            return std::make_unique<SerializedBodyReader>(serialize());
+        }
 
         /// @brief Casts body to a specific type T.
         /// @tparam T Type to cast to, must be derived from Body.
@@ -55,27 +132,77 @@ namespace enderman
         }
     };
 
-    /// @brief A simple implementation of Body that holds raw binary data as a vector of characters.
+    /// @brief A simple implementation of Body that holds raw binary data.
+    /// Request bodies are borrowed from the transport until retain() is called; read them through view(), which works in both states.
     class RawBody : public Body
     {
-    public:
-        /// @brief The raw binary data of the body.
-        std::vector<char> data;
+    private:
+        /// @brief The data when the body owns it. Empty while the body is borrowed.
+        std::vector<char> owned_data;
+        const char *borrowed_data = nullptr;
+        size_t borrowed_size = 0;
+        bool borrowed = false;
 
+    public:
         RawBody() = default;
         ~RawBody() override = default;
         /// @brief Set data in body from a vector of characters.
         /// @param body The vector of characters to set as the body data.
         void parse_from(const std::vector<char> &body)
         {
-            data = body;
+            owned_data = body;
+            borrowed = false;
+        }
+        /// @brief Set data in body, taking over a vector of characters without copying it.
+        /// @param body The vector of characters to set as the body data.
+        void parse_from(std::vector<char> &&body)
+        {
+            owned_data = std::move(body);
+            borrowed = false;
+        }
+        /// @brief View memory owned by someone else instead of copying it.
+        /// @param body_data Start of the data. Must stay valid until retain() is called or the body is destroyed.
+        /// @param size Size of the data in bytes.
+        void borrow(const char *body_data, size_t size)
+        {
+            owned_data.clear();
+            borrowed_data = body_data;
+            borrowed_size = size;
+            borrowed = true;
+        }
+        /// @brief Copy borrowed data into the body. Does nothing if the body already owns its data.
+        void retain()
+        {
+            if (!borrowed)
+                return;
+            owned_data.assign(borrowed_data, borrowed_data + borrowed_size);
+            borrowed = false;
+        }
+        /// @brief Check if the body views memory it does not own.
+        bool is_borrowed() const { return borrowed; }
+        /// @brief Get the body data without copying it.
+        /// @return View of the data, valid until the body is modified, retained or destroyed.
+        std::string_view view() const
+        {
+            if (borrowed)
+                return std::string_view(borrowed_data, borrowed_size);
+            return std::string_view(owned_data.data(), owned_data.size());
         }
         /// @brief Serializes the raw body data into vector of characters.
         /// @return The raw body data as a vector of characters.
         std::vector<char> serialize() const override
         {
-            return data;
+            std::string_view bytes = view();
+            return std::vector<char>(bytes.begin(), bytes.end());
+        }
+        bool buffers(std::vector<ConstBuffer> &out) const override
+        {
+            std::string_view bytes = view();
+            out.push_back(ConstBuffer{bytes.data(), bytes.size()});
+            return true;
         }
+        std::optional<size_t> content_length() const override { return view().size(); }
+        std::unique_ptr<BodyReader> reader() const override { return std::make_unique<MemoryBodyReader>(view()); }
         /// @brief Get type of RawBody.
         /// @return application/octet-stream
         const std::string type() const override { return std::string("application/octet-stream"); }
@@ -0,0 +1,80 @@
+/// @file cancellation.hpp
+/// @brief Defines CancellationToken, through which middlewares and handlers learn that the response to their request is no longer wanted.
+
+#ifndef ENDERMAN_CANCELLATION_HPP
+#define ENDERMAN_CANCELLATION_HPP
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+namespace enderman
+{
+    /// @brief Why a request was cancelled.
+    enum class CancellationReason
+    {
+        NONE,
+        /// @brief The deadline of the request passed, see Request::deadline().
+        DEADLINE,
+        /// @brief The client closed the connection while the handler was running.
+        CLIENT_GONE,
+    };
+
+    /// @brief Thrown by CancellationToken::throw_if_cancelled() and the cancellable awaitables of task.hpp.
+    /// A route handler giving up with it is answered with 504 Gateway Timeout instead of 500.
+    class RequestCancelledException : public std::runtime_error
+    {
+    private:
+        CancellationReason _reason;
+
+    public:
+        explicit RequestCancelledException(CancellationReason reason)
+            : std::runtime_error(reason == CancellationReason::CLIENT_GONE ? "Request cancelled: client gone" : "Request cancelled: deadline exceeded"),
+              _reason(reason) {}
+        CancellationReason reason() const { return _reason; }
+    };
+
+    namespace detail
+    {
+        struct CancellationState;
+    }
+
+    /// @brief Cancellation of a request, see Request::cancellation(). Cheap to copy; copies observe the same request.
+    /// A token is cancelled once its deadline passes, or once the framework cancels it: the server loops do so when the deadline passes
+    /// while an offloaded or asynchronous handler runs, and when the connection of such a handler closes. A client that only shuts down its sending side still gets its response.
+    /// Cancellation is cooperative: handlers that keep going are not interrupted.
+    class CancellationToken
+    {
+    private:
+        /// @brief State shared with the framework, nullptr for tokens only the deadline cancels.
+        std::shared_ptr<detail::CancellationState> state;
+        std::chrono::steady_clock::time_point _deadline = std::chrono::steady_clock::time_point::max();
+
+        CancellationToken(std::shared_ptr<detail::CancellationState> shared, std::chrono::steady_clock::time_point deadline)
+            : state(std::move(shared)), _deadline(deadline) {}
+
+    public:
+        /// @brief Token that is never cancelled.
+        CancellationToken() = default;
+
+        /// @brief Check if the request was cancelled or its deadline passed. Reads the clock if the token has a deadline.
+        bool is_cancelled() const;
+        /// @brief Why the request was cancelled, CancellationReason::NONE while it is not.
+        CancellationReason reason() const;
+        /// @brief Throw RequestCancelledException if the request was cancelled, e.g. between the steps of a long computation.
+        void throw_if_cancelled() const;
+        /// @brief Time after which the request is cancelled, time_point::max() for none.
+        std::chrono::steady_clock::time_point deadline() const { return _deadline; }
+        /// @brief Check if the framework may cancel the token, and so call the callbacks of on_cancel().
+        bool can_be_cancelled() const { return state != nullptr; }
+        /// @brief Call a callback once the framework cancels the token, on the thread cancelling it, e.g. to abort a call to another service.
+        /// Called right away if the token is cancelled already, never if the framework cannot cancel it.
+        /// Callbacks stay registered until the request ends, so they must not keep the Request or Response alive.
+        void on_cancel(std::function<void()> callback) const;
+
+        friend class CancellationSource;
+    };
+}
+
+#endif // ENDERMAN_CANCELLATION_HPP
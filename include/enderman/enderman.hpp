@@ -20,18 +20,30 @@
 
 #include "types.hpp"
 #include "constants.hpp"
+#include "headers.hpp"
 #include "request.hpp"
 #include "response.hpp"
 #include "body.hpp"
+#include "stream_body.hpp"
+#include "spooled_body.hpp"
+#include "monitor.hpp"
+#include "route_options.hpp"
+#include "server_options.hpp"
+#include "loopback.hpp"
+#include "task.hpp"
 
 #include <functional>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 /// @brief All the functions and classes of the Enderman library are defined in this namespace.
 namespace enderman
 {
+    class ConstantRoutes;
+
     /// @brief Main class of the enderman framework. This class provides all the necessary functions to create a server, define routes and middlewares and start the server.
     class Enderman
     {
@@ -39,6 +51,11 @@ namespace enderman
         struct Impl;
         Impl *pImpl = nullptr;
 
+        /// @brief Run a request through the middlewares and route handlers. Entry point for transports.
+        void dispatch(Request &req, Response &res);
+        /// @brief Get the responses registered with constant(), which transports answer before building a request.
+        const ConstantRoutes &constant_routes() const;
+
     public:
         explicit Enderman();
         ~Enderman();
@@ -58,98 +75,202 @@ namespace enderman
         /// @param method HTTP method for which the route handler should be registered.
         /// @param path Path for which the route handler should be registered.
         /// @param handler Route handler function to be registered for the given HTTP method and path.
-        void on(const enderman::HttpMethod method, const std::string &path, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void on(const enderman::HttpMethod method, const std::string &path, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
         /// @brief Register a route handler for the given HTTP method and multiple paths
         /// @param method HTTP method for which the route handler should be registered.
         /// @param paths Vector of all paths for which the route handler should be registered.
         /// @param handler Route handler function to be registered for the given HTTP method and paths.
-        void on(const enderman::HttpMethod method, const std::vector<std::string> &paths, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void on(const enderman::HttpMethod method, const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
         /// @brief Register a route handler for the given HTTP methods and path
         /// @param methods Vector of HTTP methods for which the route handler should be registered.
         /// @param path Path for which the route handler should be registered.
         /// @param handler Route handler function to be registered for the given HTTP methods and path.
-        void on(const std::vector<enderman::HttpMethod> &methods, const std::string &path, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void on(const std::vector<enderman::HttpMethod> &methods, const std::string &path, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
         /// @brief Register a route handler for the given HTTP methods and multiple paths
         /// @param methods Vector of HTTP methods for which the route handler should be registered.
         /// @param paths Vector of all paths for which the route handler should be registered.
         /// @param handler Route handler function to be registered for the given HTTP methods and paths.
-        void on(const std::vector<enderman::HttpMethod> &methods, const std::vector<std::string> &paths, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void on(const std::vector<enderman::HttpMethod> &methods, const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
 
         /// @brief Register a route handler for GET method and the given path
         /// @param path Path for which the route handler should be registered.
         /// @param handler Route handler function to be registered for the GET method and the given path.
-        void get(const std::string &path, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void get(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
         /// @brief Register a route handler for GET method and multiple paths
         /// @param paths Vector of all paths for which the route handler should be registered for GET method.
         /// @param handler Route handler function to be registered for GET method and the given paths
-        void get(const std::vector<std::string> &paths, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void get(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
 
         /// @brief Register a route handler for POST method and the given path
         /// @param path Path for which the route handler should be registered.
         /// @param handler Route handler function to be registered for the POST method and the given path.
-        void post(const std::string &path, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void post(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
         /// @brief Register a route handler for POST method and multiple paths
         /// @param paths Vector of all paths for which the route handler should be registered for POST method.
         /// @param handler Route handler function to be registered for POST method and the given paths
-        void post(const std::vector<std::string> &paths, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void post(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
 
         /// @brief Register a route handler for PUT method and the given path
         /// @param path Path for which the route handler should be registered.
         /// @param handler Route handler function to be registered for the PUT method and the given path.
-        void put(const std::string &path, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void put(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
         /// @brief Register a route handler for PUT method and multiple paths
         /// @param paths Vector of all paths for which the route handler should be registered for PUT method.
         /// @param handler Route handler function to be registered for PUT method and the given paths
-        void put(const std::vector<std::string> &paths, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void put(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
 
         /// @brief Register a route handler for DELETE method and the given path
         /// @param path Path for which the route handler should be registered.
         /// @param handler Route handler function to be registered for the DELETE method and the given path.
-        void del(const std::string &path, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void del(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
         /// @brief Register a route handler for DELETE method and multiple paths
         /// @param paths Vector of all paths for which the route handler should be registered for DELETE method.
         /// @param handler Route handler function to be registered for DELETE method and the given paths
-        void del(const std::vector<std::string> &paths, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void del(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
 
         /// @brief Register a route handler for PATCH method and the given path
         /// @param path Path for which the route handler should be registered.
         /// @param handler Route handler function to be registered for the PATCH method and the given path.
-        void patch(const std::string &path, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void patch(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
         /// @brief Register a route handler for PATCH method and multiple paths
         /// @param paths Vector of all paths for which the route handler should be registered for PATCH method.
         /// @param handler Route handler function to be registered for PATCH method and the given paths
-        void patch(const std::vector<std::string> &paths, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void patch(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
 
         /// @brief Register a route handler for OPTIONS method and the given path
         /// @param path Path for which the route handler should be registered.
         /// @param handler Route handler function to be registered for the OPTIONS method and the given path.
-        void options(const std::string &path, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void options(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
         /// @brief Register a route handler for OPTIONS method and multiple paths
         /// @param paths Vector of all paths for which the route handler should be registered for OPTIONS method.
         /// @param handler Route handler function to be registered for OPTIONS method and the given paths
-        void options(const std::vector<std::string> &paths, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void options(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
 
         /// @brief Register a route handler for HEAD method and the given path
         /// @param path Path for which the route handler should be registered.
         /// @param handler Route handler function to be registered for the HEAD method and the given path.
-        void head(const std::string &path, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void head(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
         /// @brief Register a route handler for HEAD method and multiple paths
         /// @param paths Vector of all paths for which the route handler should be registered for HEAD method.
         /// @param handler Route handler function to be registered for HEAD method and the given paths
-        void head(const std::vector<std::string> &paths, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void head(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
 
         /// @brief Register a route handler for all methods on the given path
         /// @param path Path for which the route handler should be registered.
         /// @param handler Route handler function to be registered for all methods and the given path.
-        void any(const std::string &path, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void any(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
         /// @brief Register a route handler for all methods on multiple paths
         /// @param paths Vector of all paths for which the route handler should be registered for all methods.
         /// @param handler Route handler function to be registered for all methods and the given paths.
-        void any(const std::vector<std::string> &paths, RouteHandlerFunction handler);
+        /// @param options Settings of the route, see RouteOptions.
+        void any(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
+
+        /// @brief Register a route handler that finishes after it returns. It calls its completion once the response is ready, from any thread.
+        /// On the server loops the connection waits for the completion while the loop serves other connections; other transports block until it is called.
+        /// @param method HTTP method for which the route handler should be registered.
+        /// @param path Path for which the route handler should be registered.
+        /// @param handler Asynchronous route handler to be registered for the given HTTP method and path.
+        /// @param options Settings of the route, see RouteOptions.
+        void on_async(const enderman::HttpMethod method, const std::string &path, AsyncRouteHandlerFunction handler, const RouteOptions &options = RouteOptions());
+
+        /// Overloads for asynchronous route handlers, e.g. coroutines returning Task<void>. They are chosen for handlers whose result type has an AsyncHandlerTraits specialization.
+        template <typename Handler>
+        using AsyncResult = std::enable_if_t<AsyncHandlerTraits<std::invoke_result_t<Handler &, Request &, Response &>>::supported>;
+
+        /// @brief Register an asynchronous route handler, e.g. a coroutine returning Task<void>, for the given HTTP method and path.
+        template <typename Handler, typename = AsyncResult<Handler>>
+        void on(const enderman::HttpMethod method, const std::string &path, Handler handler, const RouteOptions &options = RouteOptions())
+        {
+            using Traits = AsyncHandlerTraits<std::invoke_result_t<Handler &, Request &, Response &>>;
+            on_async(method, path, Traits::adapt(std::move(handler)), options);
+        }
+        /// @brief Register an asynchronous route handler for GET method and the given path.
+        template <typename Handler, typename = AsyncResult<Handler>>
+        void get(const std::string &path, Handler handler, const RouteOptions &options = RouteOptions()) { on(enderman::HttpMethod::GET, path, std::move(handler), options); }
+        /// @brief Register an asynchronous route handler for POST method and the given path.
+        template <typename Handler, typename = AsyncResult<Handler>>
+        void post(const std::string &path, Handler handler, const RouteOptions &options = RouteOptions()) { on(enderman::HttpMethod::POST, path, std::move(handler), options); }
+        /// @brief Register an asynchronous route handler for PUT method and the given path.
+        template <typename Handler, typename = AsyncResult<Handler>>
+        void put(const std::string &path, Handler handler, const RouteOptions &options = RouteOptions()) { on(enderman::HttpMethod::PUT, path, std::move(handler), options); }
+        /// @brief Register an asynchronous route handler for DELETE method and the given path.
+        template <typename Handler, typename = AsyncResult<Handler>>
+        void del(const std::string &path, Handler handler, const RouteOptions &options = RouteOptions()) { on(enderman::HttpMethod::DELETE, path, std::move(handler), options); }
+        /// @brief Register an asynchronous route handler for PATCH method and the given path.
+        template <typename Handler, typename = AsyncResult<Handler>>
+        void patch(const std::string &path, Handler handler, const RouteOptions &options = RouteOptions()) { on(enderman::HttpMethod::PATCH, path, std::move(handler), options); }
+        /// @brief Register an asynchronous route handler for OPTIONS method and the given path.
+        template <typename Handler, typename = AsyncResult<Handler>>
+        void options(const std::string &path, Handler handler, const RouteOptions &options = RouteOptions()) { on(enderman::HttpMethod::OPTIONS, path, std::move(handler), options); }
+        /// @brief Register an asynchronous route handler for HEAD method and the given path.
+        template <typename Handler, typename = AsyncResult<Handler>>
+        void head(const std::string &path, Handler handler, const RouteOptions &options = RouteOptions()) { on(enderman::HttpMethod::HEAD, path, std::move(handler), options); }
+        /// @brief Register an asynchronous route handler for all methods on the given path.
+        template <typename Handler, typename = AsyncResult<Handler>>
+        void any(const std::string &path, Handler handler, const RouteOptions &options = RouteOptions())
+        {
+            using Traits = AsyncHandlerTraits<std::invoke_result_t<Handler &, Request &, Response &>>;
+            AsyncRouteHandlerFunction adapted = Traits::adapt(std::move(handler));
+            for (HttpMethod method : {HttpMethod::GET, HttpMethod::POST, HttpMethod::PUT, HttpMethod::DELETE, HttpMethod::PATCH, HttpMethod::OPTIONS, HttpMethod::HEAD})
+                on_async(method, path, adapted, options);
+        }
+
+        /// @brief Register a constant response, e.g. for health checks, robots.txt or fixed JSON answers.
+        /// The whole message is rendered once here. Matching requests are answered with those bytes before a Request is built,
+        /// without running middlewares. Paths are normalized like for routes first, so /health/ and /./health get the response of /health too.
+        /// The response is also registered as a regular route, for transports without the shortcut. It replaces an earlier constant or route for the same method and path.
+        /// @param method HTTP method to answer.
+        /// @param path Exact path to answer. Path parameters and wildcards are not allowed.
+        /// @param status Status code of the response.
+        /// @param headers Headers of the response. Content-Length is set by the framework; Content-Type defaults to application/octet-stream if the body is not empty.
+        /// Connection headers other than Connection: close, which closes the connection after the response, are left to the transport.
+        /// @param body Body of the response.
+        /// @throws std::invalid_argument if the path has parameters or wildcards.
+        void constant(const enderman::HttpMethod method,
+                      const std::string &path,
+                      int status,
+                      const std::vector<std::pair<std::string, std::string>> &headers = {},
+                      const std::string &body = "");
+
+        /// @brief Set the options used for the fields routes leave at 0, e.g. an application wide request body limit.
+        /// Applies to every route, including routes registered before, and to requests that match no route.
+        /// @param defaults Default route options.
+        void route_defaults(const RouteOptions &defaults);
+
+        /// @brief Enable the server loop monitor. Call it before listen().
+        /// The monitor measures loop lag, queue depth, dispatch delay and handler time, and calls config.on_threshold when a threshold is crossed.
+        /// @param config Sampling interval, thresholds and callback of the monitor.
+        void monitor(const LoopMonitorConfig &config);
+        /// @brief Get the statistics of the server loop monitor. All values are zero if monitor() was not called.
+        /// @return Snapshot of the loop statistics.
+        LoopStats loop_stats() const;
 
         /// @brief Start listening for incoming connections on the given port
         /// @param port Port number on which the server should listen for incoming connections.
-        void listen(const unsigned short port);
+        /// @param options Settings of the server, e.g. the number of server loops, connection limits and timeouts. See ServerOptions.
+        /// @throws std::invalid_argument if the options are invalid.
+        void listen(const unsigned short port, const ServerOptions &options = ServerOptions());
+
+        friend class Loopback;
     };
 }
 
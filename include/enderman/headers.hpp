@@ -0,0 +1,326 @@
+/// @file headers.hpp
+/// @brief Defines the Headers class, a flat list of request headers viewing memory owned by the transport or by the Request,
+/// @brief with constant time access to well known headers, and the MediaType parser for Content-Type values.
+
+#ifndef ENDERMAN_HEADERS_HPP
+#define ENDERMAN_HEADERS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace enderman
+{
+    /// @brief Headers the framework and its plugins look up on most requests. Indexed when a request is built, so looking them up does not scan the headers.
+    enum class WellKnownHeader : uint8_t
+    {
+        ACCEPT,
+        ACCEPT_ENCODING,
+        ACCESS_CONTROL_REQUEST_HEADERS,
+        ACCESS_CONTROL_REQUEST_METHOD,
+        AUTHORIZATION,
+        CACHE_CONTROL,
+        CONNECTION,
+        CONTENT_LENGTH,
+        CONTENT_TYPE,
+        COOKIE,
+        HOST,
+        IF_MODIFIED_SINCE,
+        IF_NONE_MATCH,
+        ORIGIN,
+        RANGE,
+        REFERER,
+        TRANSFER_ENCODING,
+        USER_AGENT,
+        X_FORWARDED_FOR,
+        X_REQUEST_ID,
+        COUNT
+    };
+
+    /// @brief Get the lowercase name of a well known header.
+    /// @param header Well known header, not COUNT.
+    /// @return Lowercase header name, e.g. "content-type".
+    inline std::string_view well_known_header_name(WellKnownHeader header)
+    {
+        static constexpr std::string_view names[] = {
+            "accept",
+            "accept-encoding",
+            "access-control-request-headers",
+            "access-control-request-method",
+            "authorization",
+            "cache-control",
+            "connection",
+            "content-length",
+            "content-type",
+            "cookie",
+            "host",
+            "if-modified-since",
+            "if-none-match",
+            "origin",
+            "range",
+            "referer",
+            "transfer-encoding",
+            "user-agent",
+            "x-forwarded-for",
+            "x-request-id",
+        };
+        static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(WellKnownHeader::COUNT), "Every well known header needs a name");
+        return names[static_cast<size_t>(header)];
+    }
+
+    /// @brief Headers of a request as name/value views, in the order they were received.
+    /// Names are compared case-insensitively. A Headers object does not own the characters it refers to;
+    /// the Request holding it keeps them alive, see Request::retain().
+    /// The list itself is allocated from a memory resource, the per-request arena for requests built by the framework.
+    class Headers
+    {
+    public:
+        using value_type = std::pair<std::string_view, std::string_view>;
+        using const_iterator = std::pmr::vector<value_type>::const_iterator;
+
+        /// @brief Compare two strings ignoring ASCII case.
+        static bool equals_ignore_case(std::string_view a, std::string_view b)
+        {
+            if (a.size() != b.size())
+                return false;
+            for (size_t i = 0; i < a.size(); ++i)
+            {
+                char x = a[i];
+                char y = b[i];
+                if (x >= 'A' && x <= 'Z')
+                    x = static_cast<char>(x - 'A' + 'a');
+                if (y >= 'A' && y <= 'Z')
+                    y = static_cast<char>(y - 'A' + 'a');
+                if (x != y)
+                    return false;
+            }
+            return true;
+        }
+
+        /// @brief Classify a header name.
+        /// @param name Header name in any case.
+        /// @return The well known header with this name or WellKnownHeader::COUNT if there is none.
+        static WellKnownHeader classify(std::string_view name)
+        {
+            for (size_t i = 0; i < static_cast<size_t>(WellKnownHeader::COUNT); ++i)
+            {
+                auto header = static_cast<WellKnownHeader>(i);
+                std::string_view known = well_known_header_name(header);
+                if (known.size() == name.size() && equals_ignore_case(known, name))
+                    return header;
+            }
+            return WellKnownHeader::COUNT;
+        }
+
+    private:
+        static constexpr uint16_t NOT_PRESENT = UINT16_MAX;
+
+        std::pmr::vector<value_type> entries;
+        /// @brief Position of the first occurrence of every well known header in entries.
+        std::array<uint16_t, static_cast<size_t>(WellKnownHeader::COUNT)> index = make_empty_index();
+
+        static constexpr std::array<uint16_t, static_cast<size_t>(WellKnownHeader::COUNT)> make_empty_index()
+        {
+            std::array<uint16_t, static_cast<size_t>(WellKnownHeader::COUNT)> empty{};
+            for (auto &position : empty)
+                position = NOT_PRESENT;
+            return empty;
+        }
+
+        friend class Request;
+
+    public:
+        Headers() = default;
+        /// @brief Create empty headers allocating from a memory resource.
+        /// @param resource Resource the header list is allocated from. Must outlive the Headers object.
+        explicit Headers(std::pmr::memory_resource *resource) : entries(resource) {}
+        /// @brief Copy headers. The copy is allocated from the default resource, whatever the source uses.
+        Headers(const Headers &other) = default;
+        Headers(Headers &&other) noexcept = default;
+        Headers &operator=(const Headers &other) = default;
+        /// @brief Move headers. Unlike std::pmr containers, the target takes over the memory resource of the source,
+        /// so that moving headers out of an arena never copies them and moving them back in never leaves them in the arena.
+        Headers &operator=(Headers &&other) noexcept
+        {
+            if (this != &other)
+            {
+                entries.~vector();
+                new (&entries) std::pmr::vector<value_type>(std::move(other.entries));
+                index = other.index;
+            }
+            return *this;
+        }
+
+        /// @brief Create headers viewing the entries of a container of string pairs, e.g. a std::map or std::unordered_map.
+        /// @param container Container to view. Must outlive the Headers object or be retained by the owning Request.
+        /// @param resource Resource the header list is allocated from.
+        template <typename Container>
+        static Headers view(const Container &container, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        {
+            Headers headers(resource);
+            headers.entries.reserve(container.size());
+            for (const auto &entry : container)
+                headers.add(entry.first, entry.second);
+            return headers;
+        }
+
+        /// @brief Append a header. The characters are not copied.
+        void add(std::string_view name, std::string_view value)
+        {
+            WellKnownHeader header = classify(name);
+            if (header != WellKnownHeader::COUNT && index[static_cast<size_t>(header)] == NOT_PRESENT && entries.size() < NOT_PRESENT)
+                index[static_cast<size_t>(header)] = static_cast<uint16_t>(entries.size());
+            entries.emplace_back(name, value);
+        }
+
+        /// @brief Find a well known header in constant time.
+        /// @param header Well known header.
+        /// @return Iterator to the first header of this kind or end() if not found.
+        const_iterator find(WellKnownHeader header) const
+        {
+            uint16_t position = index[static_cast<size_t>(header)];
+            return position == NOT_PRESENT ? entries.end() : entries.begin() + position;
+        }
+        /// @brief Find the first header with the given name. Well known names are looked up in constant time.
+        /// @param name Header name, compared case-insensitively.
+        /// @return Iterator to the header or end() if not found.
+        const_iterator find(std::string_view name) const
+        {
+            WellKnownHeader header = classify(name);
+            if (header != WellKnownHeader::COUNT)
+                return find(header);
+            for (auto it = entries.begin(); it != entries.end(); ++it)
+            {
+                if (equals_ignore_case(it->first, name))
+                    return it;
+            }
+            return entries.end();
+        }
+        /// @brief Get the value of a header.
+        /// @param name Header name, compared case-insensitively.
+        /// @return Value of the first header with the name.
+        /// @throws std::out_of_range if the header is not present.
+        std::string_view at(std::string_view name) const
+        {
+            auto it = find(name);
+            if (it == entries.end())
+                throw std::out_of_range("Header not found: " + std::string(name));
+            return it->second;
+        }
+        /// @brief Get the value of a well known header.
+        /// @throws std::out_of_range if the header is not present.
+        std::string_view at(WellKnownHeader header) const
+        {
+            auto it = find(header);
+            if (it == entries.end())
+                throw std::out_of_range("Header not found: " + std::string(well_known_header_name(header)));
+            return it->second;
+        }
+        /// @brief Get the value of a header or a fallback.
+        /// @param name Header name, compared case-insensitively.
+        /// @param fallback Value returned if the header is not present.
+        std::string_view get(std::string_view name, std::string_view fallback = std::string_view()) const
+        {
+            auto it = find(name);
+            return it == entries.end() ? fallback : it->second;
+        }
+        /// @brief Get the value of a well known header or a fallback.
+        std::string_view get(WellKnownHeader header, std::string_view fallback = std::string_view()) const
+        {
+            auto it = find(header);
+            return it == entries.end() ? fallback : it->second;
+        }
+        bool contains(std::string_view name) const { return find(name) != entries.end(); }
+        bool contains(WellKnownHeader header) const { return index[static_cast<size_t>(header)] != NOT_PRESENT; }
+        size_t count(std::string_view name) const
+        {
+            size_t n = 0;
+            for (const auto &entry : entries)
+                n += equals_ignore_case(entry.first, name) ? 1 : 0;
+            return n;
+        }
+
+        const_iterator begin() const { return entries.begin(); }
+        const_iterator end() const { return entries.end(); }
+        size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+    };
+
+    /// @brief Parsed media type of a Content-Type value such as "application/json; charset=utf-8".
+    /// All parts are views into the header value and keep the case they were received in.
+    struct MediaType
+    {
+        /// @brief Type and subtype without parameters, e.g. "application/json". Empty if there is no Content-Type.
+        std::string_view essence;
+        std::string_view type;
+        std::string_view subtype;
+        /// @brief Everything after the first ';', e.g. "charset=utf-8".
+        std::string_view parameters;
+
+        /// @brief Parse a Content-Type value. Malformed values give an essence without subtype.
+        static MediaType parse(std::string_view value)
+        {
+            MediaType media_type;
+            size_t semicolon = value.find(';');
+            media_type.essence = trim(value.substr(0, semicolon));
+            if (semicolon != std::string_view::npos)
+                media_type.parameters = trim(value.substr(semicolon + 1));
+            size_t slash = media_type.essence.find('/');
+            media_type.type = media_type.essence.substr(0, slash);
+            if (slash != std::string_view::npos)
+                media_type.subtype = media_type.essence.substr(slash + 1);
+            return media_type;
+        }
+
+        bool empty() const { return essence.empty(); }
+
+        /// @brief Check the media type against a pattern ignoring case, e.g. "application/json" or "text/*".
+        bool matches(std::string_view pattern) const
+        {
+            if (pattern.size() >= 2 && pattern.substr(pattern.size() - 2) == "/*")
+                return Headers::equals_ignore_case(type, pattern.substr(0, pattern.size() - 2));
+            return Headers::equals_ignore_case(essence, pattern);
+        }
+
+        /// @brief Get a parameter of the media type, e.g. parameter("charset").
+        /// @param name Parameter name, compared case-insensitively.
+        /// @return Value without surrounding quotes, empty if the parameter is not present.
+        std::string_view parameter(std::string_view name) const
+        {
+            std::string_view rest = parameters;
+            while (!rest.empty())
+            {
+                size_t end = rest.find(';');
+                std::string_view item = trim(rest.substr(0, end));
+                rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+                size_t eq = item.find('=');
+                if (eq == std::string_view::npos || !Headers::equals_ignore_case(trim(item.substr(0, eq)), name))
+                    continue;
+                std::string_view value = trim(item.substr(eq + 1));
+                if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+                    value = value.substr(1, value.size() - 2);
+                return value;
+            }
+            return std::string_view();
+        }
+
+    private:
+        static std::string_view trim(std::string_view value)
+        {
+            size_t start = value.find_first_not_of(" \t");
+            if (start == std::string_view::npos)
+                return std::string_view();
+            size_t end = value.find_last_not_of(" \t");
+            return value.substr(start, end - start + 1);
+        }
+    };
+}
+
+#endif // ENDERMAN_HEADERS_HPP
@@ -0,0 +1,90 @@
+/// @file loopback.hpp
+/// @brief Defines the in-process loopback transport, which runs requests through an application without sockets.
+/// @brief Useful for benchmarking the framework itself and for testing applications.
+
+#ifndef ENDERMAN_LOOPBACK_HPP
+#define ENDERMAN_LOOPBACK_HPP
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <stdexcept>
+
+namespace enderman
+{
+    class Enderman;
+
+    /// @brief Request handed to the loopback transport.
+    struct LoopbackRequest
+    {
+        /// @brief HTTP method as it appears on the request line, e.g. "GET".
+        std::string method = "GET";
+        /// @brief Raw URI including the query string. Still URL encoded.
+        std::string uri = "/";
+        /// @brief Headers of the request. Names are matched case-insensitively, so each name must appear only once, in any case.
+        std::unordered_map<std::string, std::string> headers;
+        /// @brief Body of the request.
+        std::vector<char> body;
+        /// @brief IP of the simulated client.
+        std::string ip = "127.0.0.1";
+        /// @brief Port of the simulated client.
+        std::string port = "0";
+    };
+
+    /// @brief Response produced by the loopback transport.
+    struct LoopbackResponse
+    {
+        int status_code = 0;
+        std::string status_message;
+        /// @brief Headers in the order they are written on the wire.
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::vector<char> body;
+
+        /// @brief Find the value of a header. Header names are compared case-insensitively.
+        /// @param name Name of the header.
+        /// @return Pointer to the value or nullptr if the header is not present.
+        const std::string *header(const std::string &name) const;
+        /// @brief Serialize the response as an HTTP/1.1 message.
+        /// @return Status line, headers and body.
+        std::string serialize() const;
+    };
+
+    /// @brief Transport that runs requests through an application in memory.
+    /// Requests go through exactly the same conversion, middleware and routing code as the network transport.
+    class Loopback
+    {
+    private:
+        Enderman &app;
+
+    public:
+        /// @brief Create a loopback transport for an application. Routes and middlewares may still be registered afterwards.
+        /// @param application Application to dispatch requests to. Must outlive the Loopback.
+        explicit Loopback(Enderman &application) : app(application) {}
+
+        /// @brief Run a request through the application.
+        /// @param request Request to dispatch.
+        /// @return Response produced by the application.
+        LoopbackResponse dispatch(const LoopbackRequest &request);
+        /// @brief Run a raw HTTP/1.1 request message through the application.
+        /// @param raw Request line, headers and body, e.g. "GET / HTTP/1.1\r\nHost: x\r\n\r\n".
+        /// @return Serialized response message, written into a single buffer the way a socket transport writes it. Always framed by Content-Length; responses to HEAD requests have no body.
+        /// @throws MalformedRequestException if the message cannot be parsed.
+        std::string dispatch_raw(const std::string &raw);
+
+        /// @brief Parse a raw HTTP/1.1 request message. The body is delimited by Content-Length or chunked transfer encoding.
+        /// @param raw Request line, headers and body.
+        /// @return Parsed request with lowercase header names.
+        /// @throws MalformedRequestException if the message cannot be parsed.
+        static LoopbackRequest parse_request(const std::string &raw);
+
+        class MalformedRequestException : public std::runtime_error
+        {
+        public:
+            explicit MalformedRequestException(const std::string &message)
+                : std::runtime_error(message) {}
+        };
+    };
+}
+
+#endif // ENDERMAN_LOOPBACK_HPP
@@ -0,0 +1,79 @@
+/// @file monitor.hpp
+/// @brief Defines the configuration and statistics of the server loop monitor in the Enderman library.
+
+#ifndef ENDERMAN_MONITOR_HPP
+#define ENDERMAN_MONITOR_HPP
+
+#include "route_options.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+namespace enderman
+{
+    /// @brief Queueing statistics of one priority class of the server loops. Interval values cover the last completed monitor interval.
+    struct PriorityStats
+    {
+        /// @brief Requests of the class currently waiting for dispatch.
+        size_t queued = 0;
+        /// @brief Requests of the class dispatched during the last interval.
+        unsigned long long dispatched = 0;
+        /// @brief Average time requests of the class waited for dispatch during the last interval.
+        std::chrono::nanoseconds avg_queue_delay{0};
+        /// @brief Time within which 99% of the requests of the class were dispatched during the last interval, rounded up to a power of two microseconds.
+        std::chrono::nanoseconds p99_queue_delay{0};
+        /// @brief Highest time a request of the class waited for dispatch during the last interval.
+        std::chrono::nanoseconds max_queue_delay{0};
+    };
+
+    /// @brief Snapshot of the health of the server loop.
+    /// Interval values (peak, max and avg) cover the last completed monitor interval, the other values are current.
+    struct LoopStats
+    {
+        /// @brief Total number of requests received since the server started.
+        unsigned long long requests = 0;
+        /// @brief Total number of requests the server loops answered with 503 to shed load, see ServerOptions::shed_target. They are not counted in requests.
+        unsigned long long shed_requests = 0;
+        /// @brief Number of requests handed over by the transport whose response is not written yet, summed over all loops.
+        size_t queue_depth = 0;
+        /// @brief Highest queue depth seen during the last interval.
+        size_t peak_queue_depth = 0;
+        /// @brief How long the busiest loop has been processing its current request on its own thread. Every request arriving on that loop now waits at least this long.
+        /// Asynchronous handlers count until they suspend, offloaded handlers not at all.
+        std::chrono::nanoseconds loop_lag{0};
+        /// @brief Highest loop lag seen on any loop during the last interval.
+        std::chrono::nanoseconds max_loop_lag{0};
+        /// @brief How late the monitor timer fired at the end of the last interval. Grows when the host is CPU saturated.
+        std::chrono::nanoseconds timer_drift{0};
+        /// @brief Average time from request arrival to the start of its route handler during the last interval.
+        std::chrono::nanoseconds avg_dispatch_delay{0};
+        /// @brief Highest time from request arrival to the start of its route handler during the last interval.
+        std::chrono::nanoseconds max_dispatch_delay{0};
+        /// @brief Average run time of route handlers during the last interval.
+        std::chrono::nanoseconds avg_handler_time{0};
+        /// @brief Highest run time of route handlers during the last interval.
+        std::chrono::nanoseconds max_handler_time{0};
+        /// @brief Queueing statistics of the server loops by priority class, indexed by Priority. All zero on Http-Server.
+        std::array<PriorityStats, PRIORITY_CLASSES> priorities{};
+    };
+
+    /// @brief Configuration struct for the server loop monitor.
+    /// @param interval Interval at which the monitor samples the loop and computes statistics.
+    /// @param lag_threshold Loop lag at or above which on_threshold is called. Zero disables the check.
+    /// @param dispatch_delay_threshold Max dispatch delay at or above which on_threshold is called. Zero disables the check.
+    /// @param queue_depth_threshold Peak queue depth at or above which on_threshold is called. Zero disables the check.
+    /// @param on_threshold Called from the monitor thread with the current statistics each interval a threshold is crossed.
+    /// It runs even while the loop is stuck, so it must not wait for the loop.
+    struct LoopMonitorConfig
+    {
+        std::chrono::milliseconds interval{100};
+        std::chrono::milliseconds lag_threshold{100};
+        std::chrono::milliseconds dispatch_delay_threshold{100};
+        size_t queue_depth_threshold = 0;
+        std::function<void(const LoopStats &)> on_threshold;
+    };
+}
+
+#endif // ENDERMAN_MONITOR_HPP
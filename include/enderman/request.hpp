@@ -6,15 +6,22 @@
 
 #include "types.hpp"
 #include "constants.hpp"
+#include "headers.hpp"
+#include "body.hpp"
+#include "cancellation.hpp"
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <chrono>
 
 namespace enderman
 {
     /// @brief Request class represents an HTTP request received from the client.
+    /// The raw URI, the headers and the body are borrowed from the transport for the duration of the exchange instead of being copied.
+    /// A handler that keeps the request, or views into it, beyond its own return must call retain() or copy the Request; copies always own their data.
     class Request
     {
     private:
@@ -27,11 +34,13 @@ namespace enderman
         HttpMethod _method;
 
         /// @brief Raw URI of the request as received from the client, including path and query string. Still URL encoded.
-        std::string _raw_uri;
+        std::string_view _raw_uri;
         /// @brief Base path of the request, URL decoded and normalized. Fixed for all middlewares and handlers.
         std::string _base_path;
         /// @brief Path of the request relative to the prefix path of the matched route. URL decoded and normalized.
         std::string _relative_path;
+        /// @brief Path pattern of the route matching the request, e.g. /users/:id. Empty if no route matches.
+        std::string _route;
         /// @brief Vector of path segments in the base path, URL decoded and normalized.
         std::vector<std::string> _base_path_segments;
         /// @brief Vector of path segments in the relative path, URL decoded and normalized.
@@ -41,30 +50,70 @@ namespace enderman
         /// @brief query parameters extracted from the URI. URL decoded.
         std::unordered_map<std::string, std::string> _query_params;
 
-        /// @brief headers of the request. Header names are normalized to lowercase. Header values are not modified.
-        const std::unordered_map<std::string, std::string> _headers;
+        /// @brief headers of the request. Header names are compared case-insensitively. Header values are not modified.
+        Headers _headers;
+
+        /// @brief Characters of the raw URI and the headers once they are owned by the request. Never reallocated after retain(), so moving the request keeps the views valid.
+        std::vector<char> _storage;
+        /// @brief True while the raw URI and the headers view memory of the transport.
+        bool _borrowed = false;
+        /// @brief Content-Type parsed on first use by media_type().
+        mutable MediaType _media_type;
+        mutable bool _media_type_parsed = false;
+
+        /// @brief Time at which the transport handed the request over to the framework.
+        std::chrono::steady_clock::time_point _received_at;
+        /// @brief Deadline and cancellation of the request, set by the framework before the middlewares run.
+        CancellationToken _cancellation;
+        /// @brief True once the transport or the framework set the cancellation, so it is resolved once per request.
+        bool _cancellation_set = false;
 
         /// @brief Request Body as a shared pointer to an object of a class that inherits from Body. Initially if request has no body, it is set to nullptr and if request has a body, it is set to a shared pointer to a RawBody object containing the raw body data.
         std::shared_ptr<Body> body;
 
+        /// @brief Empty request, filled by RequestBuilder::reset(). Used for the requests the framework reuses across exchanges.
+        Request() : _method(HttpMethod::GET) {}
+
     public:
-        /// @brief Constructor for Request class.
+        /// @brief Constructor for Request class. The raw URI and headers are copied into the request.
         /// @param ip IP address of the client in x.x.x.x format.
         /// @param port Port number from which the client has sent the request.
         /// @param method HTTP method of the request as an HttpMethod enum value.
         /// @param raw_uri Raw URI of the request as received from the client, including path and query string. Still URL encoded.
-        /// @param headers Headers of the request. Normalize header names to lowercase before passing to this constructor.
+        /// @param headers Headers of the request.
         Request(const std::string &ip,
                 const std::string &port,
                 const HttpMethod method,
                 const std::string &raw_uri,
                 const std::unordered_map<std::string, std::string> &headers)
+            : Request(ip, port, method, std::string_view(raw_uri), Headers::view(headers))
+        {
+            retain();
+        }
+        /// @brief Constructor for Request class borrowing the raw URI and the headers.
+        /// @param ip IP address of the client in x.x.x.x format.
+        /// @param port Port number from which the client has sent the request.
+        /// @param method HTTP method of the request as an HttpMethod enum value.
+        /// @param raw_uri Raw URI of the request. The characters must stay valid until the request is destroyed or retained.
+        /// @param headers Headers of the request. The characters must stay valid until the request is destroyed or retained.
+        Request(const std::string &ip,
+                const std::string &port,
+                const HttpMethod method,
+                std::string_view raw_uri,
+                Headers headers)
             : _ip(ip),
               _port(port),
               _method(method),
-              _headers(headers),
-              _raw_uri(raw_uri) {}
+              _raw_uri(raw_uri),
+              _headers(std::move(headers)),
+              _borrowed(true),
+              _received_at(std::chrono::steady_clock::now()) {}
 
+        /// @brief Copy a request. The copy owns its raw URI, headers and body.
+        Request(const Request &other);
+        Request &operator=(const Request &other);
+        Request(Request &&other) = default;
+        Request &operator=(Request &&other) = default;
         ~Request() = default;
         /// @brief Get the IP address of the client
         /// @return IP address of the client in x.x.x.x format as std::string
@@ -76,14 +125,18 @@ namespace enderman
         /// @return HTTP method as an HttpMethod enum value.
         HttpMethod method() const { return _method; }
         /// @brief Get the raw URI of the request as received from the client, including path and query string. Still URL encoded.
-        /// @return Raw URI as a string.
-        const std::string &raw_uri() const { return _raw_uri; }
+        /// @return Raw URI as a view, valid as long as the request.
+        std::string_view raw_uri() const { return _raw_uri; }
         /// @brief Get the base path of the request, URL decoded and normalized. Fixed for all middlewares and handlers.
         /// @return Base path as a string.
         const std::string &base_path() const { return _base_path; }
         /// @brief Get the path of the request relative to the prefix path of the matched route. URL decoded and normalized.
         /// @return Relative path as a string.
         const std::string &relative_path() const { return _relative_path; }
+        /// @brief Get the path pattern of the route matching the method and the base path, as registered, e.g. /users/:id.
+        /// Set before the middlewares run, so they can group requests by route instead of by path, e.g. for metrics.
+        /// @return Route pattern, empty if no route matches the request.
+        const std::string &route() const { return _route; }
         /// @brief Get the vector of path segments in the base path, URL decoded and normalized.
         /// @return Vector of path segments in the base path.
         const std::vector<std::string> &base_path_segments() const { return _base_path_segments; }
@@ -96,9 +149,31 @@ namespace enderman
         /// @brief Get the query parameters extracted from the URI. URL decoded.
         /// @return Query parameters as an unordered map.
         const std::unordered_map<std::string, std::string> &query_params() const { return _query_params; }
-        /// @brief Get the headers of the request. Header names are normalized to lowercase. Header values are not modified.
-        /// @return Headers as an unordered map.
-        const std::unordered_map<std::string, std::string> &headers() const { return _headers; }
+        /// @brief Get the headers of the request. Header names are compared case-insensitively. Header values are not modified.
+        /// @return Headers, valid as long as the request.
+        const Headers &headers() const { return _headers; }
+        /// @brief Get the media type of the body from the Content-Type header. Parsed once per request, so body parsers can all check it cheaply.
+        /// @return Parsed media type, empty if the request has no Content-Type header. Valid as long as the request.
+        const MediaType &media_type() const
+        {
+            if (!_media_type_parsed)
+            {
+                _media_type = MediaType::parse(_headers.get(WellKnownHeader::CONTENT_TYPE));
+                _media_type_parsed = true;
+            }
+            return _media_type;
+        }
+        /// @brief Get the time at which the transport handed the request over to the framework.
+        /// @return Steady clock time point of arrival.
+        std::chrono::steady_clock::time_point received_at() const { return _received_at; }
+        /// @brief Get the time by which the client needs the response: its arrival plus the timeout of its route or the server,
+        /// shortened by the timeout the client asked for, see ServerOptions::timeout_header.
+        /// @return Steady clock time point, time_point::max() if the request has no deadline.
+        std::chrono::steady_clock::time_point deadline() const { return _cancellation.deadline(); }
+        /// @brief Get the cancellation of the request, cancelled once its deadline passes or its connection closes.
+        /// Long running middlewares and handlers check it, or await it in coroutine handlers, to stop working on a response nobody waits for.
+        /// @return Token, valid as long as the request; copy it to use it beyond.
+        const CancellationToken &cancellation() const { return _cancellation; }
         /// @brief Get the request body as a shared pointer to an object of a class that inherits from Body.
         /// @return Shared pointer to the request body.
         std::shared_ptr<Body> get_body() const { return body; }
@@ -108,6 +183,15 @@ namespace enderman
         /// @brief Check if the request has a body.
         /// @return True if the request has a body, false otherwise.
         bool has_body() const { return body != nullptr; }
+        /// @brief Open a reader consuming the request body chunk by chunk. Bodies spooled to a file are read from disk in chunks instead of being loaded at once.
+        /// @return Reader over the body; it returns no chunk if the request has no body. The request must outlive the reader.
+        std::unique_ptr<BodyReader> body_reader() const;
+        /// @brief Copy the borrowed raw URI, headers and body into the request, so that it stays valid after the exchange ended.
+        /// Cheap if the request already owns its data.
+        void retain();
+        /// @brief Check if the request still views memory of the transport.
+        /// @return True if the raw URI, the headers or a raw body are borrowed.
+        bool is_borrowed() const;
 
         friend class RequestBuilder;
     };
@@ -0,0 +1,103 @@
+/// @file route_options.hpp
+/// @brief Defines RouteOptions, the per-route settings accepted by Enderman::on() and the method shortcuts.
+
+#ifndef ENDERMAN_ROUTE_OPTIONS_HPP
+#define ENDERMAN_ROUTE_OPTIONS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+
+namespace enderman
+{
+    /// @brief Scheduling class of a route. The server loops queue complete requests by class and dispatch them by ServerOptions::scheduling,
+    /// so health checks and interactive calls keep their latency while bulk traffic overloads the server.
+    enum class Priority
+    {
+        HIGH,
+        NORMAL,
+        LOW,
+    };
+
+    /// @brief Number of Priority classes, e.g. for arrays indexed by static_cast<size_t>(priority).
+    constexpr size_t PRIORITY_CLASSES = 3;
+
+    /// @brief Lower case name of a priority class, e.g. "high".
+    inline const char *priority_name(Priority priority)
+    {
+        switch (priority)
+        {
+        case Priority::HIGH:
+            return "high";
+        case Priority::LOW:
+            return "low";
+        default:
+            return "normal";
+        }
+    }
+
+    /// @brief Settings of a route. Fields left at 0 or unset take the value set with Enderman::route_defaults().
+    /// @param max_body_size Largest request body accepted, in bytes. Larger requests are answered with 413 before any middleware or body parser runs. 0 for no limit.
+    /// @param spool_threshold Request bodies larger than this are kept in a temporary file instead of memory by transports that read bodies themselves. 0 to always keep them in memory.
+    /// @param offload Run the middlewares and the handler of the route on the offload executor instead of the server loop, for CPU heavy or blocking handlers.
+    /// The loop keeps serving its other connections meanwhile and writes the response once the handler is done. Takes effect with the server loops (ServerOptions::workers > 0);
+    /// Http-Server runs every handler on its own loop.
+    /// @param priority Scheduling class of the route's requests on the server loops, Priority::NORMAL if neither the route nor the defaults set one.
+    /// Http-Server runs requests in arrival order.
+    /// @param max_in_flight Bulkhead of the route: most of its requests whose handler runs at once, so a slow dependency behind one route cannot
+    /// take all handler capacity. Further requests wait for a slot, up to max_queued of them, and are answered with 503 beyond that. 0 for no limit.
+    /// Requests handled in place, on a server loop thread or Http-Server, never wait, since waiting would stall the thread; offload the route or make it asynchronous to queue them.
+    /// @param max_queued Requests waiting for a slot of the bulkhead.
+    /// @param bulkhead Name of a bulkhead shared by every route naming it, so a group of routes has one limit. Its limits are those of the first route naming it.
+    /// Empty for a bulkhead of the route alone.
+    /// @param timeout Time the route has to answer, from the arrival of the request, overriding ServerOptions::request_timeout. See Request::deadline().
+    /// 0 for the server's timeout.
+    struct RouteOptions
+    {
+        size_t max_body_size = 0;
+        size_t spool_threshold = 0;
+        bool offload = false;
+        std::optional<Priority> priority;
+        size_t max_in_flight = 0;
+        size_t max_queued = 0;
+        std::string bulkhead;
+        std::chrono::milliseconds timeout{0};
+
+        /// @brief Fill the fields left at 0 or unset from defaults.
+        /// @return Options with every unset field taken from defaults.
+        RouteOptions merged_with(const RouteOptions &defaults) const
+        {
+            RouteOptions merged = *this;
+            if (merged.max_body_size == 0)
+                merged.max_body_size = defaults.max_body_size;
+            if (merged.spool_threshold == 0)
+                merged.spool_threshold = defaults.spool_threshold;
+            merged.offload = merged.offload || defaults.offload;
+            if (!merged.priority)
+                merged.priority = defaults.priority;
+            if (merged.max_in_flight == 0)
+                merged.max_in_flight = defaults.max_in_flight;
+            if (merged.max_queued == 0)
+                merged.max_queued = defaults.max_queued;
+            if (merged.bulkhead.empty())
+                merged.bulkhead = defaults.bulkhead;
+            if (merged.timeout.count() == 0)
+                merged.timeout = defaults.timeout;
+            return merged;
+        }
+
+        /// @brief Scheduling class of the route's requests.
+        Priority priority_class() const { return priority.value_or(Priority::NORMAL); }
+    };
+
+    /// @brief Options of an offloaded route, e.g. app.get("/report", handler, enderman::offload).
+    inline const RouteOptions offload = []
+    {
+        RouteOptions options;
+        options.offload = true;
+        return options;
+    }();
+}
+
+#endif // ENDERMAN_ROUTE_OPTIONS_HPP
@@ -0,0 +1,101 @@
+/// @file server_options.hpp
+/// @brief Defines ServerOptions, the settings accepted by Enderman::listen().
+
+#ifndef ENDERMAN_SERVER_OPTIONS_HPP
+#define ENDERMAN_SERVER_OPTIONS_HPP
+
+#include "route_options.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace enderman
+{
+    /// @brief How a server loop picks the next queued request among the priority classes.
+    enum class SchedulingPolicy
+    {
+        /// @brief Always the most urgent class with a queued request.
+        STRICT,
+        /// @brief Classes take turns in proportion to ServerOptions::priority_weights.
+        WEIGHTED,
+    };
+
+    /// @brief Settings of the server started by Enderman::listen(). Checked with validate() and printed with describe() when the server starts.
+    /// @param workers Number of server loops. 0 runs the application on a single Http-Server loop.
+    /// 1 or more start that many independent loops on their own threads, each with its own listening socket bound with SO_REUSEPORT,
+    /// so the kernel spreads connections across them. All loops share the routes and middlewares, which must not be changed after listen().
+    /// @param backlog Length of the queue of connections waiting to be accepted, per listening socket. 0 for the transport default (128 for Http-Server, SOMAXCONN for the server loops).
+    /// @param max_connections Most connections open at once, split evenly across the server loops. Further connections wait in the backlog. 0 for the transport default (128 for Http-Server, no limit for the server loops).
+    /// @param idle_timeout How long a connection may stay silent while a request is being received or a response is being sent.
+    /// @param keep_alive_timeout How long a keep-alive connection may stay open between two requests. Server loops only; Http-Server uses idle_timeout.
+    /// @param max_requests_per_connection Requests served on a connection before it is closed, with Connection: close on the last response. 0 for no limit. Server loops only.
+    /// @param tcp_nodelay Disable Nagle's algorithm on accepted connections. Server loops only.
+    /// @param receive_buffer_size SO_RCVBUF of the connections in bytes, 0 for the system default. Server loops only.
+    /// @param send_buffer_size SO_SNDBUF of the connections in bytes, 0 for the system default. Server loops only.
+    /// @param defer_accept TCP_DEFER_ACCEPT: wake up the loop for a new connection only once it sent data, waiting at most this long. 0 to disable. Server loops only.
+    /// @param fastopen_queue TCP_FASTOPEN: length of the queue of pending TCP Fast Open requests, 0 to disable. Server loops only.
+    /// @param offload_threads Workers of the executor running offloaded routes, see RouteOptions::offload. 0 for one per hardware thread.
+    /// The executor is only started if a route is offloaded. Server loops only.
+    /// @param stream_threads Threads running the StreamBody producers that could get ahead of their client, so that waiting for a slow client never holds up a loop.
+    /// Such a producer holds its thread until its body is written; further streams wait for a free thread before their head is sent. 0 for one per hardware thread. Server loops only.
+    /// @param scheduling How the server loops pick among complete requests of different RouteOptions::priority classes. Server loops only.
+    /// @param priority_weights Share of the dispatches each class gets under SchedulingPolicy::WEIGHTED while all are queued, indexed by Priority.
+    /// @param starvation_timeout A request queued longer than this is dispatched before more urgent classes, so low priority requests are delayed
+    /// but never starved. 0 to disable.
+    /// @param client_key_header Header identifying the client for fair scheduling, e.g. an API token header. Requests without it, and all requests
+    /// if it is empty, are keyed by client IP. Within a priority class the server loops give every client the same share of loop time,
+    /// so a client with many connections cannot crowd out the others. Server loops only.
+    /// @param max_client_concurrency Most requests of one client whose offloaded or asynchronous handler runs at once, per server loop.
+    /// Further requests of the client wait in the queue while other clients are served. 0 for no limit. Server loops only.
+    /// @param shed_target Queueing delay the server loops keep under overload. When no request got through faster than this during a whole
+    /// shed_interval, the loop answers requests that waited more than twice the target with 503 and Retry-After, without running middlewares
+    /// or handlers, until the queue drains. High priority routes and constant responses are never shed. 0 disables shedding. Server loops only.
+    /// @param shed_interval Window over which the queueing delay must stay above shed_target before requests are shed.
+    /// @param shed_retry_after Retry-After of shed responses.
+    /// @param request_timeout Time a request has to be answered, from its arrival, unless its route sets RouteOptions::timeout. 0 for no limit.
+    /// A request whose deadline passed before its handler starts, e.g. while it was queued, is answered with 504 Gateway Timeout without running it.
+    /// On the server loops, a request whose offloaded or asynchronous handler is still running at its deadline is answered with 504 at the deadline,
+    /// and its handler sees the request cancelled, see Request::cancellation(). Handlers running in place finish first.
+    /// @param timeout_header Header through which clients ask for a shorter timeout, in seconds with an optional fraction, e.g. "X-Request-Timeout: 2.5".
+    /// Clients can only shorten the timeout of the route or the server. Empty to ignore what clients ask for.
+    /// @param report Print the effective settings when the server starts.
+    struct ServerOptions
+    {
+        size_t workers = 0;
+        size_t backlog = 0;
+        size_t max_connections = 0;
+        std::chrono::seconds idle_timeout{60};
+        std::chrono::seconds keep_alive_timeout{60};
+        size_t max_requests_per_connection = 0;
+        bool tcp_nodelay = true;
+        size_t receive_buffer_size = 0;
+        size_t send_buffer_size = 0;
+        std::chrono::seconds defer_accept{0};
+        size_t fastopen_queue = 0;
+        size_t offload_threads = 0;
+        size_t stream_threads = 16;
+        SchedulingPolicy scheduling = SchedulingPolicy::STRICT;
+        std::array<unsigned, PRIORITY_CLASSES> priority_weights{{8, 4, 1}};
+        std::chrono::milliseconds starvation_timeout{500};
+        std::string client_key_header;
+        size_t max_client_concurrency = 0;
+        std::chrono::milliseconds shed_target{0};
+        std::chrono::milliseconds shed_interval{100};
+        std::chrono::seconds shed_retry_after{1};
+        std::chrono::milliseconds request_timeout{0};
+        std::string timeout_header = "X-Request-Timeout";
+        bool report = true;
+
+        /// @brief Check the settings.
+        /// @throws std::invalid_argument naming the first invalid setting.
+        void validate() const;
+        /// @brief Describe the effective settings, with the transport defaults filled in and the settings the transport ignores marked.
+        /// @param port Port the server listens on.
+        /// @return Human readable multi-line summary.
+        std::string describe(unsigned short port) const;
+    };
+}
+
+#endif // ENDERMAN_SERVER_OPTIONS_HPP
@@ -0,0 +1,89 @@
+/// @file spooled_body.hpp
+/// @brief Defines SpooledBody, a request body kept in a temporary file, and BodySpool, which moves a body being received to such a file once it grows past a threshold.
+
+#ifndef ENDERMAN_SPOOLED_BODY_HPP
+#define ENDERMAN_SPOOLED_BODY_HPP
+
+#include "body.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace enderman
+{
+    class SpoolException : public std::runtime_error
+    {
+    public:
+        explicit SpoolException(const std::string &message)
+            : std::runtime_error(message) {}
+    };
+
+    /// @brief Body stored in a temporary file, which is removed when the body is destroyed.
+    /// Read it with reader() to process it in chunks; serialize() loads the whole file.
+    class SpooledBody : public Body
+    {
+    private:
+        std::filesystem::path file_path;
+        size_t file_size;
+
+    public:
+        /// @brief Take ownership of a file.
+        /// @param path File holding the body. Removed when the body is destroyed.
+        /// @param size Size of the file in bytes.
+        SpooledBody(std::filesystem::path path, size_t size);
+        ~SpooledBody() override;
+        SpooledBody(const SpooledBody &) = delete;
+        SpooledBody &operator=(const SpooledBody &) = delete;
+
+        /// @brief Path of the file. A handler may move the file elsewhere to keep the upload; the body then has nothing left to remove.
+        const std::filesystem::path &path() const { return file_path; }
+
+        /// @throws SpoolException if the file cannot be read.
+        std::vector<char> serialize() const override;
+        const std::string type() const override { return std::string("application/octet-stream"); }
+        std::optional<size_t> content_length() const override { return file_size; }
+        /// @throws SpoolException if the file cannot be opened.
+        std::unique_ptr<BodyReader> reader() const override;
+    };
+
+    /// @brief Collects a request body as it is received. The body stays in memory up to a threshold and is then moved to a temporary file.
+    class BodySpool
+    {
+    private:
+        size_t threshold;
+        std::filesystem::path directory;
+        std::vector<char> memory;
+        std::filesystem::path file_path;
+        int fd = -1;
+        size_t total = 0;
+
+        void spool_to_file();
+        void write_to_file(const char *data, size_t size);
+
+    public:
+        /// @param spool_threshold Size above which the body is moved to a file. 0 keeps it in memory.
+        /// @param spool_directory Directory of the temporary files.
+        explicit BodySpool(size_t spool_threshold, std::filesystem::path spool_directory = std::filesystem::temp_directory_path());
+        ~BodySpool();
+        BodySpool(const BodySpool &) = delete;
+        BodySpool &operator=(const BodySpool &) = delete;
+
+        /// @brief Append received data.
+        /// @throws SpoolException if the temporary file cannot be created or written.
+        void append(const char *data, size_t size);
+        /// @brief Get the number of bytes received so far.
+        size_t size() const { return total; }
+        /// @brief Check if the body was moved to a file.
+        bool spooled() const { return fd >= 0; }
+        /// @brief Finish the body. The spool is empty afterwards.
+        /// @return RawBody owning the data, or SpooledBody if the body went past the threshold.
+        std::shared_ptr<Body> finish();
+    };
+}
+
+#endif // ENDERMAN_SPOOLED_BODY_HPP
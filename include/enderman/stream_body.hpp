@@ -0,0 +1,98 @@
+/// @file stream_body.hpp
+/// @brief Defines StreamBody, a response body produced chunk by chunk while it is sent instead of being built in memory.
+
+#ifndef ENDERMAN_STREAM_BODY_HPP
+#define ENDERMAN_STREAM_BODY_HPP
+
+#include "body.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace enderman
+{
+    /// @brief Destination a StreamBody producer writes its chunks to.
+    /// On transports that stream, write() returns once the data is handed to the connection and the client is not too far behind, so a slow client slows the producer down instead of making the server buffer.
+    class BodyWriter
+    {
+    public:
+        virtual ~BodyWriter() = default;
+
+        /// @brief Write the next part of the body.
+        /// @return False if the client is gone or the body is longer than its announced length. The producer should stop writing.
+        virtual bool write(const char *data, size_t size) = 0;
+        /// @brief Send the response head and everything written so far without waiting for the buffer to fill up.
+        /// Useful to let the client see the status before a slow producer has its first chunk ready.
+        /// @return False if the client is gone.
+        virtual bool flush() = 0;
+
+        bool write(std::string_view data) { return write(data.data(), data.size()); }
+    };
+
+    /// @brief Function producing a streamed body. It is called after the handler returned, while the response is being sent, and writes the whole body before returning.
+    /// The server loops run a producer that could get ahead of its client on their stream pool, see ServerOptions::stream_threads, after the exchange ended:
+    /// it must capture what it needs by value, not the Request or Response, and must be safe to run on any thread.
+    using BodyProducer = std::function<void(BodyWriter &)>;
+
+    /// @brief Response body written by a producer callback while the response is sent.
+    /// Without a known length the body is sent with Transfer-Encoding: chunked, or to HTTP/1.0 clients as it is, ended by closing the connection. Transports that cannot stream, such as Http-Server,
+    /// fall back to serialize(), which runs the producer into memory.
+    class StreamBody : public Body
+    {
+    private:
+        BodyProducer producer;
+        std::string content_type;
+        std::optional<size_t> length;
+
+        /// @brief Writer collecting the whole body, used by serialize().
+        class BufferWriter : public BodyWriter
+        {
+        public:
+            std::vector<char> data;
+            bool write(const char *chunk, size_t size) override
+            {
+                data.insert(data.end(), chunk, chunk + size);
+                return true;
+            }
+            bool flush() override { return true; }
+        };
+
+    public:
+        /// @brief Create a streamed body.
+        /// @param body_producer Producer writing the body. It may run once per transmission of the response.
+        /// @param type Content type of the body.
+        /// @param content_length Exact length of the body if known, which is then sent as Content-Length instead of chunked.
+        explicit StreamBody(BodyProducer body_producer,
+                            const std::string &type = "application/octet-stream",
+                            std::optional<size_t> content_length = std::nullopt)
+            : producer(std::move(body_producer)), content_type(type), length(content_length) {}
+
+        /// @brief Run the producer into a writer.
+        void stream(BodyWriter &writer) const
+        {
+            if (producer)
+                producer(writer);
+        }
+
+        /// @brief Run the producer into memory. Only used by transports that cannot stream.
+        std::vector<char> serialize() const override
+        {
+            BufferWriter writer;
+            if (length)
+                writer.data.reserve(*length);
+            stream(writer);
+            return std::move(writer.data);
+        }
+
+        const std::string type() const override { return content_type; }
+
+        std::optional<size_t> content_length() const override { return length; }
+    };
+}
+
+#endif // ENDERMAN_STREAM_BODY_HPP
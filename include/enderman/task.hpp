@@ -0,0 +1,325 @@
+/// @file task.hpp
+/// @brief Defines Task, the return type of coroutine route handlers, and the operations they can co_await.
+/// Available when the application is compiled as C++20 with coroutine support; the library itself does not need it.
+
+#ifndef ENDERMAN_TASK_HPP
+#define ENDERMAN_TASK_HPP
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#define ENDERMAN_HAS_COROUTINES 1
+
+#include "types.hpp"
+#include "cancellation.hpp"
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace enderman
+{
+    template <typename T = void>
+    class Task;
+
+    namespace detail
+    {
+        /// The scheduling primitives behind the awaitables. On a server loop they return true and call resume later on that loop.
+        /// On other threads, e.g. Http-Server, an executor worker or a Loopback, they wait for the operation in place and return false,
+        /// so the coroutine continues without suspending.
+
+        /// @brief Resume after a delay.
+        bool resume_after(std::chrono::steady_clock::duration delay, std::function<void()> resume);
+        /// @brief Run work on the offload executor, then resume.
+        bool resume_after_work(std::function<void()> work, std::function<void()> resume);
+        /// @brief Resume once a file descriptor is readable or writable.
+        bool resume_when_ready(int fd, bool writable, std::function<void()> resume);
+        /// @brief Resume after a delay, or as soon as a token is cancelled. duration::max() waits for the cancellation alone.
+        bool resume_after_or_cancel(std::chrono::steady_clock::duration delay, const CancellationToken &token, std::function<void()> resume);
+
+        template <typename T>
+        class Promise;
+
+        /// @brief Parts of the promise shared by all result types.
+        class PromiseBase
+        {
+        private:
+            /// @brief Coroutine awaiting this task, resumed when it finishes.
+            std::coroutine_handle<> continuation;
+            /// @brief Completion of a task started by Task::start(). The frame destroys itself when it is called.
+            std::function<void(std::exception_ptr)> on_done;
+
+            template <typename T>
+            friend class enderman::Task;
+
+            struct FinalAwaiter
+            {
+                bool await_ready() noexcept { return false; }
+                template <typename P>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+                {
+                    PromiseBase &promise = handle.promise();
+                    if (promise.continuation)
+                        return promise.continuation;
+                    if (promise.on_done)
+                    {
+                        auto done = std::move(promise.on_done);
+                        std::exception_ptr error = promise.error;
+                        handle.destroy();
+                        done(error);
+                    }
+                    return std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+
+        protected:
+            std::exception_ptr error;
+
+        public:
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            FinalAwaiter final_suspend() noexcept { return {}; }
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+        };
+    }
+
+    /// @brief Lazily started coroutine producing a T. Route handlers return Task<void>:
+    /// @code
+    /// app.get("/slow", [](Request &req, Response &res) -> Task<void> {
+    ///     co_await sleep_for(std::chrono::milliseconds(100));
+    ///     TextBody::set_text(res, co_await offloaded([] { return render_report(); }));
+    /// });
+    /// @endcode
+    /// A task starts running when it is awaited, and resumes its awaiter when it finishes. Exceptions propagate to the awaiter;
+    /// an exception escaping a route handler results in a 500 response.
+    template <typename T>
+    class [[nodiscard]] Task
+    {
+    public:
+        using promise_type = detail::Promise<T>;
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().result(); }
+        };
+
+    public:
+        explicit Task(std::coroutine_handle<promise_type> coroutine) : handle(coroutine) {}
+        Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+        Task &operator=(Task &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (handle)
+                    handle.destroy();
+                handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+        ~Task()
+        {
+            if (handle)
+                handle.destroy();
+        }
+
+        Awaiter operator co_await() && noexcept { return Awaiter{handle}; }
+
+        /// @brief Run the task without awaiting it. The task owns itself from here on and calls done when it finishes.
+        void start(std::function<void(std::exception_ptr)> done) &&
+        {
+            std::coroutine_handle<promise_type> coroutine = std::exchange(handle, nullptr);
+            coroutine.promise().on_done = std::move(done);
+            coroutine.resume();
+        }
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        class Promise : public PromiseBase
+        {
+        private:
+            std::optional<T> value;
+
+        public:
+            Task<T> get_return_object() { return Task<T>(std::coroutine_handle<Promise>::from_promise(*this)); }
+            template <typename U>
+            void return_value(U &&result) { value.emplace(std::forward<U>(result)); }
+            T result()
+            {
+                if (error)
+                    std::rethrow_exception(error);
+                return std::move(*value);
+            }
+        };
+
+        template <>
+        class Promise<void> : public PromiseBase
+        {
+        public:
+            Task<void> get_return_object() { return Task<void>(std::coroutine_handle<Promise>::from_promise(*this)); }
+            void return_void() {}
+            void result()
+            {
+                if (error)
+                    std::rethrow_exception(error);
+            }
+        };
+
+        struct SleepAwaiter
+        {
+            std::chrono::steady_clock::duration delay;
+
+            bool await_ready() const noexcept { return delay <= std::chrono::steady_clock::duration::zero(); }
+            bool await_suspend(std::coroutine_handle<> handle) { return resume_after(delay, [handle] { handle.resume(); }); }
+            void await_resume() const noexcept {}
+        };
+
+        template <typename F>
+        class OffloadAwaiter
+        {
+        private:
+            using Result = std::invoke_result_t<F &>;
+            using Stored = std::conditional_t<std::is_void_v<Result>, bool, std::optional<Result>>;
+
+            F work;
+            Stored result{};
+            std::exception_ptr error;
+
+        public:
+            explicit OffloadAwaiter(F function) : work(std::move(function)) {}
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                return resume_after_work([this]
+                                         {
+                                             try
+                                             {
+                                                 if constexpr (std::is_void_v<Result>)
+                                                     work();
+                                                 else
+                                                     result.emplace(work());
+                                             }
+                                             catch (...)
+                                             {
+                                                 error = std::current_exception();
+                                             } },
+                                         [handle]
+                                         { handle.resume(); });
+            }
+            Result await_resume()
+            {
+                if (error)
+                    std::rethrow_exception(error);
+                if constexpr (!std::is_void_v<Result>)
+                    return std::move(*result);
+            }
+        };
+
+        struct CancellableSleepAwaiter
+        {
+            std::chrono::steady_clock::duration delay;
+            CancellationToken token;
+
+            bool await_ready() const { return delay <= std::chrono::steady_clock::duration::zero() || token.is_cancelled(); }
+            bool await_suspend(std::coroutine_handle<> handle) { return resume_after_or_cancel(delay, token, [handle] { handle.resume(); }); }
+            void await_resume() const { token.throw_if_cancelled(); }
+        };
+
+        struct CancelledAwaiter
+        {
+            CancellationToken token;
+
+            /// A token nothing can cancel completes right away instead of suspending forever.
+            bool await_ready() const { return token.is_cancelled() || (!token.can_be_cancelled() && token.deadline() == std::chrono::steady_clock::time_point::max()); }
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                return resume_after_or_cancel(std::chrono::steady_clock::duration::max(), token, [handle] { handle.resume(); });
+            }
+            CancellationReason await_resume() const { return token.reason(); }
+        };
+
+        struct ReadyAwaiter
+        {
+            int fd;
+            bool writable;
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> handle) { return resume_when_ready(fd, writable, [handle] { handle.resume(); }); }
+            void await_resume() const noexcept {}
+        };
+    }
+
+    /// @brief Suspend the coroutine for a while without blocking its server loop.
+    template <typename Rep, typename Period>
+    detail::SleepAwaiter sleep_for(std::chrono::duration<Rep, Period> delay)
+    {
+        return detail::SleepAwaiter{std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay)};
+    }
+
+    /// @brief Suspend the coroutine for a while, or until its request is cancelled, e.g. between polls of another service:
+    /// @code
+    /// co_await sleep_for(std::chrono::milliseconds(50), req.cancellation());
+    /// @endcode
+    /// @throws RequestCancelledException if the request is cancelled, which answers it with 504 unless the handler catches it.
+    template <typename Rep, typename Period>
+    detail::CancellableSleepAwaiter sleep_for(std::chrono::duration<Rep, Period> delay, const CancellationToken &token)
+    {
+        return detail::CancellableSleepAwaiter{std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay), token};
+    }
+
+    /// @brief Suspend until a request is cancelled, e.g. in a coroutine cleaning up after it. Completes right away with CancellationReason::NONE
+    /// for tokens that cannot be cancelled.
+    /// @return Why the request was cancelled.
+    inline detail::CancelledAwaiter cancelled(const CancellationToken &token) { return detail::CancelledAwaiter{token}; }
+
+    /// @brief Run blocking or CPU heavy work on the offload executor and resume with its result on the server loop. Exceptions of the work are rethrown.
+    template <typename F>
+    detail::OffloadAwaiter<std::decay_t<F>> offloaded(F &&work)
+    {
+        return detail::OffloadAwaiter<std::decay_t<F>>(std::forward<F>(work));
+    }
+
+    /// @brief Suspend until a non-blocking file descriptor, e.g. a socket to another service, can be read without blocking.
+    /// Several coroutines may await the same descriptor, in either direction.
+    /// @throws std::system_error if the server loop cannot watch the descriptor.
+    inline detail::ReadyAwaiter readable(int fd) { return detail::ReadyAwaiter{fd, false}; }
+    /// @brief Suspend until a non-blocking file descriptor can be written without blocking.
+    inline detail::ReadyAwaiter writable(int fd) { return detail::ReadyAwaiter{fd, true}; }
+
+    template <>
+    struct AsyncHandlerTraits<Task<void>>
+    {
+        static constexpr bool supported = true;
+
+        template <typename Handler>
+        static AsyncRouteHandlerFunction adapt(Handler handler)
+        {
+            return [handler = std::move(handler)](Request &req, Response &res, HandlerCompletion done) mutable
+            {
+                Task<void> task = handler(req, res);
+                std::move(task).start(std::move(done));
+            };
+        }
+    };
+}
+
+#endif
+
+#endif // ENDERMAN_TASK_HPP
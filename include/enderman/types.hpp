@@ -19,6 +19,19 @@ namespace enderman
     using MiddlewareFunction = std::function<void(Request &, Response &, const Next &)>;
     /// @brief Function type for route handlers. It accepts a Request and Response.
     using RouteHandlerFunction = std::function<void(Request &, Response &)>;
+    /// @brief Called exactly once when an asynchronous route handler is done, with the error it failed with or nullptr. May be called from any thread.
+    using HandlerCompletion = std::function<void(std::exception_ptr)>;
+    /// @brief Function type for route handlers finishing after they return, e.g. coroutine handlers. It accepts a Request, Response and the completion to call when the response is ready.
+    /// Request and Response stay valid until the completion is called.
+    using AsyncRouteHandlerFunction = std::function<void(Request &, Response &, HandlerCompletion)>;
+
+    /// @brief Adapts route handlers returning Result to AsyncRouteHandlerFunction, so they can be registered like synchronous ones.
+    /// Specialized for Task<void> by task.hpp; handlers returning anything else are not asynchronous.
+    template <typename Result>
+    struct AsyncHandlerTraits
+    {
+        static constexpr bool supported = false;
+    };
 }
 
 #endif // ENDERMAN_TYPES_HPP
\ No newline at end of file
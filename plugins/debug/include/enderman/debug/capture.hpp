@@ -0,0 +1,195 @@
+/// @file capture.hpp
+/// @brief Middleware recording incoming requests to a capture file, which the replay helpers and the enderman-replay tool can play back.
+
+#pragma once
+
+#include "enderman/types.hpp"
+#include "enderman/constants.hpp"
+#include "enderman/request.hpp"
+#include "enderman/response.hpp"
+#include "enderman/body.hpp"
+
+#include "capture_format.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace enderman
+{
+    /// @brief Configuration struct for traffic capture.
+    /// @param path File the capture is written to. It is truncated when the capture starts.
+    /// @param sample_rate Fraction of requests recorded, in (0, 1].
+    /// @param max_records Stop recording after this many requests, 0 for no limit.
+    /// @param flush_every Flush the file after this many records. Records still buffered when the process is killed are lost.
+    /// @param excluded_headers Lowercase names of headers that are never written, e.g. credentials.
+    struct CaptureConfig
+    {
+        std::string path = "enderman-capture.jsonl";
+        double sample_rate = 1.0;
+        size_t max_records = 0;
+        size_t flush_every = 64;
+        std::vector<std::string> excluded_headers = {"authorization", "cookie", "proxy-authorization"};
+    };
+
+    class CaptureException : public std::runtime_error
+    {
+    public:
+        explicit CaptureException(const std::string &message)
+            : std::runtime_error(message) {}
+    };
+
+    /// @brief Writer of a capture file. Thread safe; records are encoded outside the lock.
+    class TrafficCapture
+    {
+    private:
+        CaptureConfig config;
+        std::ofstream file;
+        std::mutex mutex;
+        std::chrono::steady_clock::time_point started_at;
+        std::atomic<size_t> recorded{0};
+        size_t unflushed = 0;
+
+        static const char *method_name(HttpMethod method)
+        {
+            switch (method)
+            {
+            case HttpMethod::GET:
+                return "GET";
+            case HttpMethod::POST:
+                return "POST";
+            case HttpMethod::PUT:
+                return "PUT";
+            case HttpMethod::DELETE:
+                return "DELETE";
+            case HttpMethod::PATCH:
+                return "PATCH";
+            case HttpMethod::OPTIONS:
+                return "OPTIONS";
+            case HttpMethod::HEAD:
+                return "HEAD";
+            }
+            return "GET";
+        }
+
+        bool sampled()
+        {
+            if (config.sample_rate >= 1.0)
+                return true;
+            thread_local std::minstd_rand rng(std::random_device{}());
+            return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < config.sample_rate;
+        }
+
+        bool excluded(const std::string &name) const
+        {
+            return std::find(config.excluded_headers.begin(), config.excluded_headers.end(), name) != config.excluded_headers.end();
+        }
+
+    public:
+        /// @brief Open the capture file.
+        /// @throws CaptureException if the file cannot be opened or the sample rate is out of range.
+        explicit TrafficCapture(const CaptureConfig &capture_config)
+            : config(capture_config),
+              file(capture_config.path, std::ios::binary | std::ios::trunc),
+              started_at(std::chrono::steady_clock::now())
+        {
+            if (!file)
+                throw CaptureException("Unable to open capture file " + config.path);
+            if (!(config.sample_rate > 0 && config.sample_rate <= 1))
+                throw CaptureException("Capture sample rate must be in (0, 1]");
+            for (auto &name : config.excluded_headers)
+                std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c)
+                               { return static_cast<char>(std::tolower(c)); });
+        }
+
+        ~TrafficCapture() { flush(); }
+
+        /// @brief Record a request, subject to sampling and max_records.
+        /// The body is taken as received, so the capture middleware has to run before any body parser.
+        void record(const Request &req)
+        {
+            if (config.max_records && recorded.load(std::memory_order_relaxed) >= config.max_records)
+                return;
+            if (!sampled())
+                return;
+
+            CaptureRecord record;
+            auto offset = req.received_at() - started_at;
+            record.offset_us = offset.count() > 0 ? static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(offset).count()) : 0;
+            record.ip = req.ip();
+            record.method = method_name(req.method());
+            record.uri = std::string(req.raw_uri());
+            for (const auto &header : req.headers())
+            {
+                std::string name(header.first);
+                std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c)
+                               { return static_cast<char>(std::tolower(c)); });
+                if (!excluded(name))
+                    record.headers.emplace_back(std::move(name), std::string(header.second));
+            }
+            if (auto body = req.get_body())
+            {
+                if (auto raw = dynamic_cast<const RawBody *>(body.get()))
+                    record.body.assign(raw->view());
+                else
+                {
+                    std::vector<char> data = body->serialize();
+                    record.body.assign(data.begin(), data.end());
+                }
+            }
+            std::string line = encode_capture_record(record);
+            line += '\n';
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (config.max_records && recorded.load(std::memory_order_relaxed) >= config.max_records)
+                return;
+            file.write(line.data(), static_cast<std::streamsize>(line.size()));
+            recorded.fetch_add(1, std::memory_order_relaxed);
+            if (++unflushed >= config.flush_every)
+            {
+                file.flush();
+                unflushed = 0;
+            }
+        }
+
+        /// @brief Write buffered records to the file.
+        void flush()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            file.flush();
+            unflushed = 0;
+        }
+
+        /// @brief Get the number of requests recorded so far.
+        size_t records() const { return recorded.load(std::memory_order_relaxed); }
+    };
+
+    /// @brief Middleware generator recording requests to a capture.
+    /// Register it before body parsers so that bodies are recorded as received.
+    /// @param capture Capture to write to. Keep a copy of the pointer to flush it or read its record count.
+    /// @return MiddlewareFunction recording every sampled request and passing it on unchanged.
+    inline MiddlewareFunction traffic_capture(std::shared_ptr<TrafficCapture> capture)
+    {
+        return [capture](Request &req, Response &res, const Next &next)
+        {
+            capture->record(req);
+            next(nullptr);
+        };
+    }
+
+    /// @brief Middleware generator recording requests to a capture file.
+    /// @param config Configuration of the capture.
+    /// @return MiddlewareFunction recording every sampled request and passing it on unchanged.
+    /// @throws CaptureException if the capture file cannot be opened.
+    inline MiddlewareFunction traffic_capture(const CaptureConfig &config = CaptureConfig{})
+    {
+        return traffic_capture(std::make_shared<TrafficCapture>(config));
+    }
+}
@@ -0,0 +1,325 @@
+/// @file capture_format.hpp
+/// @brief Record format of traffic captures. Depends only on the standard library so that the replay tool can read captures without linking Enderman.
+/// @brief A capture is a JSON-lines file, one request per line:
+/// @brief {"t":1520,"ip":"10.0.0.7","method":"POST","uri":"/users?x=1","headers":[["content-type","application/json"]],"body":"eyJhIjoxfQ=="}
+/// @brief "t" is the arrival time in microseconds since the capture started, "body" is base64 encoded.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace enderman
+{
+    /// @brief One captured request.
+    struct CaptureRecord
+    {
+        /// @brief Arrival time in microseconds since the capture started.
+        uint64_t offset_us = 0;
+        std::string ip;
+        std::string method;
+        /// @brief Raw URI as received, still URL encoded.
+        std::string uri;
+        /// @brief Headers with lowercase names.
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;
+    };
+
+    class CaptureFormatException : public std::runtime_error
+    {
+    public:
+        explicit CaptureFormatException(const std::string &message)
+            : std::runtime_error(message) {}
+    };
+
+    namespace capture_format
+    {
+        inline const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        inline void append_base64(std::string &out, const char *data, size_t size)
+        {
+            size_t i = 0;
+            for (; i + 2 < size; i += 3)
+            {
+                uint32_t n = (uint32_t(uint8_t(data[i])) << 16) | (uint32_t(uint8_t(data[i + 1])) << 8) | uint8_t(data[i + 2]);
+                out += BASE64_ALPHABET[(n >> 18) & 63];
+                out += BASE64_ALPHABET[(n >> 12) & 63];
+                out += BASE64_ALPHABET[(n >> 6) & 63];
+                out += BASE64_ALPHABET[n & 63];
+            }
+            if (i < size)
+            {
+                uint32_t n = uint32_t(uint8_t(data[i])) << 16;
+                if (i + 1 < size)
+                    n |= uint32_t(uint8_t(data[i + 1])) << 8;
+                out += BASE64_ALPHABET[(n >> 18) & 63];
+                out += BASE64_ALPHABET[(n >> 12) & 63];
+                out += i + 1 < size ? BASE64_ALPHABET[(n >> 6) & 63] : '=';
+                out += '=';
+            }
+        }
+
+        inline std::string decode_base64(const std::string &in)
+        {
+            std::string out;
+            out.reserve(in.size() / 4 * 3);
+            uint32_t buffer = 0;
+            int bits = 0;
+            for (char c : in)
+            {
+                int value;
+                if (c >= 'A' && c <= 'Z')
+                    value = c - 'A';
+                else if (c >= 'a' && c <= 'z')
+                    value = c - 'a' + 26;
+                else if (c >= '0' && c <= '9')
+                    value = c - '0' + 52;
+                else if (c == '+')
+                    value = 62;
+                else if (c == '/')
+                    value = 63;
+                else if (c == '=')
+                    break;
+                else
+                    throw CaptureFormatException("Invalid base64 character in body");
+                buffer = (buffer << 6) | static_cast<uint32_t>(value);
+                bits += 6;
+                if (bits >= 8)
+                {
+                    bits -= 8;
+                    out += static_cast<char>((buffer >> bits) & 0xFF);
+                }
+            }
+            return out;
+        }
+
+        inline void append_json_string(std::string &out, const std::string &value)
+        {
+            out += '"';
+            for (char c : value)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    out += '\\';
+                    out += c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+            out += '"';
+        }
+
+        /// @brief Cursor over one line. Parses only what encode_capture_record() writes.
+        class Reader
+        {
+        private:
+            const std::string &line;
+            size_t pos = 0;
+
+        public:
+            explicit Reader(const std::string &l) : line(l) {}
+
+            void skip_space()
+            {
+                while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r'))
+                    ++pos;
+            }
+
+            bool consume(char c)
+            {
+                skip_space();
+                if (pos < line.size() && line[pos] == c)
+                {
+                    ++pos;
+                    return true;
+                }
+                return false;
+            }
+
+            void expect(char c)
+            {
+                if (!consume(c))
+                    throw CaptureFormatException(std::string("Expected '") + c + "' at column " + std::to_string(pos + 1));
+            }
+
+            std::string string()
+            {
+                expect('"');
+                std::string out;
+                while (pos < line.size() && line[pos] != '"')
+                {
+                    char c = line[pos++];
+                    if (c != '\\')
+                    {
+                        out += c;
+                        continue;
+                    }
+                    if (pos >= line.size())
+                        break;
+                    char e = line[pos++];
+                    switch (e)
+                    {
+                    case 'n':
+                        out += '\n';
+                        break;
+                    case 'r':
+                        out += '\r';
+                        break;
+                    case 't':
+                        out += '\t';
+                        break;
+                    case 'b':
+                        out += '\b';
+                        break;
+                    case 'f':
+                        out += '\f';
+                        break;
+                    case 'u':
+                    {
+                        if (pos + 4 > line.size())
+                            throw CaptureFormatException("Truncated \\u escape");
+                        unsigned long code = std::stoul(line.substr(pos, 4), nullptr, 16);
+                        pos += 4;
+                        // Only control characters are escaped by the writer; anything else is kept as UTF-8.
+                        if (code < 0x80)
+                            out += static_cast<char>(code);
+                        else if (code < 0x800)
+                        {
+                            out += static_cast<char>(0xC0 | (code >> 6));
+                            out += static_cast<char>(0x80 | (code & 0x3F));
+                        }
+                        else
+                        {
+                            out += static_cast<char>(0xE0 | (code >> 12));
+                            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                            out += static_cast<char>(0x80 | (code & 0x3F));
+                        }
+                        break;
+                    }
+                    default:
+                        out += e;
+                    }
+                }
+                expect('"');
+                return out;
+            }
+
+            uint64_t number()
+            {
+                skip_space();
+                size_t start = pos;
+                while (pos < line.size() && line[pos] >= '0' && line[pos] <= '9')
+                    ++pos;
+                if (start == pos)
+                    throw CaptureFormatException("Expected a number at column " + std::to_string(pos + 1));
+                return std::stoull(line.substr(start, pos - start));
+            }
+
+            char peek()
+            {
+                skip_space();
+                return pos < line.size() ? line[pos] : '\0';
+            }
+
+            bool at_end()
+            {
+                skip_space();
+                return pos >= line.size();
+            }
+        };
+    }
+
+    /// @brief Encode a record as one JSON line without the trailing newline.
+    inline std::string encode_capture_record(const CaptureRecord &record)
+    {
+        std::string out;
+        out.reserve(96 + record.uri.size() + record.body.size() * 4 / 3);
+        out += "{\"t\":";
+        out += std::to_string(record.offset_us);
+        out += ",\"ip\":";
+        capture_format::append_json_string(out, record.ip);
+        out += ",\"method\":";
+        capture_format::append_json_string(out, record.method);
+        out += ",\"uri\":";
+        capture_format::append_json_string(out, record.uri);
+        out += ",\"headers\":[";
+        for (size_t i = 0; i < record.headers.size(); ++i)
+        {
+            out += i ? ",[" : "[";
+            capture_format::append_json_string(out, record.headers[i].first);
+            out += ',';
+            capture_format::append_json_string(out, record.headers[i].second);
+            out += ']';
+        }
+        out += "],\"body\":\"";
+        capture_format::append_base64(out, record.body.data(), record.body.size());
+        out += "\"}";
+        return out;
+    }
+
+    /// @brief Decode one line written by encode_capture_record(). Unknown string or number fields are ignored.
+    /// @throws CaptureFormatException if the line is not a valid record.
+    inline CaptureRecord decode_capture_record(const std::string &line)
+    {
+        CaptureRecord record;
+        capture_format::Reader reader(line);
+        reader.expect('{');
+        if (!reader.consume('}'))
+        {
+            do
+            {
+                std::string key = reader.string();
+                reader.expect(':');
+                if (key == "t")
+                    record.offset_us = reader.number();
+                else if (key == "ip")
+                    record.ip = reader.string();
+                else if (key == "method")
+                    record.method = reader.string();
+                else if (key == "uri")
+                    record.uri = reader.string();
+                else if (key == "body")
+                    record.body = capture_format::decode_base64(reader.string());
+                else if (key == "headers")
+                {
+                    reader.expect('[');
+                    if (!reader.consume(']'))
+                    {
+                        do
+                        {
+                            reader.expect('[');
+                            std::string name = reader.string();
+                            reader.expect(',');
+                            std::string value = reader.string();
+                            reader.expect(']');
+                            record.headers.emplace_back(std::move(name), std::move(value));
+                        } while (reader.consume(','));
+                        reader.expect(']');
+                    }
+                }
+                else if (reader.peek() == '"')
+                    reader.string();
+                else
+                    reader.number();
+            } while (reader.consume(','));
+            reader.expect('}');
+        }
+        if (!reader.at_end())
+            throw CaptureFormatException("Trailing characters after record");
+        if (record.method.empty() || record.uri.empty())
+            throw CaptureFormatException("Record without method or uri");
+        return record;
+    }
+}
@@ -0,0 +1,9 @@
+///  @file debug.hpp
+///  @brief Single include header for all debugging and profiling helpers.
+
+#pragma once
+
+#include "profiler.hpp"
+#include "metrics.hpp"
+#include "capture.hpp"
+#include "replay.hpp"
@@ -0,0 +1,106 @@
+/// @file metrics.hpp
+/// @brief Route handler exporting the server loop monitor statistics in the Prometheus text exposition format.
+
+#pragma once
+
+#include "enderman/enderman.hpp"
+#include "enderman/monitor.hpp"
+
+#include "enderman/standard_bodies/binary_body.hpp"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace enderman
+{
+    /// @brief Render loop statistics in the Prometheus text exposition format. Durations are exported in seconds.
+    /// @param stats Statistics to render.
+    /// @return Metrics as text.
+    inline std::string loop_stats_to_prometheus(const LoopStats &stats)
+    {
+        std::string out;
+        auto metric = [&out](const char *name, const char *type, const char *help, const std::string &value)
+        {
+            out += "# HELP ";
+            out += name;
+            out += ' ';
+            out += help;
+            out += "\n# TYPE ";
+            out += name;
+            out += ' ';
+            out += type;
+            out += '\n';
+            out += name;
+            out += ' ';
+            out += value;
+            out += '\n';
+        };
+        auto seconds = [](std::chrono::nanoseconds value)
+        {
+            return std::to_string(std::chrono::duration<double>(value).count());
+        };
+        // One sample per priority class, labelled with its name.
+        auto by_priority = [&out, &stats](const char *name, const char *type, const char *help, const auto &value)
+        {
+            out += "# HELP ";
+            out += name;
+            out += ' ';
+            out += help;
+            out += "\n# TYPE ";
+            out += name;
+            out += ' ';
+            out += type;
+            out += '\n';
+            for (size_t i = 0; i < PRIORITY_CLASSES; ++i)
+            {
+                out += name;
+                out += "{priority=\"";
+                out += priority_name(static_cast<Priority>(i));
+                out += "\"} ";
+                out += value(stats.priorities[i]);
+                out += '\n';
+            }
+        };
+
+        metric("enderman_requests_total", "counter", "Requests received by the server loop.", std::to_string(stats.requests));
+        metric("enderman_shed_requests_total", "counter", "Requests answered with 503 to shed load.", std::to_string(stats.shed_requests));
+        metric("enderman_loop_queue_depth", "gauge", "Requests received whose response is not written yet.", std::to_string(stats.queue_depth));
+        metric("enderman_loop_peak_queue_depth", "gauge", "Highest queue depth during the last monitor interval.", std::to_string(stats.peak_queue_depth));
+        metric("enderman_loop_lag_seconds", "gauge", "Time the busiest loop has been busy with its current request.", seconds(stats.loop_lag));
+        metric("enderman_loop_max_lag_seconds", "gauge", "Highest loop lag during the last monitor interval.", seconds(stats.max_loop_lag));
+        metric("enderman_loop_timer_drift_seconds", "gauge", "Delay of the monitor timer at the end of the last interval.", seconds(stats.timer_drift));
+        metric("enderman_dispatch_delay_avg_seconds", "gauge", "Average time from request arrival to handler start during the last interval.", seconds(stats.avg_dispatch_delay));
+        metric("enderman_dispatch_delay_max_seconds", "gauge", "Highest time from request arrival to handler start during the last interval.", seconds(stats.max_dispatch_delay));
+        metric("enderman_handler_time_avg_seconds", "gauge", "Average route handler run time during the last interval.", seconds(stats.avg_handler_time));
+        metric("enderman_handler_time_max_seconds", "gauge", "Highest route handler run time during the last interval.", seconds(stats.max_handler_time));
+        by_priority("enderman_priority_queued", "gauge", "Requests waiting for dispatch by priority class.", [](const PriorityStats &priority)
+                    { return std::to_string(priority.queued); });
+        by_priority("enderman_priority_dispatched", "gauge", "Requests dispatched by priority class during the last monitor interval.", [](const PriorityStats &priority)
+                    { return std::to_string(priority.dispatched); });
+        by_priority("enderman_priority_queue_delay_avg_seconds", "gauge", "Average queueing delay by priority class during the last monitor interval.", [&seconds](const PriorityStats &priority)
+                    { return seconds(priority.avg_queue_delay); });
+        by_priority("enderman_priority_queue_delay_p99_seconds", "gauge", "99th percentile queueing delay by priority class during the last monitor interval.", [&seconds](const PriorityStats &priority)
+                    { return seconds(priority.p99_queue_delay); });
+        by_priority("enderman_priority_queue_delay_max_seconds", "gauge", "Highest queueing delay by priority class during the last monitor interval.", [&seconds](const PriorityStats &priority)
+                    { return seconds(priority.max_queue_delay); });
+        return out;
+    }
+
+    /// @brief Route handler generator exporting the loop monitor statistics of an application, e.g. app.get("/debug/metrics", loop_metrics_handler(app)).
+    /// Call app.monitor() to enable the monitor, otherwise all values are zero.
+    /// @param app Application whose statistics are exported. Must outlive the handler.
+    /// @return RouteHandlerFunction serving the metrics as text/plain.
+    inline RouteHandlerFunction loop_metrics_handler(const Enderman &app)
+    {
+        return [&app](Request &req, Response &res)
+        {
+            std::string text = loop_stats_to_prometheus(app.loop_stats());
+            auto body = std::make_shared<BinaryBody>();
+            body->move_data(std::vector<char>(text.begin(), text.end()));
+            body->content_type = "text/plain; version=0.0.4";
+            res.set_status(200).set_body(body).send();
+        };
+    }
+}
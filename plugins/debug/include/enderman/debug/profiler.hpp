@@ -0,0 +1,471 @@
+/// @file profiler.hpp
+/// @brief Sampling CPU profiler with a debug route handler that returns collapsed stacks ready for flamegraph tools.
+
+#pragma once
+
+#include "enderman/types.hpp"
+#include "enderman/constants.hpp"
+#include "enderman/request.hpp"
+#include "enderman/response.hpp"
+
+#include "enderman/standard_bodies/binary_body.hpp"
+
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <time.h>
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace enderman
+{
+    /// @brief Configuration struct for the CPU profile route handler.
+    /// @param frequency Sampling frequency in samples per second of consumed CPU time.
+    /// @param default_seconds Duration of a capture when the request has no "seconds" query parameter.
+    /// @param max_seconds Upper bound for the duration a client may request.
+    /// @param max_samples Most samples preallocated for a capture, about 600 bytes each. A capture preallocates room for the samples it can take at most,
+    /// seconds × frequency × hardware threads, up to this. Samples beyond it are dropped and counted.
+    struct CpuProfilerConfig
+    {
+        unsigned int frequency = 99;
+        unsigned int default_seconds = 10;
+        unsigned int max_seconds = 120;
+        size_t max_samples = 1 << 13;
+    };
+
+    /// @brief Process wide sampling CPU profiler based on setitimer(ITIMER_PROF) and SIGPROF.
+    /// Every server thread consuming CPU is sampled. Samples are tagged with the route set on the sampled thread through set_route_tag(),
+    /// see cpu_profile_tagger for a middleware doing this for every request.
+    /// The SIGPROF handler installed by the first capture stays installed, doing nothing between captures.
+    class CpuProfiler
+    {
+    public:
+        /// @brief Maximum number of frames recorded per sample.
+        static constexpr size_t MAX_DEPTH = 64;
+        /// @brief Maximum length of a route tag including the terminating null character.
+        static constexpr size_t MAX_TAG_LENGTH = 96;
+
+        /// @brief Get the profiler instance. There is only one, because SIGPROF is shared by the whole process.
+        static CpuProfiler &instance()
+        {
+            static CpuProfiler profiler;
+            return profiler;
+        }
+
+        /// @brief Start a capture.
+        /// @param seconds Wall clock duration of the capture.
+        /// @param frequency Samples per second of consumed CPU time.
+        /// @param max_samples Most samples to preallocate.
+        /// @return False if a capture is already running or the signal handler could not be installed, true otherwise.
+        bool start(unsigned int seconds, unsigned int frequency, size_t max_samples)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (armed || seconds == 0 || frequency == 0 || max_samples == 0)
+                return false;
+
+            // backtrace() loads the unwinder lazily on its first call, which is not safe inside a signal handler.
+            void *warmup[1];
+            backtrace(warmup, 1);
+
+            if (!handler_installed)
+            {
+                struct sigaction action;
+                std::memset(&action, 0, sizeof(action));
+                action.sa_sigaction = &CpuProfiler::on_sigprof;
+                action.sa_flags = SA_SIGINFO | SA_RESTART;
+                sigemptyset(&action.sa_mask);
+                if (sigaction(SIGPROF, &action, nullptr) != 0)
+                    return false;
+                handler_installed = true;
+            }
+
+            // ITIMER_PROF counts the CPU time of all threads, so a capture takes at most frequency samples per second and hardware thread.
+            size_t cores = std::max(1u, std::thread::hardware_concurrency());
+            size_t capacity = std::min(max_samples, static_cast<size_t>(seconds) * frequency * cores);
+            samples.reset(new Sample[capacity]);
+            samples_size = capacity;
+            next_sample.store(0);
+            dropped_samples.store(0);
+
+            deadline_ns.store(monotonic_ns() + static_cast<long long>(seconds) * 1000000000LL);
+            sampling.store(true, std::memory_order_release);
+            armed = true;
+            has_capture = true;
+
+            struct itimerval timer;
+            timer.it_interval.tv_sec = 0;
+            timer.it_interval.tv_usec = frequency >= 1000000 ? 1 : static_cast<suseconds_t>(1000000 / frequency);
+            timer.it_value = timer.it_interval;
+            setitimer(ITIMER_PROF, &timer, nullptr);
+            return true;
+        }
+
+        /// @brief Stop the running capture. Collected samples are kept until collapsed() is called.
+        void stop()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop_locked();
+        }
+
+        /// @brief Check if a capture is running. A capture stops on its own when its duration has elapsed.
+        /// @return True if samples are still being collected, false otherwise.
+        bool running() const
+        {
+            return sampling.load(std::memory_order_acquire) && monotonic_ns() < deadline_ns.load();
+        }
+
+        /// @brief Check if a capture was started and its samples have not been collected yet.
+        /// @return True if there is a capture, running or finished, false otherwise.
+        bool has_profile() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return has_capture;
+        }
+
+        /// @brief Get the number of seconds left in the running capture.
+        /// @return Seconds left, rounded up. 0 if no capture is running.
+        long long remaining_seconds() const
+        {
+            long long left = deadline_ns.load() - monotonic_ns();
+            if (!running() || left <= 0)
+                return 0;
+            return (left + 999999999LL) / 1000000000LL;
+        }
+
+        /// @brief Stop the capture and aggregate its samples into collapsed stacks, one "frame;frame;...;frame count" line per distinct stack.
+        /// Root frames come first. Tagged samples start with a "[route]" frame. The collected samples are released.
+        /// @return Collapsed stacks as text.
+        std::string collapsed()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop_locked();
+            if (!has_capture)
+                return std::string();
+
+            size_t count = std::min(next_sample.load(), samples_size);
+            std::unordered_map<void *, std::string> symbols;
+            std::vector<void *> unresolved;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const Sample &sample = samples[i];
+                if (!sample.ready.load(std::memory_order_acquire))
+                    continue;
+                for (int f = FRAMES_TO_SKIP; f < sample.depth; ++f)
+                {
+                    if (symbols.emplace(sample.frames[f], std::string()).second)
+                        unresolved.push_back(sample.frames[f]);
+                }
+            }
+            resolve_symbols(unresolved, symbols);
+
+            std::map<std::string, size_t> stacks;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const Sample &sample = samples[i];
+                if (!sample.ready.load(std::memory_order_acquire))
+                    continue;
+                std::string stack;
+                if (sample.tag[0] != '\0')
+                {
+                    stack += '[';
+                    stack += sample.tag;
+                    stack += ']';
+                }
+                for (int f = sample.depth - 1; f >= FRAMES_TO_SKIP; --f)
+                {
+                    if (!stack.empty())
+                        stack += ';';
+                    stack += symbols[sample.frames[f]];
+                }
+                if (!stack.empty())
+                    ++stacks[stack];
+            }
+
+            std::string result;
+            for (const auto &stack : stacks)
+            {
+                result += stack.first;
+                result += ' ';
+                result += std::to_string(stack.second);
+                result += '\n';
+            }
+            size_t dropped = dropped_samples.load();
+            if (dropped > 0)
+                result += "[dropped_samples] " + std::to_string(dropped) + "\n";
+
+            samples.reset();
+            samples_size = 0;
+            has_capture = false;
+            return result;
+        }
+
+        /// @brief Tag the samples taken on the calling thread with the given route until the tag is replaced or cleared.
+        /// @param tag Route tag, e.g. "GET /users". Truncated to MAX_TAG_LENGTH - 1 characters.
+        static void set_route_tag(const std::string &tag)
+        {
+            size_t length = std::min(tag.size(), MAX_TAG_LENGTH - 1);
+            for (size_t i = 0; i < length; ++i)
+                route_tag[i] = tag[i] == ';' ? ':' : tag[i];
+            route_tag[length] = '\0';
+        }
+
+        /// @brief Remove the route tag of the calling thread.
+        static void clear_route_tag()
+        {
+            route_tag[0] = '\0';
+        }
+
+    private:
+        /// @brief Frames belonging to the signal handler and the signal trampoline.
+        static constexpr int FRAMES_TO_SKIP = 2;
+
+        struct Sample
+        {
+            std::atomic<bool> ready{false};
+            int depth = 0;
+            void *frames[MAX_DEPTH];
+            char tag[MAX_TAG_LENGTH];
+        };
+
+        static inline thread_local char route_tag[MAX_TAG_LENGTH] = {};
+
+        mutable std::mutex mutex;
+        std::unique_ptr<Sample[]> samples;
+        size_t samples_size = 0;
+        std::atomic<size_t> next_sample{0};
+        std::atomic<size_t> dropped_samples{0};
+        std::atomic<int> handlers_running{0};
+        std::atomic<bool> sampling{false};
+        std::atomic<long long> deadline_ns{0};
+        /// @brief The SIGPROF handler is installed. It is never removed, see stop_locked().
+        bool handler_installed = false;
+        bool armed = false;
+        bool has_capture = false;
+
+        CpuProfiler() = default;
+
+        static long long monotonic_ns()
+        {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            return static_cast<long long>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+        }
+
+        void stop_locked()
+        {
+            if (!armed)
+                return;
+            sampling.store(false, std::memory_order_release);
+            struct itimerval timer;
+            std::memset(&timer, 0, sizeof(timer));
+            setitimer(ITIMER_PROF, &timer, nullptr);
+            while (handlers_running.load() > 0)
+                std::this_thread::yield();
+            // The handler stays installed: a SIGPROF generated before the timer was disarmed may still be pending for another thread,
+            // and the default action would terminate the process. It does nothing while no capture is sampling.
+            armed = false;
+        }
+
+        /// @brief SIGPROF handler. Only async-signal-safe work is done here: a preallocated slot is claimed and filled.
+        static void on_sigprof(int, siginfo_t *, void *)
+        {
+            int saved_errno = errno;
+            CpuProfiler &profiler = instance();
+            profiler.handlers_running.fetch_add(1);
+            if (profiler.sampling.load(std::memory_order_acquire))
+            {
+                if (monotonic_ns() >= profiler.deadline_ns.load())
+                {
+                    profiler.sampling.store(false, std::memory_order_release);
+                    struct itimerval timer;
+                    std::memset(&timer, 0, sizeof(timer));
+                    setitimer(ITIMER_PROF, &timer, nullptr);
+                }
+                else
+                {
+                    size_t index = profiler.next_sample.fetch_add(1);
+                    if (index < profiler.samples_size)
+                    {
+                        Sample &sample = profiler.samples[index];
+                        sample.depth = backtrace(sample.frames, static_cast<int>(MAX_DEPTH));
+                        size_t i = 0;
+                        for (; i < MAX_TAG_LENGTH - 1 && route_tag[i] != '\0'; ++i)
+                            sample.tag[i] = route_tag[i];
+                        sample.tag[i] = '\0';
+                        sample.ready.store(true, std::memory_order_release);
+                    }
+                    else
+                    {
+                        profiler.dropped_samples.fetch_add(1);
+                    }
+                }
+            }
+            profiler.handlers_running.fetch_sub(1);
+            errno = saved_errno;
+        }
+
+        /// @brief Resolve program counters to demangled function names. Falls back to module+offset or the raw address.
+        static void resolve_symbols(std::vector<void *> &pcs, std::unordered_map<void *, std::string> &symbols)
+        {
+            if (pcs.empty())
+                return;
+            char **names = backtrace_symbols(pcs.data(), static_cast<int>(pcs.size()));
+            for (size_t i = 0; i < pcs.size(); ++i)
+            {
+                std::string frame = names ? names[i] : std::string();
+                std::string name;
+                auto open = frame.find('(');
+                auto plus = frame.find('+', open == std::string::npos ? 0 : open);
+                if (open != std::string::npos && plus != std::string::npos && plus > open + 1)
+                {
+                    std::string mangled = frame.substr(open + 1, plus - open - 1);
+                    int status = 0;
+                    char *demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+                    name = status == 0 && demangled ? demangled : mangled;
+                    std::free(demangled);
+                }
+                else if (open != std::string::npos)
+                {
+                    auto close = frame.find(')', open);
+                    std::string module = frame.substr(0, open);
+                    auto slash = module.rfind('/');
+                    if (slash != std::string::npos)
+                        module = module.substr(slash + 1);
+                    name = module + (close != std::string::npos ? frame.substr(open + 1, close - open - 1) : std::string());
+                }
+                if (name.empty())
+                {
+                    char address[2 + sizeof(void *) * 2 + 1];
+                    std::snprintf(address, sizeof(address), "%p", pcs[i]);
+                    name = address;
+                }
+                for (auto &c : name)
+                {
+                    if (c == ';' || c == '\n')
+                        c = ':';
+                }
+                symbols[pcs[i]] = name;
+            }
+            std::free(names);
+        }
+    };
+
+    /// @brief Middleware function to tag CPU profile samples with the method and the route pattern of the request being processed, e.g. "GET /users/:id",
+    /// so that the requests of a parameterised route share one tag. Requests matching no route are tagged "(no route)".
+    /// Register it first so that the other middlewares and the route handler are attributed to the route.
+    /// Samples taken between two requests keep the tag of the last request processed on that thread, which covers writing its response.
+    inline MiddlewareFunction cpu_profile_tagger = MiddlewareFunction(
+        [](Request &req, Response &res, const Next &next)
+        {
+            if (CpuProfiler::instance().running())
+            {
+                const char *method = "UNKNOWN";
+                switch (req.method())
+                {
+                case HttpMethod::GET:
+                    method = "GET";
+                    break;
+                case HttpMethod::POST:
+                    method = "POST";
+                    break;
+                case HttpMethod::PUT:
+                    method = "PUT";
+                    break;
+                case HttpMethod::DELETE:
+                    method = "DELETE";
+                    break;
+                case HttpMethod::PATCH:
+                    method = "PATCH";
+                    break;
+                case HttpMethod::OPTIONS:
+                    method = "OPTIONS";
+                    break;
+                case HttpMethod::HEAD:
+                    method = "HEAD";
+                    break;
+                }
+                const std::string &route = req.route();
+                CpuProfiler::set_route_tag(std::string(method) + " " + (route.empty() ? "(no route)" : route));
+            }
+            next(nullptr);
+        });
+
+    /// @brief Route handler generator for an opt-in CPU profile endpoint, e.g. app.get("/debug/profile", cpu_profile_handler()).
+    /// Handlers run inline on the server loop, so the handler never waits for the capture to finish:
+    /// - The first request starts a capture of "seconds" seconds (query parameter) and answers 202 with a Retry-After header.
+    /// - Requests made while the capture runs answer 202 with the remaining time in Retry-After.
+    /// - The first request after the capture has finished answers 200 with the collapsed stacks as text/plain.
+    /// @param config Sampling frequency, durations and sample buffer size of the captures.
+    /// @return RouteHandlerFunction serving the profile endpoint.
+    inline RouteHandlerFunction cpu_profile_handler(const CpuProfilerConfig &config = CpuProfilerConfig{})
+    {
+        return [config](Request &req, Response &res)
+        {
+            CpuProfiler &profiler = CpuProfiler::instance();
+            auto text_body = [](const std::string &text)
+            {
+                auto body = std::make_shared<BinaryBody>();
+                body->move_data(std::vector<char>(text.begin(), text.end()));
+                body->content_type = "text/plain; charset=utf-8";
+                return body;
+            };
+
+            if (profiler.running())
+            {
+                long long remaining = profiler.remaining_seconds();
+                res.set_status(202)
+                    .set_header("Retry-After", std::to_string(remaining))
+                    .set_body(text_body("Profiling in progress, " + std::to_string(remaining) + " seconds remaining.\n"))
+                    .send();
+                return;
+            }
+
+            if (profiler.has_profile())
+            {
+                res.set_status(200).set_body(text_body(profiler.collapsed())).send();
+                return;
+            }
+
+            unsigned int seconds = config.default_seconds;
+            auto it = req.query_params().find("seconds");
+            if (it != req.query_params().end())
+            {
+                try
+                {
+                    long requested = std::stol(it->second);
+                    if (requested < 1)
+                        requested = 1;
+                    seconds = requested > static_cast<long>(config.max_seconds) ? config.max_seconds : static_cast<unsigned int>(requested);
+                }
+                catch (const std::exception &)
+                {
+                    res.set_status(400).set_body(text_body("Invalid seconds parameter.\n")).send();
+                    return;
+                }
+            }
+
+            if (!profiler.start(seconds, config.frequency, config.max_samples))
+            {
+                res.set_status(503).set_body(text_body("Unable to start the profiler.\n")).send();
+                return;
+            }
+            res.set_status(202)
+                .set_header("Retry-After", std::to_string(seconds))
+                .set_body(text_body("Profiling started for " + std::to_string(seconds) + " seconds. Request this endpoint again to collect the collapsed stacks.\n"))
+                .send();
+        };
+    }
+}
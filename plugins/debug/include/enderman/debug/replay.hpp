@@ -0,0 +1,157 @@
+/// @file replay.hpp
+/// @brief Replays a capture file through an application in process, using the loopback transport.
+/// @brief To replay over a socket against a running server use the enderman-replay tool.
+
+#pragma once
+
+#include "enderman/enderman.hpp"
+#include "enderman/loopback.hpp"
+
+#include "capture.hpp"
+#include "capture_format.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace enderman
+{
+    /// @brief Configuration struct for in-process replay.
+    /// @param speed Replay speed relative to the capture, e.g. 2 replays twice as fast. 0 sends requests back to back.
+    /// @param max_records Stop after this many records, 0 replays the whole capture.
+    struct ReplayConfig
+    {
+        double speed = 1.0;
+        size_t max_records = 0;
+    };
+
+    /// @brief Latency percentiles in microseconds.
+    struct ReplayLatency
+    {
+        double p50 = 0;
+        double p90 = 0;
+        double p99 = 0;
+        double p99_9 = 0;
+        double max = 0;
+    };
+
+    /// @brief Result of a replay.
+    /// @param latency Time from the scheduled send time to the response. Includes time spent waiting behind slower requests.
+    /// @param service_time Time from the actual dispatch to the response.
+    struct ReplayReport
+    {
+        size_t requests = 0;
+        double elapsed_seconds = 0;
+        double requests_per_second = 0;
+        std::map<int, size_t> status_codes;
+        ReplayLatency latency;
+        ReplayLatency service_time;
+    };
+
+    namespace replay_detail
+    {
+        inline ReplayLatency percentiles(std::vector<uint64_t> &values_ns)
+        {
+            ReplayLatency result;
+            if (values_ns.empty())
+                return result;
+            std::sort(values_ns.begin(), values_ns.end());
+            auto at = [&values_ns](double percentile)
+            {
+                size_t index = static_cast<size_t>(percentile / 100.0 * (values_ns.size() - 1) + 0.5);
+                return values_ns[std::min(index, values_ns.size() - 1)] / 1e3;
+            };
+            result.p50 = at(50);
+            result.p90 = at(90);
+            result.p99 = at(99);
+            result.p99_9 = at(99.9);
+            result.max = values_ns.back() / 1e3;
+            return result;
+        }
+    }
+
+    /// @brief Replay a capture through an application on the calling thread.
+    /// Requests are dispatched at their captured arrival times divided by the speed; when a request is late because the previous one was slow it is sent immediately and its latency counts the delay.
+    /// @param app Application to replay into. Routes and middlewares must be registered.
+    /// @param path Capture file written by traffic_capture.
+    /// @param config Replay speed and limit.
+    /// @return Throughput, status codes and latency percentiles of the replay.
+    /// @throws CaptureException if the file cannot be opened, CaptureFormatException if a record is invalid.
+    inline ReplayReport replay_capture(Enderman &app, const std::string &path, const ReplayConfig &config = ReplayConfig{})
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            throw CaptureException("Unable to open capture file " + path);
+
+        // Load the whole capture first, so that replaying into an application that is itself capturing to the same file terminates.
+        std::vector<CaptureRecord> records;
+        std::string line;
+        size_t line_number = 0;
+        while (std::getline(file, line))
+        {
+            ++line_number;
+            if (line.empty())
+                continue;
+            if (config.max_records && records.size() >= config.max_records)
+                break;
+            try
+            {
+                records.push_back(decode_capture_record(line));
+            }
+            catch (const std::exception &e)
+            {
+                throw CaptureFormatException(path + ":" + std::to_string(line_number) + ": " + e.what());
+            }
+        }
+        // Records are written in the order they got the capture lock, which can differ slightly from arrival order.
+        std::stable_sort(records.begin(), records.end(), [](const CaptureRecord &a, const CaptureRecord &b)
+                         { return a.offset_us < b.offset_us; });
+
+        Loopback loopback(app);
+        ReplayReport report;
+        std::vector<uint64_t> latencies;
+        std::vector<uint64_t> service_times;
+        latencies.reserve(records.size());
+        service_times.reserve(records.size());
+
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point start = Clock::now();
+        for (auto &record : records)
+        {
+            LoopbackRequest request;
+            request.method = std::move(record.method);
+            request.uri = std::move(record.uri);
+            if (!record.ip.empty())
+                request.ip = std::move(record.ip);
+            for (auto &header : record.headers)
+                request.headers[header.first] = std::move(header.second);
+            request.body.assign(record.body.begin(), record.body.end());
+
+            Clock::time_point scheduled = Clock::now();
+            if (config.speed > 0)
+            {
+                scheduled = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(record.offset_us / config.speed));
+                std::this_thread::sleep_until(scheduled);
+            }
+            Clock::time_point sent = Clock::now();
+            LoopbackResponse response = loopback.dispatch(request);
+            Clock::time_point done = Clock::now();
+
+            latencies.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(done - scheduled).count()));
+            service_times.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(done - sent).count()));
+            ++report.status_codes[response.status_code];
+            ++report.requests;
+        }
+
+        report.elapsed_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        report.requests_per_second = report.elapsed_seconds > 0 ? report.requests / report.elapsed_seconds : 0;
+        report.latency = replay_detail::percentiles(latencies);
+        report.service_time = replay_detail::percentiles(service_times);
+        return report;
+    }
+}
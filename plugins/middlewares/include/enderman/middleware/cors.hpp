@@ -53,12 +53,13 @@ namespace enderman
     {
         return [config](Request &req, Response &res, const Next &next)
         {
-            if (req.headers().find("origin") == req.headers().end())
+            auto origin_it = req.headers().find(WellKnownHeader::ORIGIN);
+            if (origin_it == req.headers().end())
             {
                 next(nullptr);
                 return;
             }
-            std::string origin = req.headers().at("origin");
+            std::string origin(origin_it->second);
 
             bool origin_allowed = false;
             if (config.allowed_origins.empty())
@@ -97,7 +97,21 @@ namespace enderman
             return std::string("application/octet-stream");
         };
 
-        return [get_mime_type, base_path](Request &req, Response &res, const Next &next)
+        // Reads the file straight into the body at its final size; the body hands the same buffer to the transport.
+        auto read_file = [](const std::filesystem::path &file_path, BinaryBody &body)
+        {
+            std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+            if (!file)
+                return false;
+            std::streamoff size = file.tellg();
+            if (size < 0)
+                return false;
+            body.data.resize(static_cast<size_t>(size));
+            file.seekg(0);
+            return static_cast<bool>(file.read(body.data.data(), size));
+        };
+
+        return [get_mime_type, read_file, base_path](Request &req, Response &res, const Next &next)
         {
             try
             {
@@ -117,12 +131,9 @@ namespace enderman
                 {
                     if (std::filesystem::is_regular_file(file_path))
                     {
-                        std::ifstream file(file_path, std::ios::binary);
-                        if (file)
+                        std::shared_ptr<BinaryBody> body = std::make_shared<BinaryBody>();
+                        if (read_file(file_path, *body))
                         {
-                            std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-                            std::shared_ptr<BinaryBody> body = std::make_shared<BinaryBody>();
-                            body->move_data(std::move(data));
                             body->content_type = get_mime_type(file_path);
                             res.set_body(body).send();
                         }
@@ -136,12 +147,9 @@ namespace enderman
                         std::filesystem::path index_file = file_path / "index.html";
                         if (std::filesystem::exists(index_file) && std::filesystem::is_regular_file(index_file))
                         {
-                            std::ifstream file(index_file, std::ios::binary);
-                            if (file)
+                            std::shared_ptr<BinaryBody> body = std::make_shared<BinaryBody>();
+                            if (read_file(index_file, *body))
                             {
-                                std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-                                std::shared_ptr<BinaryBody> body = std::make_shared<BinaryBody>();
-                                body->move_data(std::move(data));
                                 body->content_type = get_mime_type(index_file);
                                 res.set_body(body).send();
                             }
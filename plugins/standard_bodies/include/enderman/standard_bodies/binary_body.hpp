@@ -40,6 +40,14 @@ namespace enderman
             return data;
         }
 
+        bool buffers(std::vector<ConstBuffer> &out) const override
+        {
+            out.push_back(ConstBuffer{data.data(), data.size()});
+            return true;
+        }
+
+        std::optional<size_t> content_length() const override { return data.size(); }
+
         const std::string type() const override
         {
             return content_type;
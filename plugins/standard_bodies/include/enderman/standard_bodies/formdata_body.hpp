@@ -9,6 +9,7 @@
 #include "enderman/body.hpp"
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <vector>
 #include <iomanip>
@@ -27,7 +28,12 @@ namespace enderman
 
         void parse_from(const std::vector<char> &body)
         {
-            std::string str(body.begin(), body.end());
+            parse_from(std::string_view(body.data(), body.size()));
+        }
+
+        void parse_from(std::string_view body)
+        {
+            std::string str(body);
             std::istringstream ss(str);
             std::string pair;
             while (std::getline(ss, pair, '&'))
@@ -114,26 +120,15 @@ namespace enderman
         }
     };
 
-    /// @brief Middleware function to parse URL-encoded form data request bodies. It checks the Content-Type header of the request and if it is "application/x-www-form-urlencoded", it parses the body as a UrlEncodedFormDataBody and replaces the original RawBody with the parsed UrlEncodedFormDataBody in the request.
+    /// @brief Middleware function to parse URL-encoded form data request bodies. It checks the Content-Type header of the request and if it is "application/x-www-form-urlencoded", it parses the body as a UrlEncodedFormDataBody and replaces the original body, in memory or spooled to a file, with the parsed UrlEncodedFormDataBody in the request.
     MiddlewareFunction url_encoded_formdata_parser = MiddlewareFunction(
         [](Request &req, Response &res, Next next)
         {
-            auto content_type_it = req.headers().find("content-type");
-            if (content_type_it != req.headers().end())
+            if (req.media_type().matches("application/x-www-form-urlencoded"))
             {
-                std::string content_type = content_type_it->second;
-                content_type = content_type_it->second;
-                auto sem = content_type.find(';');
-                if (sem != std::string::npos)
-                    content_type = content_type.substr(0, sem);
-                for (auto &c : content_type)
-                    c = std::tolower(c);
-                if (content_type == "application/x-www-form-urlencoded")
-                {
-                    std::shared_ptr<UrlEncodedFormDataBody> formdata_body = std::make_shared<UrlEncodedFormDataBody>();
-                    formdata_body->parse_from(req.get_body()->as<RawBody>()->data);
-                    req.set_body(formdata_body);
-                }
+                std::shared_ptr<UrlEncodedFormDataBody> formdata_body = std::make_shared<UrlEncodedFormDataBody>();
+                formdata_body->parse_from(read_body(*req.body_reader()));
+                req.set_body(formdata_body);
             }
             next(nullptr);
         });
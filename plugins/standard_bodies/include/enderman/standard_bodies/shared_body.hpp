@@ -0,0 +1,90 @@
+/// @file shared_body.hpp
+/// @brief Body backed by an immutable reference counted buffer, for payloads sent by many responses at once.
+
+#pragma once
+
+#include "enderman/body.hpp"
+#include "enderman/response.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace enderman
+{
+    /// @brief Immutable bytes shared between bodies.
+    using SharedBuffer = std::shared_ptr<const std::vector<char>>;
+
+    /// @brief SharedBody class that inherits from Body and serves an immutable buffer without copying it.
+    /// Neither the buffer nor the body is ever modified, so one SharedBody can be set on any number of responses, on any thread, e.g. to cache a hot payload.
+    class SharedBody : public Body
+    {
+    private:
+        SharedBuffer buffer;
+        std::string content_type;
+
+    public:
+        /// @param shared_buffer Bytes of the body. nullptr for an empty body.
+        /// @param type Content type of the body.
+        explicit SharedBody(SharedBuffer shared_buffer, const std::string &type = "application/octet-stream")
+            : buffer(std::move(shared_buffer)), content_type(type) {}
+
+        /// @brief Create a shared buffer from bytes, taking them over without copying.
+        static SharedBuffer make_buffer(std::vector<char> data)
+        {
+            return std::make_shared<const std::vector<char>>(std::move(data));
+        }
+        /// @brief Create a shared buffer from a string.
+        static SharedBuffer make_buffer(const std::string &data)
+        {
+            return std::make_shared<const std::vector<char>>(data.begin(), data.end());
+        }
+
+        /// @brief Get the buffer of the body.
+        const SharedBuffer &shared_buffer() const { return buffer; }
+
+        std::vector<char> serialize() const override
+        {
+            return buffer ? *buffer : std::vector<char>();
+        }
+
+        const std::string type() const override { return content_type; }
+
+        bool buffers(std::vector<ConstBuffer> &out) const override
+        {
+            if (buffer)
+                out.push_back(ConstBuffer{buffer->data(), buffer->size()});
+            return true;
+        }
+
+        std::optional<size_t> content_length() const override { return buffer ? buffer->size() : 0; }
+
+        std::unique_ptr<BodyReader> reader() const override
+        {
+            return std::make_unique<MemoryBodyReader>(buffer ? std::string_view(buffer->data(), buffer->size()) : std::string_view());
+        }
+
+        /// @brief Sets a shared body on the response. The body is shared, not copied.
+        /// @param res The response object to set the body on.
+        /// @param body Body to send, e.g. one built once at startup.
+        /// @return The response object with the body set.
+        static Response &set_shared(Response &res, const std::shared_ptr<const SharedBody> &body)
+        {
+            res.set_body(std::const_pointer_cast<SharedBody>(body));
+            return res;
+        }
+
+        /// @brief Creates a SharedBody referencing the buffer and sets it as the body of the response.
+        /// @param res The response object to set the body on.
+        /// @param shared_buffer Bytes to send. Only the reference count changes.
+        /// @param content_type The content type of the bytes.
+        /// @return The response object with the new body set.
+        static Response &set_shared(Response &res, SharedBuffer shared_buffer, const std::string &content_type = "application/octet-stream")
+        {
+            res.set_body(std::make_shared<SharedBody>(std::move(shared_buffer), content_type));
+            return res;
+        }
+    };
+}
@@ -5,4 +5,5 @@
 
 #include "formdata_body.hpp"
 #include "text_body.hpp"
-#include "binary_body.hpp"
\ No newline at end of file
+#include "binary_body.hpp"
+#include "shared_body.hpp"
\ No newline at end of file
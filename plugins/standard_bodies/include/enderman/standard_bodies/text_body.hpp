@@ -9,6 +9,7 @@
 #include "enderman/body.hpp"
 
 #include <string>
+#include <string_view>
 #include <cctype>
 #include <unordered_set>
 #include <memory>
@@ -44,11 +45,24 @@ namespace enderman
             text = std::string(body.begin(), body.end());
         }
 
+        void parse_from(std::string_view body)
+        {
+            text.assign(body.data(), body.size());
+        }
+
         std::vector<char> serialize() const override
         {
             return std::vector<char>(text.begin(), text.end());
         }
 
+        bool buffers(std::vector<ConstBuffer> &out) const override
+        {
+            out.push_back(ConstBuffer{text.data(), text.size()});
+            return true;
+        }
+
+        std::optional<size_t> content_length() const override { return text.size(); }
+
         const std::string type() const override { return content_type; }
 
         /// @brief Creates a new TextBody with the given text (text/plain) and sets it as the body of the response.
@@ -89,24 +103,20 @@ namespace enderman
         }
     };
 
-    /// @brief Middleware function to parse text-based request bodies. It checks the Content-Type header of the request and if it matches one of the supported text types, it parses the body as a TextBody and replaces the original RawBody with the parsed TextBody in the request.
+    /// @brief Middleware function to parse text-based request bodies. It checks the Content-Type header of the request and if it matches one of the supported text types, it parses the body as a TextBody and replaces the original body, in memory or spooled to a file, with the parsed TextBody in the request.
     MiddlewareFunction text_body_parser = MiddlewareFunction(
         [](Request &req, Response &res, Next next)
         {
-            auto content_type_it = req.headers().find("content-type");
-            if (content_type_it != req.headers().end())
+            const MediaType &media_type = req.media_type();
+            if (!media_type.empty())
             {
-                std::string content_type = content_type_it->second;
-                content_type = content_type_it->second;
-                auto sem = content_type.find(';');
-                if (sem != std::string::npos)
-                    content_type = content_type.substr(0, sem);
+                std::string content_type(media_type.essence);
                 for (auto &c : content_type)
                     c = std::tolower(c);
                 if (text_types.find(content_type) != text_types.end())
                 {
                     std::shared_ptr<TextBody> text_body = std::make_shared<TextBody>(content_type);
-                    text_body->parse_from(req.get_body()->as<RawBody>()->data);
+                    text_body->text = read_body(*req.body_reader());
                     req.set_body(text_body);
                 }
             }
@@ -117,19 +127,15 @@ namespace enderman
     MiddlewareFunction text_body_parser_forced_parsing = MiddlewareFunction(
         [](Request &req, Response &res, Next next)
         {
-            auto content_type_it = req.headers().find("content-type");
             std::string content_type = "text/plain";
-            if (content_type_it != req.headers().end())
+            if (!req.media_type().empty())
             {
-                content_type = content_type_it->second;
-                auto sem = content_type.find(';');
-                if (sem != std::string::npos)
-                    content_type = content_type.substr(0, sem);
+                content_type = req.media_type().essence;
                 for (auto &c : content_type)
                     c = std::tolower(c);
             }
             std::shared_ptr<TextBody> text_body = std::make_shared<TextBody>(content_type);
-            text_body->parse_from(req.get_body()->as<RawBody>()->data);
+            text_body->text = read_body(*req.body_reader());
             req.set_body(text_body);
             next(nullptr);
         });
@@ -0,0 +1,61 @@
+#include "bulkhead.hpp"
+
+#include <utility>
+
+bool enderman::Bulkhead::try_enter()
+{
+    size_t current = running.load();
+    while (current < limit)
+    {
+        if (running.compare_exchange_weak(current, current + 1))
+            return true;
+    }
+    return false;
+}
+
+enderman::Bulkhead::Admission enderman::Bulkhead::enter_or_queue(std::function<void()> resume)
+{
+    if (try_enter())
+        return Admission::ENTERED;
+    if (queue_limit == 0)
+        return Admission::REJECTED;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (waiters.size() >= queue_limit)
+        return Admission::REJECTED;
+    // Announce the wait before trying again: a request leaving in between either sees it or frees the slot taken here.
+    waiting.fetch_add(1);
+    if (try_enter())
+    {
+        waiting.fetch_sub(1);
+        return Admission::ENTERED;
+    }
+    waiters.push_back(std::move(resume));
+    return Admission::QUEUED;
+}
+
+void enderman::Bulkhead::leave()
+{
+    running.fetch_sub(1);
+    // Take the slot back for a waiting request, unless another request took it first.
+    while (waiting.load() > 0 && try_enter())
+    {
+        std::function<void()> resume;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!waiters.empty())
+            {
+                resume = std::move(waiters.front());
+                waiters.pop_front();
+                waiting.fetch_sub(1);
+            }
+        }
+        if (!resume)
+        {
+            // The waiter found a slot itself meanwhile. Give this one back and look again, for a request that queued since.
+            running.fetch_sub(1);
+            continue;
+        }
+        resume();
+        return;
+    }
+}
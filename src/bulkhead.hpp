@@ -0,0 +1,57 @@
+#ifndef ENDERMAN_BULKHEAD_HPP
+#define ENDERMAN_BULKHEAD_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace enderman
+{
+    /// @brief Limit on the requests of a route, or of a group of routes, whose handler runs at once, see RouteOptions::max_in_flight.
+    /// Taking and leaving a slot are lock-free while the limit is not reached; only requests waiting for a slot take the mutex.
+    /// A leaving request hands its slot straight to the oldest waiting one.
+    class Bulkhead
+    {
+    public:
+        enum class Admission
+        {
+            /// @brief A slot was taken.
+            ENTERED,
+            /// @brief The request waits; it gets a slot when its resume function is called.
+            QUEUED,
+            /// @brief All slots are taken and the queue is full.
+            REJECTED,
+        };
+
+    private:
+        const size_t limit;
+        const size_t queue_limit;
+        std::atomic<size_t> running{0};
+        /// @brief Waiting requests, counted before they are queued so a leaving request does not miss one.
+        std::atomic<size_t> waiting{0};
+        std::mutex mutex;
+        std::deque<std::function<void()>> waiters;
+
+    public:
+        /// @param max_in_flight Most requests running at once, at least 1.
+        /// @param max_queued Most requests waiting for a slot.
+        Bulkhead(size_t max_in_flight, size_t max_queued) : limit(max_in_flight), queue_limit(max_queued) {}
+        Bulkhead(const Bulkhead &) = delete;
+        Bulkhead &operator=(const Bulkhead &) = delete;
+
+        /// @brief Take a slot, or queue resume to be called with a slot once one is free, from the thread leaving it.
+        Admission enter_or_queue(std::function<void()> resume);
+        /// @brief Take a slot if one is free, for requests handled in place, which never wait.
+        /// @return False if all slots are taken.
+        bool try_enter();
+        /// @brief Give a slot back, to the oldest waiting request if there is one.
+        void leave();
+
+        size_t in_flight() const { return running.load(std::memory_order_relaxed); }
+        size_t queued() const { return waiting.load(std::memory_order_relaxed); }
+    };
+}
+
+#endif // ENDERMAN_BULKHEAD_HPP
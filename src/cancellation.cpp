@@ -0,0 +1,168 @@
+#include "cancellation_source.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace enderman
+{
+    namespace detail
+    {
+        struct CancellationState
+        {
+            /// @brief Read without the mutex by is_cancelled(), written with it.
+            std::atomic<CancellationReason> reason{CancellationReason::NONE};
+            std::mutex mutex;
+            std::condition_variable cancelled;
+            std::vector<std::function<void()>> callbacks;
+        };
+    }
+}
+
+bool enderman::CancellationToken::is_cancelled() const
+{
+    if (state && state->reason.load(std::memory_order_acquire) != CancellationReason::NONE)
+        return true;
+    return _deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= _deadline;
+}
+
+enderman::CancellationReason enderman::CancellationToken::reason() const
+{
+    if (state)
+    {
+        CancellationReason reason = state->reason.load(std::memory_order_acquire);
+        if (reason != CancellationReason::NONE)
+            return reason;
+    }
+    if (_deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= _deadline)
+        return CancellationReason::DEADLINE;
+    return CancellationReason::NONE;
+}
+
+void enderman::CancellationToken::throw_if_cancelled() const
+{
+    CancellationReason cancelled = reason();
+    if (cancelled != CancellationReason::NONE)
+        throw RequestCancelledException(cancelled);
+}
+
+void enderman::CancellationToken::on_cancel(std::function<void()> callback) const
+{
+    if (!state)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->reason.load(std::memory_order_relaxed) == CancellationReason::NONE)
+        {
+            state->callbacks.push_back(std::move(callback));
+            return;
+        }
+    }
+    callback();
+}
+
+enderman::CancellationToken enderman::CancellationSource::deadline_only(std::chrono::steady_clock::time_point deadline)
+{
+    return CancellationToken(nullptr, deadline);
+}
+
+enderman::CancellationToken enderman::CancellationSource::cancellable(std::chrono::steady_clock::time_point deadline)
+{
+    return CancellationToken(std::make_shared<detail::CancellationState>(), deadline);
+}
+
+void enderman::CancellationSource::cancel(const CancellationToken &token, CancellationReason reason)
+{
+    detail::CancellationState *state = token.state.get();
+    if (!state)
+        return;
+    std::vector<std::function<void()>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->reason.load(std::memory_order_relaxed) != CancellationReason::NONE)
+            return;
+        state->reason.store(reason, std::memory_order_release);
+        callbacks.swap(state->callbacks);
+    }
+    state->cancelled.notify_all();
+    // Outside the lock, so a callback may look at the token again.
+    for (auto &callback : callbacks)
+        callback();
+}
+
+bool enderman::CancellationSource::wait(const CancellationToken &token, std::chrono::steady_clock::time_point until)
+{
+    auto limit = std::min(until, token._deadline);
+    detail::CancellationState *state = token.state.get();
+    if (!state)
+    {
+        if (limit != std::chrono::steady_clock::time_point::max())
+            std::this_thread::sleep_until(limit);
+        return token.is_cancelled();
+    }
+    auto cancelled = [state]
+    { return state->reason.load(std::memory_order_relaxed) != CancellationReason::NONE; };
+    std::unique_lock<std::mutex> lock(state->mutex);
+    if (limit == std::chrono::steady_clock::time_point::max())
+        state->cancelled.wait(lock, cancelled);
+    else
+        state->cancelled.wait_until(lock, limit, cancelled);
+    lock.unlock();
+    return token.is_cancelled();
+}
+
+std::optional<std::chrono::milliseconds> enderman::CancellationSource::parse_timeout(std::string_view value)
+{
+    const char *begin = value.data();
+    const char *end = begin + value.size();
+    uint64_t seconds = 0;
+    auto result = std::from_chars(begin, end, seconds);
+    if (result.ec == std::errc::result_out_of_range)
+        return std::nullopt;
+    bool has_digits = result.ec == std::errc();
+    if (!has_digits)
+        seconds = 0;
+    const char *cursor = result.ptr;
+    uint64_t millis = 0;
+    if (cursor != end && *cursor == '.')
+    {
+        uint64_t scale = 100;
+        for (++cursor; cursor != end && *cursor >= '0' && *cursor <= '9'; ++cursor)
+        {
+            millis += static_cast<uint64_t>(*cursor - '0') * scale;
+            scale /= 10;
+            has_digits = true;
+        }
+    }
+    if (!has_digits || cursor != end)
+        return std::nullopt;
+    constexpr uint64_t max_seconds = std::chrono::duration_cast<std::chrono::seconds>(MAX_REQUESTED_TIMEOUT).count();
+    if (seconds > max_seconds)
+        return std::nullopt;
+    std::chrono::milliseconds timeout(seconds * 1000 + millis);
+    if (timeout.count() <= 0 || timeout > MAX_REQUESTED_TIMEOUT)
+        return std::nullopt;
+    return timeout;
+}
+
+std::chrono::steady_clock::time_point enderman::CancellationSource::deadline_for(std::chrono::steady_clock::time_point arrival,
+                                                                                 std::chrono::milliseconds timeout,
+                                                                                 std::string_view requested)
+{
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    if (timeout.count() > 0)
+        deadline = arrival + timeout;
+    if (!requested.empty())
+    {
+        if (std::optional<std::chrono::milliseconds> shorter = parse_timeout(requested))
+            deadline = std::min(deadline, arrival + *shorter);
+    }
+    return deadline;
+}
@@ -0,0 +1,45 @@
+#ifndef ENDERMAN_CANCELLATION_SOURCE_HPP
+#define ENDERMAN_CANCELLATION_SOURCE_HPP
+
+#include "enderman/cancellation.hpp"
+
+#include <chrono>
+#include <optional>
+#include <string_view>
+
+namespace enderman
+{
+    /// @brief The framework's side of CancellationToken: creates tokens and cancels them.
+    class CancellationSource
+    {
+    public:
+        /// @brief Longest timeout accepted from a client, so the deadline cannot overflow.
+        static constexpr std::chrono::hours MAX_REQUESTED_TIMEOUT{24};
+
+        /// @brief Token only cancelled by its deadline, without any allocation. For requests handled in place, where nobody could run callbacks.
+        static CancellationToken deadline_only(std::chrono::steady_clock::time_point deadline);
+        /// @brief Token the framework can cancel, for requests whose handler runs while the transport goes on.
+        static CancellationToken cancellable(std::chrono::steady_clock::time_point deadline);
+        /// @brief Cancel a token and run its callbacks on the calling thread. Only the first cancellation counts. No-op for tokens without state.
+        static void cancel(const CancellationToken &token, CancellationReason reason);
+        /// @brief Check if two tokens observe the same request.
+        static bool same(const CancellationToken &a, const CancellationToken &b) { return a.state == b.state; }
+        /// @brief Block until a token is cancelled, its deadline passes or until passes, for awaitables completing in place.
+        /// @return True if the token is cancelled.
+        static bool wait(const CancellationToken &token, std::chrono::steady_clock::time_point until);
+
+        /// @brief Parse a timeout requested by a client: seconds, optionally with a fraction, e.g. "2" or "0.25".
+        /// @return Timeout in milliseconds, nullopt if the value is malformed, not positive or longer than MAX_REQUESTED_TIMEOUT.
+        static std::optional<std::chrono::milliseconds> parse_timeout(std::string_view value);
+        /// @brief Deadline of a request: the configured timeout after its arrival, shortened by the timeout its client requested.
+        /// Clients can only shorten the timeout, not extend it.
+        /// @param timeout Timeout of its route or the server, 0 for none.
+        /// @param requested Value of the timeout header, empty if the client sent none.
+        /// @return Deadline, time_point::max() for none.
+        static std::chrono::steady_clock::time_point deadline_for(std::chrono::steady_clock::time_point arrival,
+                                                                  std::chrono::milliseconds timeout,
+                                                                  std::string_view requested);
+    };
+}
+
+#endif // ENDERMAN_CANCELLATION_SOURCE_HPP
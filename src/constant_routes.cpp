@@ -0,0 +1,99 @@
+#include "constant_routes.hpp"
+
+#include "utils.hpp"
+
+void enderman::ConstantRoutes::add(HttpMethod method, std::shared_ptr<const ConstantResponse> response)
+{
+    auto &routes = by_method[static_cast<size_t>(method)];
+    std::string_view path = response->path;
+    auto it = routes.find(path);
+    if (it != routes.end())
+    {
+        // The old key views the path of the response being replaced.
+        routes.erase(it);
+        --count;
+    }
+    routes.emplace(path, std::move(response));
+    ++count;
+}
+
+std::optional<enderman::HttpMethod> enderman::ConstantRoutes::parse_method(std::string_view method)
+{
+    if (method == "GET")
+        return HttpMethod::GET;
+    if (method == "POST")
+        return HttpMethod::POST;
+    if (method == "PUT")
+        return HttpMethod::PUT;
+    if (method == "DELETE")
+        return HttpMethod::DELETE;
+    if (method == "PATCH")
+        return HttpMethod::PATCH;
+    if (method == "OPTIONS")
+        return HttpMethod::OPTIONS;
+    if (method == "HEAD")
+        return HttpMethod::HEAD;
+    return std::nullopt;
+}
+
+const enderman::ConstantResponse *enderman::ConstantRoutes::find(std::string_view method, std::string_view uri) const
+{
+    if (count == 0)
+        return nullptr;
+    std::optional<HttpMethod> parsed = parse_method(method);
+    if (!parsed)
+        return nullptr;
+    const auto &routes = by_method[static_cast<size_t>(*parsed)];
+    if (routes.empty())
+        return nullptr;
+    std::string_view path = uri.substr(0, uri.find_first_of("?#"));
+    if (is_normalized(path))
+    {
+        auto it = routes.find(path);
+        return it == routes.end() ? nullptr : it->second.get();
+    }
+    std::string normalized;
+    try
+    {
+        // Without the query, which the router parses but a constant response ignores.
+        std::vector<std::string> segments = utils::UriParser::parse_uri(path).path_segments;
+        for (const auto &segment : segments)
+        {
+            // An encoded slash stays within its segment for the router, so no registered path can match it.
+            if (segment.find('/') != std::string::npos)
+                return nullptr;
+        }
+        normalized = utils::PathTools::build_path(segments);
+    }
+    catch (const utils::UriParser::InvalidURIException &)
+    {
+        return nullptr;
+    }
+    auto it = routes.find(normalized);
+    return it == routes.end() ? nullptr : it->second.get();
+}
+
+bool enderman::ConstantRoutes::is_normalized(std::string_view path)
+{
+    if (path.empty() || path[0] != '/')
+        return false;
+    if (path.size() == 1)
+        return true;
+    size_t start = 1;
+    while (start <= path.size())
+    {
+        size_t end = path.find('/', start);
+        if (end == std::string_view::npos)
+            end = path.size();
+        std::string_view segment = path.substr(start, end - start);
+        if (segment.empty() || segment == "." || segment == "..")
+            return false;
+        for (unsigned char c : segment)
+        {
+            if (c == '%' || c == '+' || c == '\\' || c < 0x20 || c == 0x7f)
+                return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
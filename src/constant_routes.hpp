@@ -0,0 +1,86 @@
+#ifndef ENDERMAN_CONSTANT_ROUTES_HPP
+#define ENDERMAN_CONSTANT_ROUTES_HPP
+
+#include "enderman/constants.hpp"
+#include "enderman/body.hpp"
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace enderman
+{
+    /// @brief Response registered with Enderman::constant(), rendered once at registration.
+    struct ConstantResponse
+    {
+        /// @brief Normalized path the response is registered for, e.g. "/health".
+        std::string path;
+        int status_code = 200;
+        std::string reason;
+        /// @brief Headers as passed to constant(), plus Content-Type if none was given.
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::vector<char> body;
+        /// @brief The complete HTTP/1.1 message except the Date header, handed to transports that write bytes.
+        std::string serialized;
+        /// @brief Position in serialized right after the status line, where headers added per request are spliced in.
+        size_t headers_offset = 0;
+        /// @brief Position in serialized where the current Date header is spliced in, std::string::npos if the response sets its own Date.
+        size_t date_offset = std::string::npos;
+        /// @brief The response has a Connection: close header, so its connection closes after it.
+        bool closes = false;
+    };
+
+    /// @brief Body viewing the body of a constant response, used when a constant is answered through the regular route.
+    class ConstantBody : public Body
+    {
+    private:
+        std::shared_ptr<const ConstantResponse> response;
+        std::string content_type;
+
+    public:
+        ConstantBody(std::shared_ptr<const ConstantResponse> constant_response, std::string type)
+            : response(std::move(constant_response)), content_type(std::move(type)) {}
+
+        std::vector<char> serialize() const override { return response->body; }
+        const std::string type() const override { return content_type; }
+        bool buffers(std::vector<ConstBuffer> &out) const override
+        {
+            out.push_back(ConstBuffer{response->body.data(), response->body.size()});
+            return true;
+        }
+        std::optional<size_t> content_length() const override { return response->body.size(); }
+    };
+
+    /// @brief Constant responses by method and normalized path. Filled before the server starts, read only afterwards.
+    class ConstantRoutes
+    {
+    private:
+        static constexpr size_t METHOD_COUNT = static_cast<size_t>(HttpMethod::HEAD) + 1;
+        /// @brief Keys view the path of their response.
+        std::array<std::unordered_map<std::string_view, std::shared_ptr<const ConstantResponse>>, METHOD_COUNT> by_method;
+        size_t count = 0;
+
+        static std::optional<HttpMethod> parse_method(std::string_view method);
+        /// @brief Check if a path is spelled the way paths are registered: no empty, dot or percent-encoded segments and no trailing slash.
+        static bool is_normalized(std::string_view path);
+
+    public:
+        /// @brief Register a response, replacing an earlier one for the same method and path.
+        void add(HttpMethod method, std::shared_ptr<const ConstantResponse> response);
+        /// @brief Find the response for a request as received from the transport.
+        /// @param method Method as on the request line, e.g. "GET".
+        /// @param uri Raw URI. The query string is ignored; the path is normalized and decoded like the router does, e.g. /health/ and /./health find /health.
+        /// Only paths spelled differently from the registered one pay for the normalization.
+        /// @return Matching response or nullptr, also for paths the router rejects, which then get its error response.
+        const ConstantResponse *find(std::string_view method, std::string_view uri) const;
+        bool empty() const { return count == 0; }
+    };
+}
+
+#endif // ENDERMAN_CONSTANT_ROUTES_HPP
@@ -3,20 +3,38 @@
 #include "enderman/enderman.hpp"
 #include "enderman/request.hpp"
 #include "enderman/response.hpp"
+#include "enderman/body.hpp"
 
 #include "http/http_adapter.hpp"
+#include "net/server.hpp"
 
 #include "utils.hpp"
 #include "middleware.hpp"
 #include "route_handler.hpp"
 #include "request_builder.hpp"
-
+#include "loop_monitor.hpp"
+#include "constant_routes.hpp"
+#include "response_writer.hpp"
+#include "http/response_head.hpp"
+#include "event_loop.hpp"
+#include "executor.hpp"
+#include "bulkhead.hpp"
+#include "cancellation_source.hpp"
+
+#include <algorithm>
 #include <functional>
 #include <stdexcept>
 #include <vector>
 #include <utility>
 #include <unordered_map>
 #include <iostream>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <system_error>
 
 namespace enderman
 {
@@ -24,7 +42,37 @@ namespace enderman
     {
         std::vector<Middleware> middlewares;
         std::unordered_map<enderman::HttpMethod, std::vector<RouteHandler>> route_handlers;
-
+        LoopMonitor loop_monitor;
+        RouteOptions route_defaults;
+        /// @brief True once a route or the defaults set an option, so transports can skip looking them up otherwise.
+        bool has_route_options = false;
+        /// @brief True once a route or the defaults offload handlers, so the server loops start the executor.
+        bool has_offloaded_routes = false;
+        /// @brief True once an asynchronous route handler is registered.
+        bool has_async_routes = false;
+        ConstantRoutes constants;
+        /// @brief Bulkheads shared by name, see RouteOptions::bulkhead.
+        std::unordered_map<std::string, std::shared_ptr<Bulkhead>> bulkheads;
+        /// @brief Timeout of the routes without one and the header shortening it, from the options of listen().
+        std::chrono::milliseconds request_timeout{0};
+        std::string timeout_header = ServerOptions().timeout_header;
+
+        /// @brief Run the whole pipeline for a request: build it, run the middlewares and the route handler.
+        /// This is the entry point used by every transport. Errors are turned into 400/500 responses.
+        /// @param req Request handed over by the transport.
+        /// @param res Response to be filled and written back by the transport.
+        void handle_request(Request &req, Response &res);
+        /// @brief Run the whole pipeline for a request whose route handler may finish after it returns.
+        /// Used by the server loops for asynchronous routes, which resume on the loop while the connection waits.
+        /// @param done Called once the response is ready, possibly before this returns, possibly from another thread.
+        void handle_request_async(Request &req, Response &res, std::function<void()> done);
+        /// @brief Run the whole pipeline for a request of an offloaded route on an executor worker.
+        /// A request waiting for the bulkhead of its route does not hold the worker: it is submitted to the executor again once it gets a slot.
+        /// @param done Called once the response is ready, possibly from another worker.
+        void handle_request_offloaded(Request &req, Response &res, std::function<void()> done);
+        /// @brief Build the request, check its body against the limit of its route and run the middlewares.
+        /// @return True if the route handler has to run, false if the response is already complete.
+        bool prepare_request(Request &req, Response &res);
         /// @brief Run middlewares in order for the given request and response.
         /// Middlewares are run in the order they were registered.
         /// A Middleware will run if the registered path for the middleware is prefix of request's base paths.
@@ -36,9 +84,43 @@ namespace enderman
         /// @param req Request object to be processed by the route handler.
         /// @param res Response object to be processed by the route handler.
         void run_route_handler(Request &req, Response &res);
+        /// @brief Run the route handler of a request holding a slot of the route's bulkhead, if it has one, and give the slot back.
+        /// Requests cancelled while they waited for the slot are answered with 504 instead.
+        void run_admitted_route_handler(const RouteHandler &route_handler, Request &req, Response &res);
+        /// @brief Start an asynchronous route handler whose request holds a slot of the route's bulkhead, if it has one.
+        /// @param finish Called once the response is ready; the slot is given back before.
+        void start_async_route_handler(const RouteHandler &route_handler, Request &req, Response &res, std::function<void()> finish);
+        /// @brief Give the route its bulkhead from its options merged with the defaults.
+        void assign_bulkhead(RouteHandler &route_handler);
+        /// @brief Answer a request rejected by the bulkhead of its route.
+        static void reject_overloaded(Response &res);
+        /// @brief Give a request its deadline, unless the transport did, from the timeout of its route and the header of its client.
+        void set_deadline(Request &req, std::chrono::milliseconds route_timeout) const;
+        /// @brief Answer a request cancelled before its handler produced a response.
+        static void reject_cancelled(Response &res);
+        /// @brief Run an asynchronous route handler and wait for it, for transports that need the response when the handler returns.
+        /// No loop is current meanwhile, so the awaitables of coroutine handlers complete in place. The request is cancelled once its deadline passes.
+        static void run_async_route_handler_inline(const RouteHandler &route_handler, Request &req, Response &res);
+        /// @brief Set the path parameters and the relative path of a request for the route handling it.
+        static void set_route_params(Request &req, const RouteHandler &route_handler);
         /// @brief Set the base path, base path segments, and query parameters for the given request object.
         /// @param req Request object to be built.
         void build_request(Request &req);
+        /// @brief Find the route handler matching the method and the base path of a built request.
+        /// @return Matching route handler or nullptr.
+        const RouteHandler *find_route(const Request &req) const;
+        /// @brief Find the route handler matching a method and path segments.
+        const RouteHandler *find_route(HttpMethod method, const std::vector<std::string> &path_segments) const;
+        /// @brief Find the route a request is going to from its raw URI, with its options merged with the defaults.
+        /// Transports that read bodies themselves use it to enforce limits before reading the body and to run asynchronous handlers.
+        RouteMatch match_route(HttpMethod method, std::string_view raw_uri) const;
+        /// @brief Run the application on the Http-Server transport.
+        void listen_http_server(unsigned short port, const ServerOptions &options);
+        /// @brief Run the application on the server loops of enderman::net.
+        void listen_reactors(unsigned short port, const ServerOptions &options);
+        /// @brief Check the size of a request body against the limit of its route, from Content-Length or the body itself.
+        /// @return True if the body is within the limit.
+        static bool body_within_limit(const Request &req, size_t max_body_size);
     };
 }
 
@@ -68,107 +150,123 @@ void enderman::Enderman::use(MiddlewareFunction func)
     pImpl->middlewares.push_back(Middleware({}, std::move(func)));
 }
 
-void enderman::Enderman::on(const enderman::HttpMethod method, const std::string &path, RouteHandlerFunction handler)
+void enderman::Enderman::on(const enderman::HttpMethod method, const std::string &path, RouteHandlerFunction handler, const RouteOptions &options)
 {
     auto segments = enderman::utils::UriParser::parse_path(path);
-    pImpl->route_handlers[method].emplace_back(segments, std::move(handler));
+    pImpl->route_handlers[method].emplace_back(segments, std::move(handler), options);
+    pImpl->assign_bulkhead(pImpl->route_handlers[method].back());
+    if (options.max_body_size > 0 || options.spool_threshold > 0 || options.offload || options.priority || options.timeout.count() > 0)
+        pImpl->has_route_options = true;
+    if (options.offload)
+        pImpl->has_offloaded_routes = true;
 }
 
-void enderman::Enderman::on(const enderman::HttpMethod method, const std::vector<std::string> &paths, RouteHandlerFunction handler)
+void enderman::Enderman::on_async(const enderman::HttpMethod method, const std::string &path, AsyncRouteHandlerFunction handler, const RouteOptions &options)
+{
+    auto segments = enderman::utils::UriParser::parse_path(path);
+    pImpl->route_handlers[method].emplace_back(segments, std::move(handler), options);
+    pImpl->assign_bulkhead(pImpl->route_handlers[method].back());
+    pImpl->has_route_options = true;
+    pImpl->has_async_routes = true;
+    if (options.offload)
+        pImpl->has_offloaded_routes = true;
+}
+
+void enderman::Enderman::on(const enderman::HttpMethod method, const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options)
 {
     for (const auto &path : paths)
     {
-        on(method, path, handler);
+        on(method, path, handler, options);
     }
 }
 
-void enderman::Enderman::on(const std::vector<enderman::HttpMethod> &methods, const std::string &path, RouteHandlerFunction handler)
+void enderman::Enderman::on(const std::vector<enderman::HttpMethod> &methods, const std::string &path, RouteHandlerFunction handler, const RouteOptions &options)
 {
     for (const auto &method : methods)
     {
-        on(method, path, handler);
+        on(method, path, handler, options);
     }
 }
 
-void enderman::Enderman::on(const std::vector<enderman::HttpMethod> &methods, const std::vector<std::string> &paths, RouteHandlerFunction handler)
+void enderman::Enderman::on(const std::vector<enderman::HttpMethod> &methods, const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options)
 {
     for (const auto &method : methods)
     {
-        on(method, paths, handler);
+        on(method, paths, handler, options);
     }
 }
 
-void enderman::Enderman::get(const std::string &path, RouteHandlerFunction handler)
+void enderman::Enderman::get(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::GET, path, std::move(handler));
+    on(enderman::HttpMethod::GET, path, std::move(handler), options);
 }
 
-void enderman::Enderman::get(const std::vector<std::string> &paths, RouteHandlerFunction handler)
+void enderman::Enderman::get(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::GET, paths, std::move(handler));
+    on(enderman::HttpMethod::GET, paths, std::move(handler), options);
 }
 
-void enderman::Enderman::post(const std::string &path, RouteHandlerFunction handler)
+void enderman::Enderman::post(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::POST, path, std::move(handler));
+    on(enderman::HttpMethod::POST, path, std::move(handler), options);
 }
 
-void enderman::Enderman::post(const std::vector<std::string> &paths, RouteHandlerFunction handler)
+void enderman::Enderman::post(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::POST, paths, std::move(handler));
+    on(enderman::HttpMethod::POST, paths, std::move(handler), options);
 }
 
-void enderman::Enderman::put(const std::string &path, RouteHandlerFunction handler)
+void enderman::Enderman::put(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::PUT, path, std::move(handler));
+    on(enderman::HttpMethod::PUT, path, std::move(handler), options);
 }
 
-void enderman::Enderman::put(const std::vector<std::string> &paths, RouteHandlerFunction handler)
+void enderman::Enderman::put(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::PUT, paths, std::move(handler));
+    on(enderman::HttpMethod::PUT, paths, std::move(handler), options);
 }
 
-void enderman::Enderman::del(const std::string &path, RouteHandlerFunction handler)
+void enderman::Enderman::del(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::DELETE, path, std::move(handler));
+    on(enderman::HttpMethod::DELETE, path, std::move(handler), options);
 }
 
-void enderman::Enderman::del(const std::vector<std::string> &paths, RouteHandlerFunction handler)
+void enderman::Enderman::del(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::DELETE, paths, std::move(handler));
+    on(enderman::HttpMethod::DELETE, paths, std::move(handler), options);
 }
 
-void enderman::Enderman::patch(const std::string &path, RouteHandlerFunction handler)
+void enderman::Enderman::patch(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::PATCH, path, std::move(handler));
+    on(enderman::HttpMethod::PATCH, path, std::move(handler), options);
 }
 
-void enderman::Enderman::patch(const std::vector<std::string> &paths, RouteHandlerFunction handler)
+void enderman::Enderman::patch(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::PATCH, paths, std::move(handler));
+    on(enderman::HttpMethod::PATCH, paths, std::move(handler), options);
 }
 
-void enderman::Enderman::options(const std::string &path, RouteHandlerFunction handler)
+void enderman::Enderman::options(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::OPTIONS, path, std::move(handler));
+    on(enderman::HttpMethod::OPTIONS, path, std::move(handler), options);
 }
 
-void enderman::Enderman::options(const std::vector<std::string> &paths, RouteHandlerFunction handler)
+void enderman::Enderman::options(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::OPTIONS, paths, std::move(handler));
+    on(enderman::HttpMethod::OPTIONS, paths, std::move(handler), options);
 }
 
-void enderman::Enderman::head(const std::string &path, RouteHandlerFunction handler)
+void enderman::Enderman::head(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::HEAD, path, std::move(handler));
+    on(enderman::HttpMethod::HEAD, path, std::move(handler), options);
 }
 
-void enderman::Enderman::head(const std::vector<std::string> &paths, RouteHandlerFunction handler)
+void enderman::Enderman::head(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options)
 {
-    on(enderman::HttpMethod::HEAD, paths, std::move(handler));
+    on(enderman::HttpMethod::HEAD, paths, std::move(handler), options);
 }
 
-void enderman::Enderman::any(const std::string &path, RouteHandlerFunction handler)
+void enderman::Enderman::any(const std::string &path, RouteHandlerFunction handler, const RouteOptions &options)
 {
     std::vector<enderman::HttpMethod> methods = {
         enderman::HttpMethod::GET,
@@ -179,52 +277,160 @@ void enderman::Enderman::any(const std::string &path, RouteHandlerFunction handl
         enderman::HttpMethod::OPTIONS,
         enderman::HttpMethod::HEAD};
 
-    on(methods, path, std::move(handler));
+    on(methods, path, std::move(handler), options);
 }
 
-void enderman::Enderman::any(const std::vector<std::string> &paths, RouteHandlerFunction handler)
+void enderman::Enderman::any(const std::vector<std::string> &paths, RouteHandlerFunction handler, const RouteOptions &options)
 {
     for (auto &path : paths)
     {
-        any(path, handler);
+        any(path, handler, options);
+    }
+}
+
+void enderman::Enderman::constant(const enderman::HttpMethod method,
+                                  const std::string &path,
+                                  int status,
+                                  const std::vector<std::pair<std::string, std::string>> &headers,
+                                  const std::string &body)
+{
+    auto segments = enderman::utils::UriParser::parse_path(path);
+    for (const auto &segment : segments)
+    {
+        if (!segment.empty() && (segment[0] == ':' || segment == "*"))
+            throw std::invalid_argument("Constant responses cannot have path parameters or wildcards: " + path);
+    }
+
+    auto constant = std::make_shared<ConstantResponse>();
+    constant->path = enderman::utils::PathTools::build_path(segments);
+    constant->status_code = status;
+    constant->reason = std::string(ResponseWriter::default_reason_phrase(status));
+    constant->body.assign(body.begin(), body.end());
+    std::string content_type = "application/octet-stream";
+    bool has_date = false;
+    bool has_server = false;
+    for (const auto &header : headers)
+    {
+        // The framework frames the body itself.
+        if (Headers::equals_ignore_case(header.first, "content-length") || Headers::equals_ignore_case(header.first, "transfer-encoding"))
+            continue;
+        // The transport keeps connections open unless asked to close them.
+        if (Headers::equals_ignore_case(header.first, "connection"))
+        {
+            if (!Headers::equals_ignore_case(header.second, "close"))
+                continue;
+            constant->closes = true;
+        }
+        has_date = has_date || Headers::equals_ignore_case(header.first, "date");
+        has_server = has_server || Headers::equals_ignore_case(header.first, "server");
+        if (Headers::equals_ignore_case(header.first, "content-type"))
+            content_type = header.second;
+        else
+            constant->headers.push_back(header);
+    }
+    if (!body.empty() || content_type != "application/octet-stream")
+        constant->headers.emplace_back("Content-Type", content_type);
+    if (!has_server)
+        constant->headers.emplace_back("Server", std::string(enderman::http::ResponseHead::SERVER));
+
+    // Fills a Response with the constant, for rendering it now and for requests reaching it through the regular route.
+    auto fill = [content_type](const std::shared_ptr<const ConstantResponse> &response, Response &res)
+    {
+        res.set_status(response->status_code);
+        if (!response->body.empty())
+            res.set_body(std::make_shared<ConstantBody>(response, content_type));
+        for (const auto &header : response->headers)
+            res.set_header(header.first, header.second);
+    };
+    {
+        Response response;
+        fill(constant, response);
+        ResponseWriter::serialize(response, constant->serialized, method != HttpMethod::HEAD);
+    }
+    constant->headers_offset = constant->serialized.find("\r\n") + 2;
+    if (!has_date)
+    {
+        // The head starts with the status line and the Date header, which is replaced by the current one on every response.
+        constant->date_offset = constant->headers_offset;
+        constant->serialized.erase(constant->date_offset, enderman::http::ResponseHead::date_header().size());
+    }
+
+    std::shared_ptr<const ConstantResponse> registered = constant;
+    pImpl->constants.add(method, registered);
+    // Earlier routes for the path would answer requests reaching it through the router, e.g. on the loopback, with another response.
+    auto &routes = pImpl->route_handlers[method];
+    routes.erase(std::remove_if(routes.begin(), routes.end(), [&registered](const RouteHandler &route_handler)
+                                { return route_handler.pattern == registered->path; }),
+                 routes.end());
+    on(method, path, [registered, fill](Request &, Response &res)
+       { fill(registered, res); });
+}
+
+const enderman::ConstantRoutes &enderman::Enderman::constant_routes() const
+{
+    return pImpl->constants;
+}
+
+void enderman::Enderman::route_defaults(const RouteOptions &defaults)
+{
+    pImpl->route_defaults = defaults;
+    // Routes registered before take the new defaults too.
+    for (auto &routes : pImpl->route_handlers)
+    {
+        for (auto &route_handler : routes.second)
+            pImpl->assign_bulkhead(route_handler);
     }
+    if (defaults.max_body_size > 0 || defaults.spool_threshold > 0 || defaults.offload || defaults.priority || defaults.timeout.count() > 0)
+        pImpl->has_route_options = true;
+    if (defaults.offload)
+        pImpl->has_offloaded_routes = true;
 }
 
-void enderman::Enderman::listen(const unsigned short port)
+void enderman::Enderman::monitor(const LoopMonitorConfig &config)
+{
+    pImpl->loop_monitor.configure(config);
+}
+
+enderman::LoopStats enderman::Enderman::loop_stats() const
+{
+    return pImpl->loop_monitor.stats();
+}
+
+void enderman::Enderman::dispatch(Request &req, Response &res)
+{
+    pImpl->handle_request(req, res);
+}
+
+void enderman::Enderman::listen(const unsigned short port, const ServerOptions &options)
+{
+    options.validate();
+    if (options.report)
+        std::cout << options.describe(port) << std::flush;
+    pImpl->request_timeout = options.request_timeout;
+    pImpl->timeout_header = options.timeout_header;
+    if (options.workers == 0)
+        pImpl->listen_http_server(port, options);
+    else
+        pImpl->listen_reactors(port, options);
+}
+
+void enderman::Enderman::Impl::listen_http_server(unsigned short port, const ServerOptions &options)
 {
     enderman::http::HttpAdapter http_adapter;
     try
     {
         EndermanCallbackFunction handler = [this](Request &req, Response &res)
         {
-            try
-            {
-                pImpl->build_request(req);
-                pImpl->run_middlewares(req, res);
-                if (res.is_sent())
-                {
-                    return;
-                }
-                pImpl->run_route_handler(req, res);
-            }
-            catch (const enderman::utils::UriParser::InvalidURIException &e)
-            {
-                std::cerr << "Invalid URI: " << e.what() << std::endl;
-                res.set_status(400).set_body(nullptr).send();
-            }
-            catch (std::exception &e)
-            {
-                std::cerr << "Error processing request: " << e.what() << std::endl;
-                res.set_status(500).set_body(nullptr).send();
-            }
+            handle_request(req, res);
         };
-        http_adapter.create_server(port, handler);
+        http_adapter.create_server(port, options, handler, &constants);
     }
     catch (const enderman::http::HttpAdapter::UnableToCreateServerException &e)
     {
         std::cerr << e.what() << std::endl;
         return;
     }
+    loop_monitor.start();
     try
     {
         http_adapter.start_server();
@@ -232,8 +438,286 @@ void enderman::Enderman::listen(const unsigned short port)
     catch (const enderman::http::HttpAdapter::HttpServerInternalError &e)
     {
         std::cerr << e.what() << std::endl;
+        loop_monitor.stop();
+        return;
+    }
+    loop_monitor.stop();
+}
+
+void enderman::Enderman::Impl::listen_reactors(unsigned short port, const ServerOptions &options)
+{
+    enderman::net::ServerContext context;
+    context.handler = [this](Request &req, Response &res)
+    {
+        handle_request(req, res);
+    };
+    context.start = [this](Request &req, Response &res, std::function<void()> done)
+    {
+        handle_request_async(req, res, std::move(done));
+    };
+    context.run_offloaded = [this](Request &req, Response &res, std::function<void()> done)
+    {
+        handle_request_offloaded(req, res, std::move(done));
+    };
+    context.match_route = [this](HttpMethod method, std::string_view raw_uri)
+    {
+        return match_route(method, raw_uri);
+    };
+    context.constants = &constants;
+    context.offload = has_offloaded_routes || has_async_routes;
+    context.monitor = &loop_monitor;
+    try
+    {
+        enderman::net::Server server(std::move(context), port, options);
+        loop_monitor.start();
+        server.run();
+    }
+    catch (const enderman::net::Server::UnableToListenException &e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+    loop_monitor.stop();
+}
+
+void enderman::Enderman::Impl::handle_request(Request &req, Response &res)
+{
+    struct MonitorScope
+    {
+        LoopMonitor &monitor;
+        explicit MonitorScope(LoopMonitor &m) : monitor(m) { monitor.on_request_received(); }
+        ~MonitorScope() { monitor.on_request_done(); }
+    } monitor_scope(loop_monitor);
+    LoopMonitor::BusyScope busy(loop_monitor);
+    if (prepare_request(req, res))
+        run_route_handler(req, res);
+}
+
+void enderman::Enderman::Impl::handle_request_async(Request &req, Response &res, std::function<void()> done)
+{
+    loop_monitor.on_request_received();
+    auto finish = [this, done = std::move(done)]
+    {
+        loop_monitor.on_request_done();
+        done();
+    };
+    // The loop is only busy until the handler suspends; its resumptions are short by design.
+    LoopMonitor::BusyScope busy(loop_monitor);
+    if (!prepare_request(req, res))
+    {
+        finish();
         return;
     }
+    const RouteHandler *route_handler = nullptr;
+    try
+    {
+        route_handler = find_route(req);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error in route handler: " << e.what() << std::endl;
+        res.set_status(500).set_body(nullptr).send();
+        finish();
+        return;
+    }
+    if (!route_handler || !route_handler->async_handler)
+    {
+        run_route_handler(req, res);
+        finish();
+        return;
+    }
+
+    set_route_params(req, *route_handler);
+    if (Bulkhead *bulkhead = route_handler->bulkhead.get())
+    {
+        // A queued request resumes on its loop once a request leaving the bulkhead, on any thread, hands it the slot.
+        EventLoop *loop = EventLoop::current();
+        auto resume = [this, route_handler, &req, &res, finish, loop]
+        {
+            auto start = [this, route_handler, &req, &res, finish]
+            {
+                LoopMonitor::BusyScope busy(loop_monitor);
+                start_async_route_handler(*route_handler, req, res, finish);
+            };
+            if (loop)
+                loop->post(start);
+            else
+                start();
+        };
+        switch (bulkhead->enter_or_queue(resume))
+        {
+        case Bulkhead::Admission::REJECTED:
+            reject_overloaded(res);
+            finish();
+            return;
+        case Bulkhead::Admission::QUEUED:
+            return;
+        case Bulkhead::Admission::ENTERED:
+            break;
+        }
+    }
+    start_async_route_handler(*route_handler, req, res, std::move(finish));
+}
+
+void enderman::Enderman::Impl::handle_request_offloaded(Request &req, Response &res, std::function<void()> done)
+{
+    loop_monitor.on_request_received();
+    auto finish = [this, done = std::move(done)]
+    {
+        loop_monitor.on_request_done();
+        done();
+    };
+    // Runs on the executor, so its loop is not busy with it: no loop lag.
+    if (!prepare_request(req, res))
+    {
+        finish();
+        return;
+    }
+    const RouteHandler *route_handler = nullptr;
+    try
+    {
+        route_handler = find_route(req);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error in route handler: " << e.what() << std::endl;
+        res.set_status(500).set_body(nullptr).send();
+        finish();
+        return;
+    }
+    Bulkhead *bulkhead = route_handler ? route_handler->bulkhead.get() : nullptr;
+    if (!bulkhead)
+    {
+        run_route_handler(req, res);
+        finish();
+        return;
+    }
+    // Workers must not wait for a slot either, or a burst to one slow route would hold all of them.
+    // A queued request runs on the executor again once a request leaving the bulkhead, on any thread, hands it the slot.
+    Executor *executor = Executor::current();
+    auto resume = [this, route_handler, &req, &res, finish, executor]
+    {
+        auto run = [this, route_handler, &req, &res, finish]
+        {
+            run_admitted_route_handler(*route_handler, req, res);
+            finish();
+        };
+        if (executor)
+            executor->submit(run);
+        else
+            run();
+    };
+    switch (bulkhead->enter_or_queue(resume))
+    {
+    case Bulkhead::Admission::REJECTED:
+        reject_overloaded(res);
+        finish();
+        return;
+    case Bulkhead::Admission::QUEUED:
+        return;
+    case Bulkhead::Admission::ENTERED:
+        break;
+    }
+    run_admitted_route_handler(*route_handler, req, res);
+    finish();
+}
+
+void enderman::Enderman::Impl::start_async_route_handler(const RouteHandler &route_handler, Request &req, Response &res, std::function<void()> finish)
+{
+    Bulkhead *bulkhead = route_handler.bulkhead.get();
+    // The request may have expired, or lost its client, while it waited for the bulkhead.
+    if (req.cancellation().is_cancelled())
+    {
+        if (bulkhead)
+            bulkhead->leave();
+        reject_cancelled(res);
+        finish();
+        return;
+    }
+    auto handler_start = std::chrono::steady_clock::now();
+    loop_monitor.on_handler_start(req.received_at());
+    auto completion = [this, &res, handler_start, bulkhead, finish](std::exception_ptr error)
+    {
+        loop_monitor.on_handler_end(handler_start);
+        if (bulkhead)
+            bulkhead->leave();
+        if (error)
+        {
+            try
+            {
+                std::rethrow_exception(error);
+            }
+            catch (const RequestCancelledException &)
+            {
+                reject_cancelled(res);
+                finish();
+                return;
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error in route handler: " << e.what() << std::endl;
+            }
+            catch (...)
+            {
+                std::cerr << "Unknown error in route handler" << std::endl;
+            }
+            res.set_status(500).set_body(nullptr).send();
+        }
+        finish();
+    };
+    try
+    {
+        route_handler.async_handler(req, res, completion);
+    }
+    catch (...)
+    {
+        // The handler failed before it took over the completion.
+        completion(std::current_exception());
+    }
+}
+
+bool enderman::Enderman::Impl::prepare_request(Request &req, Response &res)
+{
+    try
+    {
+        build_request(req);
+        const RouteHandler *route = find_route(req);
+        RequestBuilder::set_route(req, route ? route->pattern : std::string());
+        RouteOptions options = route ? route->options.merged_with(route_defaults) : route_defaults;
+        if (!RequestBuilder::has_cancellation(req))
+            set_deadline(req, options.timeout);
+        // Nobody waits for a request whose deadline passed in a queue of the transport.
+        if (req.cancellation().is_cancelled())
+        {
+            reject_cancelled(res);
+            return false;
+        }
+        // Reject oversized bodies before a middleware or body parser touches them.
+        if (!body_within_limit(req, options.max_body_size))
+        {
+            res.set_status(413).set_header("Connection", "close").set_body(nullptr).send();
+            return false;
+        }
+        run_middlewares(req, res);
+        if (res.is_sent())
+            return false;
+        if (req.cancellation().is_cancelled())
+        {
+            reject_cancelled(res);
+            return false;
+        }
+        return true;
+    }
+    catch (const enderman::utils::UriParser::InvalidURIException &e)
+    {
+        std::cerr << "Invalid URI: " << e.what() << std::endl;
+        res.set_status(400).set_body(nullptr).send();
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Error processing request: " << e.what() << std::endl;
+        res.set_status(500).set_body(nullptr).send();
+    }
+    return false;
 }
 
 void enderman::Enderman::Impl::build_request(Request &req)
@@ -255,6 +739,67 @@ void enderman::Enderman::Impl::build_request(Request &req)
     }
 }
 
+const enderman::RouteHandler *enderman::Enderman::Impl::find_route(const Request &req) const
+{
+    return find_route(req.method(), req.base_path_segments());
+}
+
+const enderman::RouteHandler *enderman::Enderman::Impl::find_route(HttpMethod method, const std::vector<std::string> &path_segments) const
+{
+    auto it = route_handlers.find(method);
+    if (it == route_handlers.end())
+        return nullptr;
+    for (const auto &route_handler : it->second)
+    {
+        if (enderman::utils::PathTools::match_full_path(path_segments, route_handler.path))
+            return &route_handler;
+    }
+    return nullptr;
+}
+
+enderman::RouteMatch enderman::Enderman::Impl::match_route(HttpMethod method, std::string_view raw_uri) const
+{
+    RouteMatch match;
+    if (!has_route_options)
+        return match;
+    match.options = route_defaults;
+    try
+    {
+        auto parsed_uri = enderman::utils::UriParser::parse_uri(raw_uri.substr(0, raw_uri.find('?')));
+        if (const RouteHandler *route = find_route(method, parsed_uri.path_segments))
+        {
+            match.options = route->options.merged_with(route_defaults);
+            match.asynchronous = static_cast<bool>(route->async_handler);
+        }
+    }
+    catch (const enderman::utils::UriParser::InvalidURIException &)
+    {
+        // The request is answered with 400 once it is built.
+    }
+    return match;
+}
+
+bool enderman::Enderman::Impl::body_within_limit(const Request &req, size_t max_body_size)
+{
+    if (max_body_size == 0)
+        return true;
+    std::string_view declared = req.headers().get(WellKnownHeader::CONTENT_LENGTH);
+    if (!declared.empty())
+    {
+        size_t length = 0;
+        auto result = std::from_chars(declared.data(), declared.data() + declared.size(), length);
+        if (result.ec == std::errc() && length > max_body_size)
+            return false;
+    }
+    if (auto body = req.get_body())
+    {
+        std::optional<size_t> length = body->content_length();
+        if (length && *length > max_body_size)
+            return false;
+    }
+    return true;
+}
+
 void enderman::Enderman::Impl::run_middlewares(Request &req, Response &res)
 {
     size_t index = 0;
@@ -298,25 +843,61 @@ void enderman::Enderman::Impl::run_middlewares(Request &req, Response &res)
 
 void enderman::Enderman::Impl::run_route_handler(Request &req, Response &res)
 {
+    const RouteHandler *route_handler = nullptr;
     try
     {
-        auto it = route_handlers.find(req.method());
-        if (it != route_handlers.end())
+        route_handler = find_route(req);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error in route handler: " << e.what() << std::endl;
+        res.set_status(500).set_body(nullptr).send();
+        return;
+    }
+    if (!route_handler)
+    {
+        res.set_status(404).set_body(nullptr).send();
+        return;
+    }
+    // Requests handled in place never wait for a slot: a waiting thread of a loop or a transport would stall the unrelated routes it serves.
+    Bulkhead *bulkhead = route_handler->bulkhead.get();
+    if (bulkhead && !bulkhead->try_enter())
+    {
+        reject_overloaded(res);
+        return;
+    }
+    run_admitted_route_handler(*route_handler, req, res);
+}
+
+void enderman::Enderman::Impl::run_admitted_route_handler(const RouteHandler &route_handler, Request &req, Response &res)
+{
+    struct SlotGuard
+    {
+        Bulkhead *bulkhead;
+        ~SlotGuard()
         {
-            for (const auto &route_handler : it->second)
-            {
-                if (enderman::utils::PathTools::match_full_path(req.base_path_segments(), route_handler.path))
-                {
-                    auto path_params = enderman::utils::PathTools::extract_path_params(req.base_path_segments(), route_handler.path);
-                    RequestBuilder::set_path_params(req, path_params);
-                    RequestBuilder::set_relative_path_segments(req, enderman::utils::PathTools::get_relative_path(req.base_path_segments(), route_handler.path));
-                    RequestBuilder::set_relative_path(req, enderman::utils::PathTools::build_path(req.relative_path_segments()));
-                    route_handler.handler(req, res);
-                    return;
-                }
-            }
+            if (bulkhead)
+                bulkhead->leave();
         }
-        res.set_status(404).set_body(nullptr).send();
+    } slot{route_handler.bulkhead.get()};
+    try
+    {
+        set_route_params(req, route_handler);
+        // The request may have expired, or lost its client, while it waited for the slot.
+        if (req.cancellation().is_cancelled())
+        {
+            reject_cancelled(res);
+            return;
+        }
+        LoopMonitor::HandlerScope timing(loop_monitor, req.received_at());
+        if (route_handler.async_handler)
+            run_async_route_handler_inline(route_handler, req, res);
+        else
+            route_handler.handler(req, res);
+    }
+    catch (const RequestCancelledException &)
+    {
+        reject_cancelled(res);
     }
     catch (const std::exception &e)
     {
@@ -328,4 +909,82 @@ void enderman::Enderman::Impl::run_route_handler(Request &req, Response &res)
         std::cerr << "Unknown error in route handler" << std::endl;
         res.set_status(500).set_body(nullptr).send();
     }
-}
\ No newline at end of file
+}
+
+void enderman::Enderman::Impl::assign_bulkhead(RouteHandler &route_handler)
+{
+    RouteOptions options = route_handler.options.merged_with(route_defaults);
+    route_handler.bulkhead.reset();
+    if (!options.bulkhead.empty())
+    {
+        auto it = bulkheads.find(options.bulkhead);
+        if (it != bulkheads.end())
+        {
+            route_handler.bulkhead = it->second;
+            return;
+        }
+    }
+    if (options.max_in_flight == 0)
+        return;
+    route_handler.bulkhead = std::make_shared<Bulkhead>(options.max_in_flight, options.max_queued);
+    if (!options.bulkhead.empty())
+        bulkheads.emplace(options.bulkhead, route_handler.bulkhead);
+}
+
+void enderman::Enderman::Impl::reject_overloaded(Response &res)
+{
+    res.set_status(503).set_body(nullptr).send();
+}
+
+void enderman::Enderman::Impl::set_deadline(Request &req, std::chrono::milliseconds route_timeout) const
+{
+    std::chrono::milliseconds timeout = route_timeout.count() > 0 ? route_timeout : request_timeout;
+    std::string_view requested = timeout_header.empty() ? std::string_view() : req.headers().get(timeout_header);
+    RequestBuilder::set_cancellation(req, CancellationSource::deadline_only(CancellationSource::deadline_for(req.received_at(), timeout, requested)));
+}
+
+void enderman::Enderman::Impl::reject_cancelled(Response &res)
+{
+    res.set_status(504).set_body(nullptr).send();
+}
+
+void enderman::Enderman::Impl::set_route_params(Request &req, const RouteHandler &route_handler)
+{
+    auto path_params = enderman::utils::PathTools::extract_path_params(req.base_path_segments(), route_handler.path);
+    RequestBuilder::set_path_params(req, path_params);
+    RequestBuilder::set_relative_path_segments(req, enderman::utils::PathTools::get_relative_path(req.base_path_segments(), route_handler.path));
+    RequestBuilder::set_relative_path(req, enderman::utils::PathTools::build_path(req.relative_path_segments()));
+}
+
+void enderman::Enderman::Impl::run_async_route_handler_inline(const RouteHandler &route_handler, Request &req, Response &res)
+{
+    // Callback based handlers learn about the deadline through on_cancel(), called once it passes.
+    if (req.deadline() != std::chrono::steady_clock::time_point::max() && !req.cancellation().can_be_cancelled())
+        RequestBuilder::set_cancellation(req, CancellationSource::cancellable(req.deadline()));
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    std::exception_ptr error;
+    {
+        EventLoop::Binding no_loop(nullptr);
+        route_handler.async_handler(req, res, [&](std::exception_ptr handler_error)
+                                    {
+                                        std::lock_guard<std::mutex> lock(mutex);
+                                        error = handler_error;
+                                        done = true;
+                                        finished.notify_one(); });
+    }
+    // Callback based handlers may complete on another thread.
+    std::unique_lock<std::mutex> lock(mutex);
+    auto is_done = [&done]
+    { return done; };
+    if (req.deadline() != std::chrono::steady_clock::time_point::max() && !finished.wait_until(lock, req.deadline(), is_done))
+    {
+        lock.unlock();
+        CancellationSource::cancel(req.cancellation(), CancellationReason::DEADLINE);
+        lock.lock();
+    }
+    finished.wait(lock, is_done);
+    if (error)
+        std::rethrow_exception(error);
+}
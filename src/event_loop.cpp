@@ -0,0 +1,118 @@
+#include "event_loop.hpp"
+#include "cancellation_source.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <poll.h>
+
+namespace
+{
+    thread_local enderman::EventLoop *current_loop = nullptr;
+}
+
+enderman::EventLoop *enderman::EventLoop::current()
+{
+    return current_loop;
+}
+
+enderman::EventLoop::Binding::Binding(EventLoop *loop) : previous(current_loop)
+{
+    current_loop = loop;
+}
+
+enderman::EventLoop::Binding::~Binding()
+{
+    current_loop = previous;
+}
+
+/// The scheduling primitives declared by task.hpp. They are plain C++17 so the library does not need to be compiled as C++20.
+namespace enderman
+{
+    namespace detail
+    {
+        bool resume_after(std::chrono::steady_clock::duration delay, std::function<void()> resume);
+        bool resume_after_work(std::function<void()> work, std::function<void()> resume);
+        bool resume_when_ready(int fd, bool writable, std::function<void()> resume);
+        bool resume_after_or_cancel(std::chrono::steady_clock::duration delay, const CancellationToken &token, std::function<void()> resume);
+    }
+}
+
+bool enderman::detail::resume_after(std::chrono::steady_clock::duration delay, std::function<void()> resume)
+{
+    EventLoop *loop = EventLoop::current();
+    if (!loop)
+    {
+        std::this_thread::sleep_for(delay);
+        return false;
+    }
+    loop->add_timer(std::chrono::steady_clock::now() + delay, std::move(resume));
+    return true;
+}
+
+bool enderman::detail::resume_after_work(std::function<void()> work, std::function<void()> resume)
+{
+    EventLoop *loop = EventLoop::current();
+    Executor *executor = loop ? loop->executor() : nullptr;
+    if (!executor)
+    {
+        work();
+        return false;
+    }
+    executor->submit([loop, work = std::move(work), resume = std::move(resume)]() mutable
+                     {
+                         work();
+                         loop->post(std::move(resume)); });
+    return true;
+}
+
+bool enderman::detail::resume_when_ready(int fd, bool writable, std::function<void()> resume)
+{
+    EventLoop *loop = EventLoop::current();
+    if (loop)
+    {
+        if (loop->watch(fd, writable, std::move(resume)))
+            return true;
+        // Descriptors epoll does not support, such as regular files, never block. Anything else must not block the loop thread.
+        if (errno == EPERM)
+            return false;
+        throw std::system_error(errno, std::generic_category(), "Unable to watch file descriptor " + std::to_string(fd));
+    }
+    pollfd descriptor{fd, static_cast<short>(writable ? POLLOUT : POLLIN), 0};
+    while (::poll(&descriptor, 1, -1) < 0 && errno == EINTR)
+    {
+    }
+    return false;
+}
+
+bool enderman::detail::resume_after_or_cancel(std::chrono::steady_clock::duration delay, const CancellationToken &token, std::function<void()> resume)
+{
+    auto now = std::chrono::steady_clock::now();
+    auto until = delay >= std::chrono::steady_clock::time_point::max() - now ? std::chrono::steady_clock::time_point::max() : now + delay;
+    EventLoop *loop = EventLoop::current();
+    if (!loop)
+    {
+        CancellationSource::wait(token, until);
+        return false;
+    }
+    // Whichever comes first resumes; both run on the loop thread, so a plain flag tells the other one it came too late.
+    auto resumed = std::make_shared<bool>(false);
+    auto once = [resumed, resume = std::move(resume)]
+    {
+        if (*resumed)
+            return;
+        *resumed = true;
+        resume();
+    };
+    auto limit = std::min(until, token.deadline());
+    if (limit != std::chrono::steady_clock::time_point::max())
+        loop->add_timer(limit, once);
+    token.on_cancel([loop, once]
+                    { loop->post(once); });
+    return true;
+}
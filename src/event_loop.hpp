@@ -0,0 +1,47 @@
+#ifndef ENDERMAN_EVENT_LOOP_HPP
+#define ENDERMAN_EVENT_LOOP_HPP
+
+#include "executor.hpp"
+
+#include <chrono>
+#include <functional>
+
+namespace enderman
+{
+    /// @brief Loop that asynchronous handlers resume on: the server loop of the connection they answer.
+    /// Except for post(), the functions must be called on the loop's own thread.
+    class EventLoop
+    {
+    public:
+        virtual ~EventLoop() = default;
+
+        /// @brief Run a task on the loop thread. Thread safe.
+        virtual void post(std::function<void()> task) = 0;
+        /// @brief Run a callback on the loop thread once the deadline passed.
+        virtual void add_timer(std::chrono::steady_clock::time_point deadline, std::function<void()> callback) = 0;
+        /// @brief Run a callback on the loop thread once a file descriptor is ready, once. A descriptor may have several callbacks waiting, for either direction.
+        /// @return False if the descriptor cannot be watched, with errno set: EPERM for descriptors that never block, such as regular files.
+        virtual bool watch(int fd, bool writable, std::function<void()> callback) = 0;
+        /// @brief Executor for blocking work, nullptr if the server runs none.
+        virtual Executor *executor() = 0;
+
+        /// @brief Loop running on the calling thread, nullptr on threads without one.
+        static EventLoop *current();
+
+        /// @brief Makes a loop the current one of the calling thread for its lifetime.
+        /// Binding nullptr makes asynchronous operations complete in place, for transports that need the response when the handler returns.
+        class Binding
+        {
+        private:
+            EventLoop *previous;
+
+        public:
+            explicit Binding(EventLoop *loop);
+            ~Binding();
+            Binding(const Binding &) = delete;
+            Binding &operator=(const Binding &) = delete;
+        };
+    };
+}
+
+#endif // ENDERMAN_EVENT_LOOP_HPP
@@ -0,0 +1,55 @@
+#include "exchange_pool.hpp"
+
+#include "request_builder.hpp"
+#include "response_writer.hpp"
+
+#include <utility>
+
+enderman::ExchangeSlot::ExchangeSlot()
+    : _arena(initial_block, sizeof(initial_block)),
+      _request(RequestBuilder::create_empty()) {}
+
+std::shared_ptr<enderman::RawBody> enderman::ExchangeSlot::raw_body()
+{
+    if (!pooled_body || pooled_body.use_count() > 1)
+        pooled_body = std::make_shared<RawBody>();
+    return pooled_body;
+}
+
+void enderman::ExchangeSlot::recycle()
+{
+    ResponseWriter::reset(_response);
+    RequestBuilder::clear(_request);
+    // Only the slot should hold the body now; anyone else keeps it beyond the exchange and needs its own copy of the data.
+    if (pooled_body && pooled_body.use_count() > 1)
+    {
+        pooled_body->retain();
+        pooled_body.reset();
+    }
+    _arena.release();
+}
+
+enderman::ExchangePool::Lease::Lease(ExchangeSlot *thread_slot, bool *thread_slot_in_use)
+    : slot(thread_slot), in_use(thread_slot_in_use)
+{
+    *in_use = true;
+}
+
+enderman::ExchangePool::Lease::Lease(std::unique_ptr<ExchangeSlot> nested_slot)
+    : slot(nested_slot.get()), owned(std::move(nested_slot)), in_use(nullptr) {}
+
+enderman::ExchangePool::Lease::~Lease()
+{
+    slot->recycle();
+    if (in_use)
+        *in_use = false;
+}
+
+enderman::ExchangePool::Lease enderman::ExchangePool::acquire()
+{
+    thread_local ExchangeSlot thread_slot;
+    thread_local bool thread_slot_in_use = false;
+    if (!thread_slot_in_use)
+        return Lease(&thread_slot, &thread_slot_in_use);
+    return Lease(std::make_unique<ExchangeSlot>());
+}
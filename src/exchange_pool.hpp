@@ -0,0 +1,78 @@
+#ifndef ENDERMAN_EXCHANGE_POOL_HPP
+#define ENDERMAN_EXCHANGE_POOL_HPP
+
+#include "enderman/request.hpp"
+#include "enderman/response.hpp"
+#include "enderman/body.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace enderman
+{
+    /// @brief Request, response and per-request arena reused by consecutive exchanges.
+    /// Every transport thread owns one, so a keep-alive connection reuses the capacity of the previous request
+    /// instead of allocating it again, and the arena is freed in one step when the exchange ends.
+    class ExchangeSlot
+    {
+    public:
+        /// @brief Size of the arena block embedded in the slot. Requests needing more fall back to the heap until the next reset.
+        static constexpr size_t INITIAL_ARENA_SIZE = 8 * 1024;
+
+    private:
+        alignas(std::max_align_t) std::byte initial_block[INITIAL_ARENA_SIZE];
+        std::pmr::monotonic_buffer_resource _arena;
+        Request _request;
+        Response _response;
+        /// @brief Body handed out by raw_body(), reused while nobody else holds it.
+        std::shared_ptr<RawBody> pooled_body;
+
+    public:
+        ExchangeSlot();
+        ExchangeSlot(const ExchangeSlot &) = delete;
+        ExchangeSlot &operator=(const ExchangeSlot &) = delete;
+
+        /// @brief Arena for state that lives exactly as long as the exchange.
+        std::pmr::memory_resource *arena() { return &_arena; }
+        Request &request() { return _request; }
+        Response &response() { return _response; }
+        /// @brief Get an empty RawBody for the request.
+        std::shared_ptr<RawBody> raw_body();
+        /// @brief End the exchange: reset the request and the response and release the arena.
+        /// A request body still referenced elsewhere is retained and given up by the slot.
+        void recycle();
+    };
+
+    /// @brief Hands out the exchange slot of the calling thread.
+    class ExchangePool
+    {
+    public:
+        /// @brief Exclusive use of a slot for one exchange. The slot is recycled when the lease ends.
+        class Lease
+        {
+        private:
+            ExchangeSlot *slot;
+            /// @brief Slot of a nested exchange, e.g. a handler dispatching through a Loopback, while the thread's slot is in use.
+            std::unique_ptr<ExchangeSlot> owned;
+            bool *in_use;
+
+            friend class ExchangePool;
+            Lease(ExchangeSlot *thread_slot, bool *thread_slot_in_use);
+            explicit Lease(std::unique_ptr<ExchangeSlot> nested_slot);
+
+        public:
+            Lease(const Lease &) = delete;
+            Lease &operator=(const Lease &) = delete;
+            ~Lease();
+
+            ExchangeSlot &operator*() const { return *slot; }
+            ExchangeSlot *operator->() const { return slot; }
+        };
+
+        /// @brief Acquire the slot of the calling thread, or a fresh one if it is already in use.
+        static Lease acquire();
+    };
+}
+
+#endif // ENDERMAN_EXCHANGE_POOL_HPP
@@ -0,0 +1,111 @@
+#include "executor.hpp"
+
+#include <utility>
+
+namespace
+{
+    /// @brief Executor and deque of the calling thread if it is a worker, so its own submissions stay local.
+    thread_local enderman::Executor *current_executor = nullptr;
+    thread_local size_t current_index = 0;
+}
+
+enderman::Executor::Executor(size_t thread_count)
+{
+    if (thread_count == 0)
+        thread_count = std::thread::hardware_concurrency();
+    if (thread_count == 0)
+        thread_count = 1;
+    workers.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i)
+        workers.push_back(std::make_unique<Worker>());
+    threads.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i)
+        threads.emplace_back([this, i]
+                             { run(i); });
+}
+
+enderman::Executor::~Executor()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (auto &thread : threads)
+        thread.join();
+}
+
+enderman::Executor *enderman::Executor::current()
+{
+    return current_executor;
+}
+
+void enderman::Executor::submit(Task task)
+{
+    pending.fetch_add(1);
+    if (current_executor == this)
+    {
+        Worker &own = *workers[current_index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.tasks.push_front(std::move(task));
+    }
+    else
+    {
+        Worker &target = *workers[next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size()];
+        std::lock_guard<std::mutex> lock(target.mutex);
+        target.tasks.push_back(std::move(task));
+    }
+    // Taking the lock orders the submission before a worker that is about to wait checks for pending tasks.
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    wakeup.notify_one();
+}
+
+bool enderman::Executor::take(size_t index, Task &task)
+{
+    {
+        Worker &own = *workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < workers.size(); ++offset)
+    {
+        Worker &victim = *workers[(index + offset) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void enderman::Executor::run(size_t index)
+{
+    current_executor = this;
+    current_index = index;
+    Task task;
+    while (true)
+    {
+        if (take(index, task))
+        {
+            pending.fetch_sub(1);
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wakeup.wait(lock, [this]
+                    { return stopping || pending.load() > 0; });
+        if (stopping)
+            return;
+    }
+}
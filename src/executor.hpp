@@ -0,0 +1,63 @@
+#ifndef ENDERMAN_EXECUTOR_HPP
+#define ENDERMAN_EXECUTOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace enderman
+{
+    /// @brief Work-stealing thread pool running handlers off the server loops.
+    /// Every worker owns a deque and takes tasks from its front. Tasks submitted by a worker go to the front of its own deque,
+    /// so they run next while their data is still warm; tasks from other threads are spread round robin over the backs of the deques
+    /// and run in arrival order. A worker whose deque is empty steals from the back of the others before going to sleep.
+    class Executor
+    {
+    public:
+        using Task = std::function<void()>;
+
+    private:
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+        /// @brief Deque receiving the next task submitted from outside the pool.
+        std::atomic<size_t> next_worker{0};
+        /// @brief Tasks submitted but not yet taken. Counted before a task is queued, so a worker never sleeps while one is on its way.
+        std::atomic<size_t> pending{0};
+        std::mutex sleep_mutex;
+        std::condition_variable wakeup;
+        bool stopping = false;
+
+        void run(size_t index);
+        bool take(size_t index, Task &task);
+
+    public:
+        /// @brief Start the workers.
+        /// @param thread_count Number of workers, 0 for one per hardware thread.
+        explicit Executor(size_t thread_count);
+        /// @brief Stop the workers after their current task. Tasks still queued are dropped.
+        ~Executor();
+        Executor(const Executor &) = delete;
+        Executor &operator=(const Executor &) = delete;
+
+        /// @brief Queue a task. Thread safe. Tasks must not throw.
+        void submit(Task task);
+        size_t size() const { return workers.size(); }
+
+        /// @brief Executor whose worker is the calling thread, nullptr on other threads.
+        static Executor *current();
+    };
+}
+
+#endif // ENDERMAN_EXECUTOR_HPP
@@ -0,0 +1,23 @@
+#include "conversion.hpp"
+
+#include <stdexcept>
+
+enderman::HttpMethod enderman::http::get_enderman_method(const std::string &method_str)
+{
+    if (method_str == "GET")
+        return enderman::HttpMethod::GET;
+    else if (method_str == "POST")
+        return enderman::HttpMethod::POST;
+    else if (method_str == "PUT")
+        return enderman::HttpMethod::PUT;
+    else if (method_str == "DELETE")
+        return enderman::HttpMethod::DELETE;
+    else if (method_str == "PATCH")
+        return enderman::HttpMethod::PATCH;
+    else if (method_str == "OPTIONS")
+        return enderman::HttpMethod::OPTIONS;
+    else if (method_str == "HEAD")
+        return enderman::HttpMethod::HEAD;
+    else
+        throw std::invalid_argument("Unsupported HTTP method: " + method_str);
+}
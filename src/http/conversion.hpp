@@ -0,0 +1,279 @@
+#ifndef ENDERMAN_HTTP_CONVERSION_HPP
+#define ENDERMAN_HTTP_CONVERSION_HPP
+
+#include "enderman/types.hpp"
+#include "enderman/request.hpp"
+#include "enderman/response.hpp"
+#include "enderman/body.hpp"
+#include "enderman/constants.hpp"
+
+#include "../response_writer.hpp"
+#include "../request_builder.hpp"
+#include "../exchange_pool.hpp"
+#include "../constant_routes.hpp"
+
+#include "http_adapter.hpp"
+#include "response_head.hpp"
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <memory>
+
+/// Conversion between transport level requests/responses and Enderman's Request/Response.
+/// The functions are templates so that every transport (Http-Server, loopback) runs exactly the same code.
+/// A request type must provide method(), ip(), port(), uri(), headers() and body().
+/// A response type must provide set_status_code(), set_status_message(), add_header(), set_body() and body().
+namespace enderman
+{
+    namespace http
+    {
+        enderman::HttpMethod get_enderman_method(const std::string &method_str);
+
+        /// @brief Convert a transport request into the request of an exchange slot without copying its URI, headers or body where possible.
+        /// Accessors returning references are borrowed, the transport request must then outlive the Enderman request or the request must be retained.
+        /// Accessors returning by value produce temporaries, which are copied into the request.
+        /// The header list is allocated from the arena of the slot.
+        template <typename HttpRequestT>
+        enderman::Request &convert_http_request_to_enderman_request(const HttpRequestT &http_request, enderman::ExchangeSlot &slot)
+        {
+            constexpr bool borrowable = std::is_lvalue_reference_v<decltype(http_request.uri())> &&
+                                        std::is_lvalue_reference_v<decltype(http_request.headers())> &&
+                                        std::is_lvalue_reference_v<decltype(http_request.body())>;
+
+            enderman::HttpMethod method = get_enderman_method(http_request.method());
+            const auto &uri = http_request.uri();
+            const auto &headers = http_request.headers();
+            const auto &body = http_request.body();
+            enderman::Request &enderman_request = slot.request();
+            enderman::RequestBuilder::reset(enderman_request,
+                                            http_request.ip(),
+                                            http_request.port(),
+                                            method,
+                                            std::string_view(uri),
+                                            enderman::Headers::view(headers, slot.arena()));
+            if (!body.empty())
+            {
+                std::shared_ptr<enderman::RawBody> raw_body = slot.raw_body();
+                raw_body->borrow(body.data(), body.size());
+                enderman_request.set_body(std::move(raw_body));
+            }
+            if constexpr (!borrowable)
+                enderman_request.retain();
+            return enderman_request;
+        }
+
+        template <typename HttpResponseT>
+        void write_enderman_response_to_http_response(const enderman::Response &enderman_response, HttpResponseT &http_response)
+        {
+            http_response.set_status_code(enderman::ResponseWriter::get_status_code(enderman_response));
+            const std::string &reason_phrase = enderman::ResponseWriter::get_reason_phrase(enderman_response);
+            if (!reason_phrase.empty())
+                http_response.set_status_message(reason_phrase);
+            else
+            {
+                std::string_view default_phrase = ResponseHead::reason_phrase(enderman::ResponseWriter::get_status_code(enderman_response));
+                http_response.set_status_message(default_phrase.empty() ? std::string(" ") : std::string(default_phrase));
+            }
+            const auto &headers = enderman::ResponseWriter::get_headers(enderman_response);
+            bool has_date = false;
+            bool has_server = false;
+            for (const auto &header : headers)
+            {
+                has_date = has_date || enderman::Headers::equals_ignore_case(header.first, "date");
+                has_server = has_server || enderman::Headers::equals_ignore_case(header.first, "server");
+                http_response.add_header(header.first, header.second);
+            }
+            if (!has_date)
+                http_response.add_header("Date", std::string(ResponseHead::date_value()));
+            if (!has_server)
+                http_response.add_header("Server", std::string(ResponseHead::SERVER));
+            if (!enderman::ResponseWriter::status_allows_body(enderman::ResponseWriter::get_status_code(enderman_response)))
+                return;
+            std::vector<char> body = enderman::ResponseWriter::get_body(enderman_response);
+            size_t body_size = body.size();
+            http_response.set_body(std::move(body));
+            if (body_size > 0)
+            {
+                http_response.add_header("Content-Length", std::to_string(body_size));
+            }
+        }
+
+        /// @brief Write a constant response into a transport response.
+        /// @param include_body False for HEAD requests, which get the Content-Length of the body without the body.
+        template <typename HttpResponseT>
+        void write_constant_response_to_http_response(const enderman::ConstantResponse &constant, HttpResponseT &http_response, bool include_body = true)
+        {
+            http_response.set_status_code(constant.status_code);
+            http_response.set_status_message(constant.reason.empty() ? std::string(" ") : constant.reason);
+            if (constant.date_offset != std::string::npos)
+                http_response.add_header("Date", std::string(ResponseHead::date_value()));
+            for (const auto &header : constant.headers)
+                http_response.add_header(header.first, header.second);
+            if (!constant.body.empty())
+            {
+                if (include_body)
+                    http_response.set_body(constant.body);
+                http_response.add_header("Content-Length", std::to_string(constant.body.size()));
+            }
+        }
+
+        /// @brief Convert a transport request, run the Enderman handler on it and write the result into the transport response.
+        /// Request, response and arena come from the exchange pool of the calling thread. Any error escaping the handler results in a 500 response.
+        /// Requests matching a constant response are answered from it without building a request.
+        template <typename HttpRequestT, typename HttpResponseT>
+        void handle_http_exchange(const HttpRequestT &req, HttpResponseT &res, const EndermanCallbackFunction &handler, const enderman::ConstantRoutes *constants = nullptr)
+        {
+            try
+            {
+                if (constants)
+                {
+                    if (const enderman::ConstantResponse *constant = constants->find(req.method(), req.uri()))
+                    {
+                        write_constant_response_to_http_response(*constant, res, req.method() != "HEAD");
+                        return;
+                    }
+                }
+                // Ending the lease retains the borrowed body if a handler kept a reference to it.
+                enderman::ExchangePool::Lease slot = enderman::ExchangePool::acquire();
+                enderman::Request &enderman_request = convert_http_request_to_enderman_request(req, *slot);
+                handler(enderman_request, slot->response());
+                write_enderman_response_to_http_response(slot->response(), res);
+            }
+            catch (...)
+            {
+                res.set_status_code(500);
+                res.set_status_message("Internal Server Error");
+            }
+        }
+
+        /// @brief Check if a response asks for its connection to be closed.
+        inline bool response_closes_connection(const enderman::Response &response)
+        {
+            for (const auto &header : enderman::ResponseWriter::get_headers(response))
+            {
+                if (enderman::Headers::equals_ignore_case(header.first, "connection"))
+                    return enderman::Headers::equals_ignore_case(header.second, "close");
+            }
+            return false;
+        }
+
+        /// @brief Answer with an empty 500 response and ask to close the connection, for requests whose handler failed outside of the framework's error handling.
+        inline void write_error_response(enderman::ResponseWriter::ResponseSink &sink)
+        {
+            std::string error(ResponseHead::status_line(500));
+            error += ResponseHead::date_header();
+            error += ResponseHead::SERVER_HEADER;
+            error += "Content-Length: 0\r\nConnection: close\r\n\r\n";
+            enderman::ConstBuffer buffer{error.data(), error.size()};
+            sink.write(&buffer, 1);
+        }
+
+        /// @brief Write the response of a handled request to a sink.
+        /// @param chunked False if the client cannot read chunked bodies, see ResponseWriter::write_response().
+        /// @return True if the connection can be kept open, false if the response is incomplete, ends with the connection or asks to close it.
+        inline bool write_handled_response(const enderman::Request &request, const enderman::Response &response, enderman::ResponseWriter::ResponseSink &sink, bool chunked = true)
+        {
+            try
+            {
+                bool close = response_closes_connection(response);
+                return enderman::ResponseWriter::write_response(response, sink, request.method() != enderman::HttpMethod::HEAD, chunked) && !close;
+            }
+            catch (...)
+            {
+                // write_response only throws before anything was written.
+                write_error_response(sink);
+                return false;
+            }
+        }
+
+        /// @brief Convert a transport request, run the Enderman handler on it and write the response to a sink.
+        /// For transports owning their sockets: buffered bodies go out in one gather write, streamed bodies while they are produced.
+        /// Requests matching a constant response get its pre-rendered bytes.
+        /// @param chunked False if the client cannot read chunked bodies, see ResponseWriter::write_response().
+        /// @param close The connection closes after the response, e.g. because the client asked for it. Constant responses then say so; handlers' responses are left as they are.
+        /// @return True if the connection can be kept open, false if the response is incomplete, ends with the connection or asks to close it.
+        template <typename HttpRequestT>
+        bool write_http_exchange(const HttpRequestT &req, enderman::ResponseWriter::ResponseSink &sink, const EndermanCallbackFunction &handler, const enderman::ConstantRoutes *constants = nullptr, bool chunked = true, bool close = false)
+        {
+            if (constants)
+            {
+                if (const enderman::ConstantResponse *constant = constants->find(req.method(), req.uri()))
+                {
+                    static constexpr std::string_view CONNECTION_CLOSE = "Connection: close\r\n";
+                    std::string_view serialized = constant->serialized;
+                    enderman::ConstBuffer buffers[4];
+                    size_t count = 0;
+                    buffers[count++] = {serialized.data(), constant->headers_offset};
+                    if (constant->date_offset != std::string::npos)
+                    {
+                        std::string_view date = ResponseHead::date_header();
+                        buffers[count++] = {date.data(), date.size()};
+                    }
+                    if (close && !constant->closes)
+                        buffers[count++] = {CONNECTION_CLOSE.data(), CONNECTION_CLOSE.size()};
+                    buffers[count++] = {serialized.data() + constant->headers_offset, serialized.size() - constant->headers_offset};
+                    return sink.write(buffers, count) && !constant->closes;
+                }
+            }
+            enderman::ExchangePool::Lease slot = enderman::ExchangePool::acquire();
+            try
+            {
+                enderman::Request &enderman_request = convert_http_request_to_enderman_request(req, *slot);
+                handler(enderman_request, slot->response());
+            }
+            catch (...)
+            {
+                write_error_response(sink);
+                return false;
+            }
+            return write_handled_response(slot->request(), slot->response(), sink, chunked);
+        }
+
+        /// @brief Convert a transport request, run the Enderman handler on it and serialize the response as one HTTP/1.1 message.
+        /// For transports that write the bytes themselves: the status line, headers and body end up in a single buffer without intermediate header or body containers.
+        /// Requests matching a constant response get its pre-rendered bytes.
+        /// @param out Buffer the response is appended to. Reuse it across exchanges to keep its capacity.
+        template <typename HttpRequestT>
+        void serialize_http_exchange(const HttpRequestT &req, std::string &out, const EndermanCallbackFunction &handler, const enderman::ConstantRoutes *constants = nullptr)
+        {
+            size_t start = out.size();
+            try
+            {
+                if (constants)
+                {
+                    if (const enderman::ConstantResponse *constant = constants->find(req.method(), req.uri()))
+                    {
+                        if (constant->date_offset == std::string::npos)
+                            out += constant->serialized;
+                        else
+                        {
+                            std::string_view serialized = constant->serialized;
+                            std::string_view date = ResponseHead::date_header();
+                            out.reserve(out.size() + serialized.size() + date.size());
+                            out += serialized.substr(0, constant->date_offset);
+                            out += date;
+                            out += serialized.substr(constant->date_offset);
+                        }
+                        return;
+                    }
+                }
+                enderman::ExchangePool::Lease slot = enderman::ExchangePool::acquire();
+                enderman::Request &enderman_request = convert_http_request_to_enderman_request(req, *slot);
+                handler(enderman_request, slot->response());
+                enderman::ResponseWriter::serialize(slot->response(), out, enderman_request.method() != enderman::HttpMethod::HEAD);
+            }
+            catch (...)
+            {
+                out.resize(start);
+                out += ResponseHead::status_line(500);
+                out += ResponseHead::date_header();
+                out += ResponseHead::SERVER_HEADER;
+                out += "Content-Length: 0\r\n\r\n";
+            }
+        }
+    }
+}
+
+#endif // ENDERMAN_HTTP_CONVERSION_HPP
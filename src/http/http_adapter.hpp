@@ -1,6 +1,9 @@
 #pragma once
 
 #include "enderman/types.hpp"
+#include "enderman/server_options.hpp"
+
+#include "../constant_routes.hpp"
 
 #include <string>
 #include <functional>
@@ -22,7 +25,9 @@ namespace enderman
             explicit HttpAdapter() = default;
             ~HttpAdapter();
 
-            void create_server(unsigned short int port, EndermanCallbackFunction &handler);
+            /// @param options Settings of the server. Backlog, connection limit and idle timeout are passed on to Http-Server.
+            /// @param constants Constant responses answered before a request is built, nullptr for none. Must outlive the server.
+            void create_server(unsigned short int port, const ServerOptions &options, EndermanCallbackFunction &handler, const ConstantRoutes *constants = nullptr);
             void start_server();
 
             struct UnableToCreateServerException : public std::runtime_error
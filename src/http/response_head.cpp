@@ -0,0 +1,293 @@
+#include "response_head.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <ctime>
+#include <mutex>
+
+namespace
+{
+    constexpr int FIRST_STATUS_CODE = 100;
+    constexpr int LAST_STATUS_CODE = 999;
+    /// @brief Length of an IMF-fixdate, e.g. "Sun, 18 Oct 2026 09:15:02 GMT".
+    constexpr size_t DATE_LENGTH = 29;
+
+    struct StatusLines
+    {
+        std::array<std::string, LAST_STATUS_CODE - FIRST_STATUS_CODE + 1> lines;
+
+        StatusLines()
+        {
+            for (int code = FIRST_STATUS_CODE; code <= LAST_STATUS_CODE; ++code)
+            {
+                std::string &line = lines[code - FIRST_STATUS_CODE];
+                line = "HTTP/1.1 ";
+                line += std::to_string(code);
+                line += ' ';
+                line += enderman::http::ResponseHead::reason_phrase(code);
+                line += "\r\n";
+            }
+        }
+    };
+
+    /// @brief Date formatted by the first thread that sees a new second.
+    struct SharedDate
+    {
+        std::mutex mutex;
+        std::time_t second = -1;
+        char value[DATE_LENGTH];
+    };
+
+    /// @brief Copy of the shared date used by one thread, so reading it needs no lock.
+    struct ThreadDate
+    {
+        std::time_t second = -1;
+        char header[6 + DATE_LENGTH + 2] = {'D', 'a', 't', 'e', ':', ' '};
+    };
+
+    SharedDate &shared_date()
+    {
+        static SharedDate date;
+        return date;
+    }
+
+    void write_two_digits(char *out, int value)
+    {
+        out[0] = static_cast<char>('0' + value / 10);
+        out[1] = static_cast<char>('0' + value % 10);
+    }
+
+    /// @brief Format an IMF-fixdate without strftime, which depends on the locale.
+    void format_date(std::time_t second, char *out)
+    {
+        static constexpr const char *days[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+        static constexpr const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+        std::tm time{};
+        gmtime_r(&second, &time);
+        const char *day = days[time.tm_wday];
+        const char *month = months[time.tm_mon];
+        int year = time.tm_year + 1900;
+        out[0] = day[0];
+        out[1] = day[1];
+        out[2] = day[2];
+        out[3] = ',';
+        out[4] = ' ';
+        write_two_digits(out + 5, time.tm_mday);
+        out[7] = ' ';
+        out[8] = month[0];
+        out[9] = month[1];
+        out[10] = month[2];
+        out[11] = ' ';
+        write_two_digits(out + 12, year / 100 % 100);
+        write_two_digits(out + 14, year % 100);
+        out[16] = ' ';
+        write_two_digits(out + 17, time.tm_hour);
+        out[19] = ':';
+        write_two_digits(out + 20, time.tm_min);
+        out[22] = ':';
+        write_two_digits(out + 23, time.tm_sec);
+        out[25] = ' ';
+        out[26] = 'G';
+        out[27] = 'M';
+        out[28] = 'T';
+    }
+
+    const ThreadDate &current_date()
+    {
+        thread_local ThreadDate date;
+        std::time_t now = std::time(nullptr);
+        if (now != date.second)
+        {
+            SharedDate &shared = shared_date();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            if (shared.second != now)
+            {
+                format_date(now, shared.value);
+                shared.second = now;
+            }
+            std::copy(shared.value, shared.value + DATE_LENGTH, date.header + 6);
+            date.header[6 + DATE_LENGTH] = '\r';
+            date.header[6 + DATE_LENGTH + 1] = '\n';
+            date.second = now;
+        }
+        return date;
+    }
+}
+
+std::string_view enderman::http::ResponseHead::reason_phrase(int status_code)
+{
+    switch (status_code)
+    {
+    case 100:
+        return "Continue";
+    case 101:
+        return "Switching Protocols";
+    case 102:
+        return "Processing";
+    case 103:
+        return "Early Hints";
+    case 200:
+        return "OK";
+    case 201:
+        return "Created";
+    case 202:
+        return "Accepted";
+    case 203:
+        return "Non-Authoritative Information";
+    case 204:
+        return "No Content";
+    case 205:
+        return "Reset Content";
+    case 206:
+        return "Partial Content";
+    case 207:
+        return "Multi-Status";
+    case 208:
+        return "Already Reported";
+    case 226:
+        return "IM Used";
+    case 300:
+        return "Multiple Choices";
+    case 301:
+        return "Moved Permanently";
+    case 302:
+        return "Found";
+    case 303:
+        return "See Other";
+    case 304:
+        return "Not Modified";
+    case 305:
+        return "Use Proxy";
+    case 307:
+        return "Temporary Redirect";
+    case 308:
+        return "Permanent Redirect";
+    case 400:
+        return "Bad Request";
+    case 401:
+        return "Unauthorized";
+    case 402:
+        return "Payment Required";
+    case 403:
+        return "Forbidden";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 406:
+        return "Not Acceptable";
+    case 407:
+        return "Proxy Authentication Required";
+    case 408:
+        return "Request Timeout";
+    case 409:
+        return "Conflict";
+    case 410:
+        return "Gone";
+    case 411:
+        return "Length Required";
+    case 412:
+        return "Precondition Failed";
+    case 413:
+        return "Content Too Large";
+    case 414:
+        return "URI Too Long";
+    case 415:
+        return "Unsupported Media Type";
+    case 416:
+        return "Range Not Satisfiable";
+    case 417:
+        return "Expectation Failed";
+    case 421:
+        return "Misdirected Request";
+    case 422:
+        return "Unprocessable Content";
+    case 423:
+        return "Locked";
+    case 424:
+        return "Failed Dependency";
+    case 425:
+        return "Too Early";
+    case 426:
+        return "Upgrade Required";
+    case 428:
+        return "Precondition Required";
+    case 429:
+        return "Too Many Requests";
+    case 431:
+        return "Request Header Fields Too Large";
+    case 451:
+        return "Unavailable For Legal Reasons";
+    case 500:
+        return "Internal Server Error";
+    case 501:
+        return "Not Implemented";
+    case 502:
+        return "Bad Gateway";
+    case 503:
+        return "Service Unavailable";
+    case 504:
+        return "Gateway Timeout";
+    case 505:
+        return "HTTP Version Not Supported";
+    case 506:
+        return "Variant Also Negotiates";
+    case 507:
+        return "Insufficient Storage";
+    case 508:
+        return "Loop Detected";
+    case 511:
+        return "Network Authentication Required";
+    }
+    return std::string_view();
+}
+
+std::string_view enderman::http::ResponseHead::status_line(int status_code)
+{
+    static const StatusLines status_lines;
+    if (status_code < FIRST_STATUS_CODE || status_code > LAST_STATUS_CODE)
+        return std::string_view();
+    return status_lines.lines[status_code - FIRST_STATUS_CODE];
+}
+
+std::string_view enderman::http::ResponseHead::content_type_header(std::string_view type)
+{
+    static constexpr std::string_view headers[] = {
+        "Content-Type: application/json\r\n",
+        "Content-Type: application/octet-stream\r\n",
+        "Content-Type: text/plain\r\n",
+        "Content-Type: text/html\r\n",
+        "Content-Type: text/css\r\n",
+        "Content-Type: text/javascript\r\n",
+        "Content-Type: application/x-www-form-urlencoded\r\n",
+    };
+    constexpr size_t prefix = sizeof("Content-Type: ") - 1;
+    for (std::string_view header : headers)
+    {
+        if (header.size() == prefix + type.size() + 2 && header.substr(prefix, type.size()) == type)
+            return header;
+    }
+    return std::string_view();
+}
+
+std::string_view enderman::http::ResponseHead::date_header()
+{
+    const ThreadDate &date = current_date();
+    return std::string_view(date.header, sizeof(date.header));
+}
+
+std::string_view enderman::http::ResponseHead::date_value()
+{
+    const ThreadDate &date = current_date();
+    return std::string_view(date.header + 6, DATE_LENGTH);
+}
+
+void enderman::http::ResponseHead::append_content_length(size_t content_length, std::string &out)
+{
+    char digits[20];
+    auto result = std::to_chars(digits, digits + sizeof(digits), content_length);
+    out += "Content-Length: ";
+    out.append(digits, result.ptr);
+    out += "\r\n";
+}
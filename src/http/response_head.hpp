@@ -0,0 +1,43 @@
+#ifndef ENDERMAN_RESPONSE_HEAD_HPP
+#define ENDERMAN_RESPONSE_HEAD_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace enderman
+{
+    namespace http
+    {
+        /// @brief Pre-rendered fragments of response heads, appended to the output as they are instead of being formatted per response.
+        class ResponseHead
+        {
+        public:
+            /// @brief Value of the Server header the framework adds to responses that set none.
+            static constexpr std::string_view SERVER = "Enderman";
+            /// @brief Complete Server header line.
+            static constexpr std::string_view SERVER_HEADER = "Server: Enderman\r\n";
+
+            /// @brief Get the standard reason phrase of a status code.
+            /// @return Reason phrase, e.g. "Not Found", or an empty view for unregistered codes.
+            static std::string_view reason_phrase(int status_code);
+            /// @brief Get the status line of a status code with its standard reason phrase, e.g. "HTTP/1.1 404 Not Found\r\n".
+            /// Rendered once for every code from 100 to 999; unregistered codes get an empty reason phrase.
+            /// @return Status line, or an empty view for codes outside of that range.
+            static std::string_view status_line(int status_code);
+            /// @brief Get the Content-Type header line of a common media type, e.g. "Content-Type: application/json\r\n".
+            /// @return Header line, or an empty view if the type has no pre-rendered line.
+            static std::string_view content_type_header(std::string_view type);
+            /// @brief Get the Date header line of the current second, e.g. "Date: Sun, 18 Oct 2026 09:15:02 GMT\r\n".
+            /// The date is formatted once per second for the whole process; every thread copies it when the second changes.
+            /// @return Header line, valid until the next call on the same thread.
+            static std::string_view date_header();
+            /// @brief Get the value of the current Date header, without name and line end.
+            static std::string_view date_value();
+            /// @brief Append a Content-Length header line.
+            static void append_content_length(size_t content_length, std::string &out);
+        };
+    }
+}
+
+#endif // ENDERMAN_RESPONSE_HEAD_HPP
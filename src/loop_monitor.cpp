@@ -0,0 +1,289 @@
+#include "loop_monitor.hpp"
+
+#include <iostream>
+
+unsigned long long enderman::LoopMonitor::next_generation()
+{
+    // Starts at 1, so the empty cache of a new thread matches no monitor.
+    static std::atomic<unsigned long long> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+long long enderman::LoopMonitor::now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void enderman::LoopMonitor::update_max(std::atomic<long long> &target, long long value)
+{
+    long long current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+enderman::LoopMonitor::Loop &enderman::LoopMonitor::current_loop()
+{
+    // Cached per thread; the registry is only searched when the thread serves another monitor.
+    // Keyed on the generation, since a monitor built where a destroyed one was would match by address while the cached loop is freed.
+    thread_local unsigned long long cached_generation = 0;
+    thread_local Loop *cached_loop = nullptr;
+    if (cached_generation == generation)
+        return *cached_loop;
+    std::lock_guard<std::mutex> lock(loops_mutex);
+    std::unique_ptr<Loop> &loop = loops[std::this_thread::get_id()];
+    if (!loop)
+        loop = std::make_unique<Loop>();
+    cached_generation = generation;
+    cached_loop = loop.get();
+    return *loop;
+}
+
+long long enderman::LoopMonitor::current_lag_ns() const
+{
+    long long now = now_ns();
+    long long lag = 0;
+    std::lock_guard<std::mutex> lock(loops_mutex);
+    for (const auto &loop : loops)
+    {
+        long long since = loop.second->busy_since_ns.load(std::memory_order_relaxed);
+        if (since != 0 && now - since > lag)
+            lag = now - since;
+    }
+    return lag;
+}
+
+enderman::LoopMonitor::~LoopMonitor()
+{
+    stop();
+}
+
+void enderman::LoopMonitor::configure(const LoopMonitorConfig &monitor_config)
+{
+    config = monitor_config;
+    if (config.interval.count() <= 0)
+        config.interval = std::chrono::milliseconds(100);
+    enabled = true;
+}
+
+void enderman::LoopMonitor::start()
+{
+    if (!enabled)
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running)
+        return;
+    running = true;
+    watchdog = std::thread(&LoopMonitor::run_watchdog, this);
+}
+
+void enderman::LoopMonitor::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running)
+            return;
+        running = false;
+    }
+    wakeup.notify_all();
+    if (watchdog.joinable())
+        watchdog.join();
+}
+
+void enderman::LoopMonitor::on_request_received()
+{
+    if (!enabled)
+        return;
+    requests.fetch_add(1, std::memory_order_relaxed);
+    size_t depth = queue_depth.fetch_add(1, std::memory_order_relaxed) + 1;
+    size_t peak = peak_queue_depth.load(std::memory_order_relaxed);
+    while (depth > peak && !peak_queue_depth.compare_exchange_weak(peak, depth, std::memory_order_relaxed))
+    {
+    }
+}
+
+void enderman::LoopMonitor::on_handler_start(std::chrono::steady_clock::time_point received_at)
+{
+    if (!enabled)
+        return;
+    long long delay = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - received_at).count();
+    dispatch_delay_sum_ns.fetch_add(delay, std::memory_order_relaxed);
+    dispatch_count.fetch_add(1, std::memory_order_relaxed);
+    update_max(dispatch_delay_max_ns, delay);
+}
+
+void enderman::LoopMonitor::on_handler_end(std::chrono::steady_clock::time_point started_at)
+{
+    if (!enabled)
+        return;
+    long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started_at).count();
+    handler_time_sum_ns.fetch_add(elapsed, std::memory_order_relaxed);
+    handler_count.fetch_add(1, std::memory_order_relaxed);
+    update_max(handler_time_max_ns, elapsed);
+}
+
+void enderman::LoopMonitor::on_request_done()
+{
+    if (!enabled)
+        return;
+    queue_depth.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool enderman::LoopMonitor::on_loop_busy()
+{
+    if (!enabled)
+        return false;
+    long long idle = 0;
+    return current_loop().busy_since_ns.compare_exchange_strong(idle, now_ns(), std::memory_order_relaxed);
+}
+
+void enderman::LoopMonitor::on_loop_idle()
+{
+    if (!enabled)
+        return;
+    long long since = current_loop().busy_since_ns.exchange(0, std::memory_order_relaxed);
+    if (since != 0)
+        update_max(max_loop_lag_ns, now_ns() - since);
+}
+
+void enderman::LoopMonitor::on_request_queued(Priority priority)
+{
+    if (!enabled)
+        return;
+    priorities[static_cast<size_t>(priority)].queued.fetch_add(1, std::memory_order_relaxed);
+}
+
+void enderman::LoopMonitor::on_request_dequeued(Priority priority, std::chrono::nanoseconds delay)
+{
+    if (!enabled)
+        return;
+    PriorityCounters &counters = priorities[static_cast<size_t>(priority)];
+    counters.queued.fetch_sub(1, std::memory_order_relaxed);
+    long long delay_ns = delay.count();
+    counters.delay_sum_ns.fetch_add(delay_ns, std::memory_order_relaxed);
+    update_max(counters.delay_max_ns, delay_ns);
+    size_t bucket = 0;
+    for (long long micros = delay_ns / 1000; micros > 0 && bucket + 1 < DELAY_BUCKETS; micros >>= 1)
+        ++bucket;
+    counters.delay_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void enderman::LoopMonitor::on_request_shed()
+{
+    if (!enabled)
+        return;
+    shed_requests.fetch_add(1, std::memory_order_relaxed);
+}
+
+enderman::LoopStats enderman::LoopMonitor::stats() const
+{
+    LoopStats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats = last_stats;
+    }
+    stats.requests = requests.load(std::memory_order_relaxed);
+    stats.shed_requests = shed_requests.load(std::memory_order_relaxed);
+    stats.queue_depth = queue_depth.load(std::memory_order_relaxed);
+    stats.loop_lag = std::chrono::nanoseconds(current_lag_ns());
+    for (size_t i = 0; i < PRIORITY_CLASSES; ++i)
+        stats.priorities[i].queued = priorities[i].queued.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void enderman::LoopMonitor::run_watchdog()
+{
+    auto next_tick = std::chrono::steady_clock::now() + config.interval;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running)
+    {
+        wakeup.wait_until(lock, next_tick, [this]
+                          { return !running; });
+        if (!running)
+            break;
+        auto drift = std::chrono::steady_clock::now() - next_tick;
+        lock.unlock();
+        tick(std::chrono::duration_cast<std::chrono::nanoseconds>(drift));
+        next_tick = std::chrono::steady_clock::now() + config.interval;
+        lock.lock();
+    }
+}
+
+void enderman::LoopMonitor::tick(std::chrono::nanoseconds drift)
+{
+    LoopStats stats;
+    stats.requests = requests.load(std::memory_order_relaxed);
+    stats.shed_requests = shed_requests.load(std::memory_order_relaxed);
+    stats.queue_depth = queue_depth.load(std::memory_order_relaxed);
+    stats.peak_queue_depth = peak_queue_depth.exchange(stats.queue_depth, std::memory_order_relaxed);
+
+    long long lag = current_lag_ns();
+    long long max_lag = max_loop_lag_ns.exchange(0, std::memory_order_relaxed);
+    stats.loop_lag = std::chrono::nanoseconds(lag);
+    stats.max_loop_lag = std::chrono::nanoseconds(max_lag > lag ? max_lag : lag);
+    stats.timer_drift = drift.count() > 0 ? drift : std::chrono::nanoseconds(0);
+
+    unsigned long long dispatches = dispatch_count.exchange(0, std::memory_order_relaxed);
+    long long dispatch_sum = dispatch_delay_sum_ns.exchange(0, std::memory_order_relaxed);
+    stats.max_dispatch_delay = std::chrono::nanoseconds(dispatch_delay_max_ns.exchange(0, std::memory_order_relaxed));
+    stats.avg_dispatch_delay = std::chrono::nanoseconds(dispatches == 0 ? 0 : dispatch_sum / static_cast<long long>(dispatches));
+
+    unsigned long long handlers = handler_count.exchange(0, std::memory_order_relaxed);
+    long long handler_sum = handler_time_sum_ns.exchange(0, std::memory_order_relaxed);
+    stats.max_handler_time = std::chrono::nanoseconds(handler_time_max_ns.exchange(0, std::memory_order_relaxed));
+    stats.avg_handler_time = std::chrono::nanoseconds(handlers == 0 ? 0 : handler_sum / static_cast<long long>(handlers));
+
+    for (size_t i = 0; i < PRIORITY_CLASSES; ++i)
+        stats.priorities[i] = collect(priorities[i]);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        last_stats = stats;
+    }
+
+    bool crossed = (config.lag_threshold.count() > 0 && stats.max_loop_lag >= config.lag_threshold) ||
+                   (config.dispatch_delay_threshold.count() > 0 && stats.max_dispatch_delay >= config.dispatch_delay_threshold) ||
+                   (config.queue_depth_threshold > 0 && stats.peak_queue_depth >= config.queue_depth_threshold);
+    if (crossed && config.on_threshold)
+    {
+        try
+        {
+            config.on_threshold(stats);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error in loop monitor callback: " << e.what() << std::endl;
+        }
+    }
+}
+
+enderman::PriorityStats enderman::LoopMonitor::collect(PriorityCounters &counters)
+{
+    PriorityStats stats;
+    stats.queued = counters.queued.load(std::memory_order_relaxed);
+    std::array<unsigned long long, DELAY_BUCKETS> buckets;
+    for (size_t i = 0; i < DELAY_BUCKETS; ++i)
+    {
+        buckets[i] = counters.delay_buckets[i].exchange(0, std::memory_order_relaxed);
+        stats.dispatched += buckets[i];
+    }
+    long long sum = counters.delay_sum_ns.exchange(0, std::memory_order_relaxed);
+    stats.max_queue_delay = std::chrono::nanoseconds(counters.delay_max_ns.exchange(0, std::memory_order_relaxed));
+    if (stats.dispatched == 0)
+        return stats;
+    stats.avg_queue_delay = std::chrono::nanoseconds(sum / static_cast<long long>(stats.dispatched));
+    // Smallest bucket bound below which at least 99% of the delays fall, never above the highest delay seen.
+    unsigned long long wanted = stats.dispatched - stats.dispatched / 100;
+    unsigned long long seen = 0;
+    for (size_t i = 0; i < DELAY_BUCKETS; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= wanted)
+        {
+            std::chrono::nanoseconds bound = std::chrono::microseconds(1LL << i);
+            stats.p99_queue_delay = i + 1 < DELAY_BUCKETS && bound < stats.max_queue_delay ? bound : stats.max_queue_delay;
+            break;
+        }
+    }
+    return stats;
+}
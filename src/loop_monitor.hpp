@@ -0,0 +1,153 @@
+#ifndef ENDERMAN_LOOP_MONITOR_HPP
+#define ENDERMAN_LOOP_MONITOR_HPP
+
+#include "enderman/monitor.hpp"
+#include "enderman/route_options.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace enderman
+{
+    class LoopMonitor
+    {
+    private:
+        /// @brief Queue delays are counted in buckets of powers of two microseconds; bucket i holds delays below 2^i us, the last one the rest.
+        static constexpr size_t DELAY_BUCKETS = 24;
+
+        struct PriorityCounters
+        {
+            std::atomic<size_t> queued{0};
+            std::atomic<long long> delay_sum_ns{0};
+            std::atomic<long long> delay_max_ns{0};
+            std::array<std::atomic<unsigned long long>, DELAY_BUCKETS> delay_buckets{};
+        };
+
+        /// @brief State of one loop: a server loop thread, or a thread of another transport running requests in place.
+        struct Loop
+        {
+            /// @brief Time at which the loop started processing the current request, 0 while idle.
+            std::atomic<long long> busy_since_ns{0};
+        };
+
+        LoopMonitorConfig config;
+        bool enabled = false;
+
+        std::atomic<unsigned long long> requests{0};
+        std::atomic<unsigned long long> shed_requests{0};
+        std::atomic<size_t> queue_depth{0};
+        std::atomic<size_t> peak_queue_depth{0};
+        std::atomic<long long> max_loop_lag_ns{0};
+        std::atomic<long long> dispatch_delay_sum_ns{0};
+        std::atomic<long long> dispatch_delay_max_ns{0};
+        std::atomic<unsigned long long> dispatch_count{0};
+        std::atomic<long long> handler_time_sum_ns{0};
+        std::atomic<long long> handler_time_max_ns{0};
+        std::atomic<unsigned long long> handler_count{0};
+        std::array<PriorityCounters, PRIORITY_CLASSES> priorities;
+
+        /// @brief Identifies the monitor in the per-thread cache of current_loop(). Unlike its address, never reused by a later monitor.
+        const unsigned long long generation = next_generation();
+        /// @brief Loops by thread, registered on their first request. Guarded by loops_mutex.
+        std::unordered_map<std::thread::id, std::unique_ptr<Loop>> loops;
+        mutable std::mutex loops_mutex;
+
+        mutable std::mutex mutex;
+        std::condition_variable wakeup;
+        LoopStats last_stats;
+        bool running = false;
+        std::thread watchdog;
+
+        static unsigned long long next_generation();
+        static long long now_ns();
+        static void update_max(std::atomic<long long> &target, long long value);
+        /// @brief Loop of the calling thread, registered on first use.
+        Loop &current_loop();
+        /// @brief Longest time one of the loops has been busy with its current request.
+        long long current_lag_ns() const;
+        void run_watchdog();
+        void tick(std::chrono::nanoseconds drift);
+        /// @brief Collect and reset the interval values of a priority class.
+        PriorityStats collect(PriorityCounters &counters);
+
+    public:
+        LoopMonitor() = default;
+        ~LoopMonitor();
+
+        void configure(const LoopMonitorConfig &monitor_config);
+        bool is_enabled() const { return enabled; }
+
+        /// @brief Start the monitor thread if the monitor is enabled.
+        void start();
+        /// @brief Stop the monitor thread.
+        void stop();
+
+        /// @brief Called when the transport hands a request over to the framework. Counts it in the queue depth, from any thread.
+        void on_request_received();
+        /// @brief Called right before the route handler of a request runs.
+        /// @param received_at Time at which the request was received.
+        void on_handler_start(std::chrono::steady_clock::time_point received_at);
+        /// @brief Called right after the route handler of a request returned.
+        /// @param started_at Time at which the route handler started.
+        void on_handler_end(std::chrono::steady_clock::time_point started_at);
+        /// @brief Called when the response of a request has been handed back to the transport, from any thread.
+        void on_request_done();
+        /// @brief Called when the calling thread starts working on a request in place, blocking the other requests of its loop.
+        /// Only work on the loop thread counts as loop lag: not the time an asynchronous handler is suspended or an offloaded one runs on the executor.
+        /// @return False if the loop was busy already, e.g. with a request handled within another one, whose end then also ends this one.
+        bool on_loop_busy();
+        /// @brief Called when the calling thread is done with its part of a request and goes back to its loop.
+        void on_loop_idle();
+
+        /// @brief Marks the loop of the calling thread busy for its lifetime.
+        class BusyScope
+        {
+        private:
+            LoopMonitor &monitor;
+            bool outermost;
+
+        public:
+            explicit BusyScope(LoopMonitor &loop_monitor) : monitor(loop_monitor), outermost(monitor.on_loop_busy()) {}
+            ~BusyScope()
+            {
+                if (outermost)
+                    monitor.on_loop_idle();
+            }
+            BusyScope(const BusyScope &) = delete;
+            BusyScope &operator=(const BusyScope &) = delete;
+        };
+
+        /// @brief Measures a route handler for its lifetime, including handlers that throw.
+        class HandlerScope
+        {
+        private:
+            LoopMonitor &monitor;
+            std::chrono::steady_clock::time_point started_at;
+
+        public:
+            /// @param received_at Time at which the request was received.
+            HandlerScope(LoopMonitor &loop_monitor, std::chrono::steady_clock::time_point received_at)
+                : monitor(loop_monitor), started_at(std::chrono::steady_clock::now()) { monitor.on_handler_start(received_at); }
+            ~HandlerScope() { monitor.on_handler_end(started_at); }
+            HandlerScope(const HandlerScope &) = delete;
+            HandlerScope &operator=(const HandlerScope &) = delete;
+        };
+        /// @brief Called when a server loop queues a complete request for dispatch.
+        void on_request_queued(Priority priority);
+        /// @brief Called when a server loop takes a request out of its queue.
+        /// @param delay Time the request spent in the queue.
+        void on_request_dequeued(Priority priority, std::chrono::nanoseconds delay);
+        /// @brief Called when a server loop answers a queued request with 503 instead of running it.
+        void on_request_shed();
+
+        LoopStats stats() const;
+    };
+}
+
+#endif // ENDERMAN_LOOP_MONITOR_HPP
@@ -0,0 +1,205 @@
+#include "enderman/loopback.hpp"
+#include "enderman/enderman.hpp"
+
+#include "http/conversion.hpp"
+
+#include <cctype>
+#include <charconv>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace
+{
+    /// @brief Exposes a LoopbackRequest through the accessors the conversion code expects from a transport request.
+    class LoopbackHttpRequest
+    {
+    private:
+        const enderman::LoopbackRequest &request;
+
+    public:
+        explicit LoopbackHttpRequest(const enderman::LoopbackRequest &req) : request(req) {}
+        const std::string &method() const { return request.method; }
+        const std::string &ip() const { return request.ip; }
+        const std::string &port() const { return request.port; }
+        const std::string &uri() const { return request.uri; }
+        const std::unordered_map<std::string, std::string> &headers() const { return request.headers; }
+        const std::vector<char> &body() const { return request.body; }
+    };
+
+    /// @brief Exposes a LoopbackResponse through the mutators the conversion code expects from a transport response.
+    class LoopbackHttpResponse
+    {
+    private:
+        enderman::LoopbackResponse &response;
+
+    public:
+        explicit LoopbackHttpResponse(enderman::LoopbackResponse &res) : response(res) {}
+        void set_status_code(int code) { response.status_code = code; }
+        void set_status_message(const std::string &message) { response.status_message = message; }
+        void add_header(const std::string &key, const std::string &value) { response.headers.emplace_back(key, value); }
+        void set_body(std::vector<char> body) { response.body = std::move(body); }
+        const std::vector<char> &body() const { return response.body; }
+    };
+
+    std::string to_lower(std::string value)
+    {
+        for (auto &c : value)
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return value;
+    }
+
+    std::string trim(const std::string &value)
+    {
+        size_t start = value.find_first_not_of(" \t");
+        if (start == std::string::npos)
+            return "";
+        size_t end = value.find_last_not_of(" \t");
+        return value.substr(start, end - start + 1);
+    }
+
+    /// @brief Parse a Content-Length or a chunk size. Callers bound it by the input left, so adding it to a position cannot overflow.
+    size_t parse_size(const std::string &value, int base)
+    {
+        if (value.empty())
+            throw enderman::Loopback::MalformedRequestException("Empty length");
+        // from_chars takes no sign, so "-1" cannot wrap around as with stoull.
+        size_t parsed = 0;
+        auto result = std::from_chars(value.data(), value.data() + value.size(), parsed, base);
+        if (result.ec != std::errc() || result.ptr != value.data() + value.size())
+            throw enderman::Loopback::MalformedRequestException("Invalid length: " + value);
+        return parsed;
+    }
+}
+
+const std::string *enderman::LoopbackResponse::header(const std::string &name) const
+{
+    std::string lower_name = to_lower(name);
+    for (const auto &header : headers)
+    {
+        if (to_lower(header.first) == lower_name)
+            return &header.second;
+    }
+    return nullptr;
+}
+
+std::string enderman::LoopbackResponse::serialize() const
+{
+    std::string out;
+    out.reserve(64 + body.size());
+    out += "HTTP/1.1 ";
+    out += std::to_string(status_code);
+    out += ' ';
+    out += status_message;
+    out += "\r\n";
+    for (const auto &header : headers)
+    {
+        out += header.first;
+        out += ": ";
+        out += header.second;
+        out += "\r\n";
+    }
+    out += "\r\n";
+    out.append(body.data(), body.size());
+    return out;
+}
+
+enderman::LoopbackResponse enderman::Loopback::dispatch(const LoopbackRequest &request)
+{
+    LoopbackResponse response;
+    LoopbackHttpRequest http_request(request);
+    LoopbackHttpResponse http_response(response);
+    EndermanCallbackFunction handler = [this](Request &req, Response &res)
+    {
+        app.dispatch(req, res);
+    };
+    enderman::http::handle_http_exchange(http_request, http_response, handler, &app.constant_routes());
+    return response;
+}
+
+std::string enderman::Loopback::dispatch_raw(const std::string &raw)
+{
+    LoopbackRequest request = parse_request(raw);
+    LoopbackHttpRequest http_request(request);
+    EndermanCallbackFunction handler = [this](Request &req, Response &res)
+    {
+        app.dispatch(req, res);
+    };
+    std::string out;
+    enderman::http::serialize_http_exchange(http_request, out, handler, &app.constant_routes());
+    return out;
+}
+
+enderman::LoopbackRequest enderman::Loopback::parse_request(const std::string &raw)
+{
+    LoopbackRequest request;
+
+    size_t head_end = raw.find("\r\n\r\n");
+    if (head_end == std::string::npos)
+        throw MalformedRequestException("Request head is not terminated by an empty line");
+
+    size_t line_end = raw.find("\r\n");
+    std::string request_line = raw.substr(0, line_end);
+    size_t first_space = request_line.find(' ');
+    size_t second_space = first_space == std::string::npos ? std::string::npos : request_line.find(' ', first_space + 1);
+    if (first_space == std::string::npos || second_space == std::string::npos)
+        throw MalformedRequestException("Invalid request line: " + request_line);
+    request.method = request_line.substr(0, first_space);
+    request.uri = request_line.substr(first_space + 1, second_space - first_space - 1);
+    std::string version = request_line.substr(second_space + 1);
+    if (request.method.empty() || request.uri.empty() || version.rfind("HTTP/1.", 0) != 0)
+        throw MalformedRequestException("Invalid request line: " + request_line);
+
+    size_t pos = line_end + 2;
+    while (pos < head_end)
+    {
+        size_t end = raw.find("\r\n", pos);
+        std::string line = raw.substr(pos, end - pos);
+        pos = end + 2;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos || colon == 0 || line[0] == ' ' || line[0] == '\t')
+            throw MalformedRequestException("Invalid header line: " + line);
+        std::string name = to_lower(line.substr(0, colon));
+        std::string value = trim(line.substr(colon + 1));
+        auto it = request.headers.find(name);
+        if (it == request.headers.end())
+            request.headers.emplace(std::move(name), std::move(value));
+        else
+            it->second += ", " + value;
+    }
+
+    size_t body_start = head_end + 4;
+    auto transfer_encoding = request.headers.find("transfer-encoding");
+    auto content_length = request.headers.find("content-length");
+    if (transfer_encoding != request.headers.end() && to_lower(transfer_encoding->second).find("chunked") != std::string::npos)
+    {
+        size_t cursor = body_start;
+        while (true)
+        {
+            size_t size_end = raw.find("\r\n", cursor);
+            if (size_end == std::string::npos)
+                throw MalformedRequestException("Truncated chunk size");
+            std::string size_line = raw.substr(cursor, size_end - cursor);
+            size_t extension = size_line.find(';');
+            if (extension != std::string::npos)
+                size_line = size_line.substr(0, extension);
+            cursor = size_end + 2;
+            size_t chunk_size = parse_size(trim(size_line), 16);
+            if (chunk_size == 0)
+                break;
+            if (chunk_size > raw.size() - cursor || raw.size() - cursor - chunk_size < 2 || raw.compare(cursor + chunk_size, 2, "\r\n") != 0)
+                throw MalformedRequestException("Truncated chunk");
+            request.body.insert(request.body.end(), raw.begin() + cursor, raw.begin() + cursor + chunk_size);
+            cursor += chunk_size + 2;
+        }
+        request.headers.erase("transfer-encoding");
+    }
+    else if (content_length != request.headers.end())
+    {
+        size_t length = parse_size(content_length->second, 10);
+        if (length > raw.size() - body_start)
+            throw MalformedRequestException("Body is shorter than Content-Length");
+        request.body.assign(raw.begin() + body_start, raw.begin() + body_start + length);
+    }
+    return request;
+}
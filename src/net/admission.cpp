@@ -0,0 +1,22 @@
+#include "admission.hpp"
+
+#include <algorithm>
+
+enderman::net::AdmissionController::AdmissionController(const ServerOptions &options)
+    : target(options.shed_target), interval(options.shed_interval) {}
+
+bool enderman::net::AdmissionController::should_shed(Clock::duration sojourn, Clock::time_point now)
+{
+    if (!enabled())
+        return false;
+    if (now >= interval_end)
+    {
+        // If a whole interval passed without requests, the queue drained meanwhile.
+        overloaded = min_delay != Clock::duration::max() && min_delay > target && now - interval_end < interval;
+        min_delay = sojourn;
+        interval_end = now + interval;
+    }
+    else
+        min_delay = std::min(min_delay, sojourn);
+    return overloaded && sojourn > 2 * target;
+}
@@ -0,0 +1,43 @@
+#ifndef ENDERMAN_NET_ADMISSION_HPP
+#define ENDERMAN_NET_ADMISSION_HPP
+
+#include "enderman/server_options.hpp"
+
+#include <chrono>
+
+namespace enderman
+{
+    namespace net
+    {
+        /// @brief Admission control of a server loop after CoDel, judging requests by the time they spent in the queue.
+        /// A queue whose shortest delay over an interval stays above the target is standing rather than absorbing a burst; during the
+        /// next interval the loop then sheds every request that waited more than twice the target, which keeps the delay of the requests
+        /// it does serve bounded. The first interval in which some request waited less than the target ends the shedding.
+        class AdmissionController
+        {
+        private:
+            using Clock = std::chrono::steady_clock;
+
+            Clock::duration target;
+            Clock::duration interval;
+            /// @brief End of the current interval, unset before the first request.
+            Clock::time_point interval_end;
+            /// @brief Shortest queueing delay seen during the current interval.
+            Clock::duration min_delay = Clock::duration::max();
+            /// @brief The queue was standing during the last interval.
+            bool overloaded = false;
+
+        public:
+            explicit AdmissionController(const ServerOptions &options);
+
+            bool enabled() const { return target > Clock::duration::zero(); }
+            bool is_overloaded() const { return overloaded; }
+            /// @brief Judge a request taken out of the queue.
+            /// @param sojourn Time the request spent in the queue.
+            /// @return True if the request has to be shed.
+            bool should_shed(Clock::duration sojourn, Clock::time_point now);
+        };
+    }
+}
+
+#endif // ENDERMAN_NET_ADMISSION_HPP
@@ -0,0 +1,765 @@
+#include "connection.hpp"
+#include "reactor.hpp"
+
+#include "enderman/headers.hpp"
+#include "enderman/response.hpp"
+#include "enderman/stream_body.hpp"
+
+#include "../http/conversion.hpp"
+#include "../exchange_pool.hpp"
+#include "../cancellation_source.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace
+{
+    /// @brief Most buffers gathered into one write. The rest of a response with more is written by the next one.
+    constexpr size_t MAX_GATHER = 64;
+    constexpr size_t READ_SIZE = 16 * 1024;
+
+    /// @brief Request as the conversion functions expect it, viewing the head and the body in the input of the connection.
+    class SocketRequest
+    {
+    private:
+        const enderman::net::RequestHead &head;
+        const std::string &client_ip;
+        const std::string &client_port;
+        std::string_view body_view;
+
+    public:
+        SocketRequest(const enderman::net::RequestHead &request_head, const std::string &ip, const std::string &port, std::string_view body)
+            : head(request_head), client_ip(ip), client_port(port), body_view(body) {}
+
+        const std::string &method() const { return head.method; }
+        const std::string &ip() const { return client_ip; }
+        const std::string &port() const { return client_port; }
+        const std::string_view &uri() const { return head.uri; }
+        const std::vector<std::pair<std::string_view, std::string_view>> &headers() const { return head.headers; }
+        const std::string_view &body() const { return body_view; }
+    };
+}
+
+struct enderman::net::Connection::DetachedExchange
+{
+    ExchangeSlot slot;
+    /// @brief The handler threw something the framework does not handle.
+    bool failed = false;
+    bool last_request = false;
+    /// @brief The connection closes after the response, as the request or the request limit asks.
+    bool close = false;
+    /// @brief The client reads chunked bodies; false for HTTP/1.0 clients.
+    bool chunked = true;
+    /// @brief Cancellation of the request, kept apart from it so the loop does not touch the request while the handler runs.
+    CancellationToken cancellation;
+};
+
+struct enderman::net::Connection::Stream
+{
+    std::mutex mutex;
+    /// @brief Signalled when the loop wrote some of the output, or when the connection closed.
+    std::condition_variable credit;
+    /// @brief Bytes the producer handed to the loop.
+    size_t posted = 0;
+    /// @brief Bytes the loop received from the producer.
+    size_t received = 0;
+    /// @brief Output of the connection not written yet.
+    size_t unsent = 0;
+    /// @brief The connection closed; the producer stops and posts nothing more, since the loop may be gone.
+    bool closed = false;
+};
+
+class enderman::net::Connection::StreamSink : public ResponseWriter::ResponseSink
+{
+private:
+    std::shared_ptr<Stream> stream;
+    Reactor &loop;
+    int socket;
+    uint64_t id;
+
+public:
+    StreamSink(std::shared_ptr<Stream> running, Reactor &owner, int fd, uint64_t connection_id)
+        : stream(std::move(running)), loop(owner), socket(fd), id(connection_id) {}
+
+    bool write(const ConstBuffer *buffers, size_t count) override
+    {
+        auto chunk = std::make_shared<std::string>();
+        for (size_t i = 0; i < count; ++i)
+            chunk->append(buffers[i].data, buffers[i].size);
+        std::unique_lock<std::mutex> lock(stream->mutex);
+        // Backpressure: wait for the client to take what is pending instead of buffering without bound.
+        stream->credit.wait(lock, [this]
+                            { return stream->closed || stream->posted - stream->received + stream->unsent <= OUTPUT_HIGH_WATERMARK; });
+        if (stream->closed)
+            return false;
+        stream->posted += chunk->size();
+        loop.post(socket, id, [running = stream, chunk = std::shared_ptr<const std::string>(std::move(chunk))](Connection &connection) mutable
+                  { connection.receive_stream(*running, std::move(chunk)); });
+        return true;
+    }
+
+    /// @brief Hand the end of the stream to the loop, unless the connection closed.
+    void finish(bool complete, bool producer_failed)
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        if (stream->closed)
+            return;
+        loop.post(socket, id, [running = stream, complete, producer_failed](Connection &connection)
+                  { connection.finish_stream(*running, complete, producer_failed); });
+    }
+};
+
+enderman::net::Connection::Connection(int socket, uint64_t id, std::string client_ip, std::string client_port, Reactor &owner, const ServerContext &server_context, const ServerOptions &server_options)
+    : fd(socket),
+      connection_id(id),
+      ip(std::move(client_ip)),
+      port(std::move(client_port)),
+      reactor(owner),
+      context(server_context),
+      options(server_options),
+      sink(*this),
+      timed_handler([this](Request &req, Response &res)
+                    {
+                        RequestBuilder::set_cancellation(req, CancellationSource::deadline_only(dispatch_deadline));
+                        context.handler(req, res); }),
+      last_active(std::chrono::steady_clock::now()) {}
+
+enderman::net::Connection::~Connection()
+{
+    // Nobody reads the response of a handler still running on a closed connection.
+    if (running_exchange)
+        CancellationSource::cancel(running_exchange->cancellation, CancellationReason::CLIENT_GONE);
+    // The producer of a stream stops at its next write.
+    if (stream)
+    {
+        {
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            stream->closed = true;
+        }
+        stream->credit.notify_all();
+    }
+    ::close(fd);
+}
+
+bool enderman::net::Connection::on_readable()
+{
+    last_active = std::chrono::steady_clock::now();
+    bool peer_closed = false;
+    char buffer[READ_SIZE];
+    while (wants_input())
+    {
+        ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (received > 0)
+        {
+            input.append(buffer, static_cast<size_t>(received));
+            if (static_cast<size_t>(received) < sizeof(buffer))
+                break;
+            continue;
+        }
+        if (received == 0)
+        {
+            peer_closed = true;
+            break;
+        }
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        return false;
+    }
+    // Answer what was complete, then close.
+    if (peer_closed)
+        input_closed = true;
+    process_input();
+    close_if_input_done();
+    return !is_finished();
+}
+
+bool enderman::net::Connection::on_writable()
+{
+    last_active = std::chrono::steady_clock::now();
+    if (!flush())
+        return false;
+    update_stream_credit();
+    return !is_finished();
+}
+
+void enderman::net::Connection::process_input()
+{
+    try
+    {
+        while (!close_after_write && !failed && !handler_running && !request_queued && !stream)
+        {
+            if (state == State::HEAD)
+            {
+                if (input.empty() || input.size() < awaited_size || !handle_head())
+                    return;
+            }
+            else if (state == State::BODY)
+            {
+                size_t size = std::min(body_remaining, input.size());
+                spool->append(input.data(), size);
+                consume_input(size);
+                body_remaining -= size;
+                if (body_remaining > 0)
+                    return;
+                RequestParser::parse_head(head_storage, head);
+                std::shared_ptr<Body> body = spool->finish();
+                spool.reset();
+                state = State::HEAD;
+                queue_request(std::string_view(), std::move(body), 0);
+            }
+            else
+            {
+                std::optional<size_t> consumed = chunked_decoder.feed(input, [this](const char *data, size_t size)
+                                                                      {
+                                                                          body_size += size;
+                                                                          if (spool)
+                                                                              spool->append(data, size);
+                                                                          else
+                                                                              chunked_body.append(data, size); });
+                if (!consumed)
+                {
+                    reject(400);
+                    return;
+                }
+                consume_input(*consumed);
+                if (route_options.max_body_size > 0 && body_size > route_options.max_body_size)
+                {
+                    reject(413);
+                    return;
+                }
+                if (!chunked_decoder.done())
+                    return;
+                RequestParser::parse_head(head_storage, head);
+                state = State::HEAD;
+                if (spool)
+                {
+                    std::shared_ptr<Body> body = spool->finish();
+                    spool.reset();
+                    queue_request(std::string_view(), std::move(body), 0);
+                }
+                else
+                    queue_request(chunked_body, nullptr, 0);
+            }
+        }
+    }
+    catch (const SpoolException &e)
+    {
+        std::cerr << "Error spooling request body: " << e.what() << std::endl;
+        spool.reset();
+        reject(500);
+    }
+}
+
+bool enderman::net::Connection::handle_head()
+{
+    switch (RequestParser::parse_head(input, head))
+    {
+    case RequestParser::Result::INCOMPLETE:
+        awaited_size = input.size() + 1;
+        return false;
+    case RequestParser::Result::TOO_LARGE:
+        reject(431);
+        return false;
+    case RequestParser::Result::MALFORMED:
+        reject(400);
+        return false;
+    case RequestParser::Result::UNSUPPORTED:
+        reject(501);
+        return false;
+    case RequestParser::Result::COMPLETE:
+        break;
+    }
+
+    HttpMethod method;
+    try
+    {
+        method = http::get_enderman_method(head.method);
+    }
+    catch (const std::invalid_argument &)
+    {
+        reject(501);
+        return false;
+    }
+    RouteMatch route = context.match_route ? context.match_route(method, head.uri) : RouteMatch();
+    route_options = route.options;
+    route_asynchronous = route.asynchronous;
+
+    if (head.chunked)
+    {
+        start_body_reading();
+        return true;
+    }
+    size_t length = head.content_length.value_or(0);
+    // Refuse the body before reading it.
+    if (route_options.max_body_size > 0 && length > route_options.max_body_size)
+    {
+        reject(413);
+        return false;
+    }
+    if (route_options.spool_threshold > 0 && length > route_options.spool_threshold)
+    {
+        start_body_reading();
+        return true;
+    }
+    if (input.size() < head.size + length)
+    {
+        awaited_size = head.size + length;
+        if (head.expect_continue)
+            send_continue();
+        return false;
+    }
+    queue_request(std::string_view(input).substr(head.size, length), nullptr, head.size + length);
+    return true;
+}
+
+void enderman::net::Connection::start_body_reading()
+{
+    head_storage.assign(input, 0, head.size);
+    consume_input(head.size);
+    body_size = 0;
+    body_remaining = head.content_length.value_or(0);
+    chunked_body.clear();
+    chunked_decoder.reset();
+    if (route_options.spool_threshold > 0)
+        spool = std::make_unique<BodySpool>(route_options.spool_threshold);
+    state = head.chunked ? State::CHUNKED : State::BODY;
+    if (head.expect_continue)
+        send_continue();
+}
+
+void enderman::net::Connection::queue_request(std::string_view body, std::shared_ptr<Body> spooled_body, size_t input_size)
+{
+    // Constant responses cost less than queueing them, and health checks must not wait behind a backlog.
+    if (context.constants && !context.constants->empty() && context.constants->find(head.method, head.uri))
+    {
+        dispatch(body, std::move(spooled_body), std::chrono::steady_clock::time_point::max());
+        consume_input(input_size);
+        return;
+    }
+    queued_body = body;
+    queued_spooled_body = std::move(spooled_body);
+    queued_input_size = input_size;
+    request_queued = true;
+    std::string_view client_key = ip;
+    std::string_view requested_timeout;
+    if (!options.client_key_header.empty() || !options.timeout_header.empty())
+    {
+        for (const auto &header : head.headers)
+        {
+            if (header.second.empty())
+                continue;
+            if (!options.client_key_header.empty() && Headers::equals_ignore_case(header.first, options.client_key_header))
+                client_key = header.second;
+            else if (!options.timeout_header.empty() && Headers::equals_ignore_case(header.first, options.timeout_header))
+                requested_timeout = header.second;
+        }
+    }
+    // The time spent in the queue counts against the deadline.
+    std::chrono::milliseconds timeout = route_options.timeout.count() > 0 ? route_options.timeout : options.request_timeout;
+    queued_deadline = CancellationSource::deadline_for(std::chrono::steady_clock::now(), timeout, requested_timeout);
+    reactor.schedule(*this, route_options.priority_class(), client_key);
+}
+
+void enderman::net::Connection::run_queued()
+{
+    // The client gave up on a request that outlived its deadline in the queue; running it would only waste the loop.
+    if (queued_deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= queued_deadline)
+    {
+        Response response;
+        response.set_status(504);
+        answer_queued(response);
+        return;
+    }
+    request_queued = false;
+    dispatch(queued_body, std::move(queued_spooled_body), queued_deadline);
+    queued_body = std::string_view();
+    consume_input(queued_input_size);
+    process_input();
+    close_if_input_done();
+}
+
+void enderman::net::Connection::shed(std::chrono::seconds retry_after)
+{
+    Response response;
+    response.set_status(503).set_header("Retry-After", std::to_string(retry_after.count()));
+    answer_queued(response);
+}
+
+void enderman::net::Connection::answer_queued(Response &response)
+{
+    request_queued = false;
+    queued_body = std::string_view();
+    queued_spooled_body.reset();
+    continue_sent = false;
+    if (!head.keep_alive)
+    {
+        response.set_header("Connection", "close");
+        close_after_write = true;
+    }
+    ResponseWriter::write_response(response, sink);
+    consume_input(queued_input_size);
+    process_input();
+    close_if_input_done();
+}
+
+void enderman::net::Connection::dispatch(std::string_view body, std::shared_ptr<Body> spooled_body, std::chrono::steady_clock::time_point deadline)
+{
+    SocketRequest request(head, ip, port, body);
+    bool last_request = options.max_requests_per_connection > 0 && ++requests_handled >= options.max_requests_per_connection;
+    continue_sent = false;
+    bool offloaded_route = route_options.offload && context.executor;
+    if (offloaded_route || route_asynchronous)
+    {
+        auto exchange = std::make_shared<DetachedExchange>();
+        Request &detached = http::convert_http_request_to_enderman_request(request, exchange->slot);
+        // The request views the input, which is consumed before the handler runs.
+        detached.retain();
+        if (spooled_body)
+            detached.set_body(std::move(spooled_body));
+        exchange->last_request = last_request;
+        exchange->close = !head.keep_alive || last_request;
+        exchange->chunked = !head.http_1_0;
+        exchange->cancellation = CancellationSource::cancellable(deadline);
+        RequestBuilder::set_cancellation(detached, exchange->cancellation);
+        handler_running = true;
+        running_exchange = exchange;
+        Reactor &loop = reactor;
+        int socket = fd;
+        uint64_t id = connection_id;
+        if (deadline != std::chrono::steady_clock::time_point::max())
+        {
+            // The timer keeps the cancellation only, so exchanges answered in time are freed right away.
+            loop.add_timer(deadline, [&loop, socket, id, cancellation = exchange->cancellation]
+                           { loop.post(socket, id, [cancellation](Connection &connection)
+                                       { connection.expire_detached(cancellation); }); });
+        }
+        if (!offloaded_route)
+        {
+            // The handler resumes on this loop; its response is written once it is done, even if that happens right away.
+            context.start(exchange->slot.request(), exchange->slot.response(), [exchange, &loop, socket, id]
+                          { loop.post(socket, id, [exchange](Connection &connection)
+                                      { connection.finish_detached(*exchange); }); });
+            return;
+        }
+        const ServerContext &application = context;
+        context.executor->submit([exchange, &loop, socket, id, &application]
+                                 {
+                                     auto done = [exchange, &loop, socket, id]
+                                     { loop.post(socket, id, [exchange](Connection &connection)
+                                                 { connection.finish_detached(*exchange); }); };
+                                     try
+                                     {
+                                         application.run_offloaded(exchange->slot.request(), exchange->slot.response(), done);
+                                     }
+                                     catch (...)
+                                     {
+                                         exchange->failed = true;
+                                         done();
+                                     } });
+        return;
+    }
+
+    bool keep_alive;
+    bool close = !head.keep_alive || last_request;
+    dispatch_deadline = deadline;
+    if (spooled_body || last_request)
+    {
+        EndermanCallbackFunction handler = [this, &spooled_body, last_request](Request &req, Response &res)
+        {
+            if (spooled_body)
+                req.set_body(spooled_body);
+            timed_handler(req, res);
+            if (last_request)
+                res.set_header("Connection", "close");
+        };
+        keep_alive = http::write_http_exchange(request, sink, handler, context.constants, !head.http_1_0, close);
+    }
+    else
+        keep_alive = http::write_http_exchange(request, sink, timed_handler, context.constants, !head.http_1_0, close);
+    if (!keep_alive || close)
+        close_after_write = true;
+}
+
+void enderman::net::Connection::finish_detached(DetachedExchange &exchange)
+{
+    // Answered with 504 when its deadline passed.
+    if (running_exchange.get() != &exchange)
+        return;
+    running_exchange.reset();
+    handler_running = false;
+    last_active = std::chrono::steady_clock::now();
+    bool keep_alive = false;
+    if (exchange.failed)
+        http::write_error_response(sink);
+    else
+    {
+        if (exchange.last_request)
+            exchange.slot.response().set_header("Connection", "close");
+        keep_alive = http::write_handled_response(exchange.slot.request(), exchange.slot.response(), sink, exchange.chunked);
+    }
+    if (!keep_alive || exchange.close)
+        close_after_write = true;
+    // Pipelined requests wait in the input while the handler runs.
+    process_input();
+    close_if_input_done();
+}
+
+void enderman::net::Connection::expire_detached(const CancellationToken &cancellation)
+{
+    if (!running_exchange || !CancellationSource::same(running_exchange->cancellation, cancellation))
+        return;
+    bool close = running_exchange->close;
+    running_exchange.reset();
+    handler_running = false;
+    last_active = std::chrono::steady_clock::now();
+    // The handler keeps its request and response until it completes; its completion finds the exchange answered.
+    CancellationSource::cancel(cancellation, CancellationReason::DEADLINE);
+    Response response;
+    response.set_status(504);
+    if (close)
+    {
+        response.set_header("Connection", "close");
+        close_after_write = true;
+    }
+    ResponseWriter::write_response(response, sink);
+    process_input();
+    close_if_input_done();
+}
+
+void enderman::net::Connection::reject(int status_code)
+{
+    Response response;
+    response.set_status(status_code).set_header("Connection", "close");
+    ResponseWriter::write_response(response, sink);
+    close_after_write = true;
+}
+
+void enderman::net::Connection::send_continue()
+{
+    if (continue_sent)
+        return;
+    static constexpr std::string_view interim = "HTTP/1.1 100 Continue\r\n\r\n";
+    ConstBuffer buffer{interim.data(), interim.size()};
+    sink.write(&buffer, 1);
+    continue_sent = true;
+}
+
+void enderman::net::Connection::consume_input(size_t size)
+{
+    input.erase(0, size);
+    awaited_size = 0;
+}
+
+void enderman::net::Connection::close_if_input_done()
+{
+    if (input_closed && !request_queued && !handler_running && !stream)
+        close_after_write = true;
+}
+
+bool enderman::net::Connection::SocketSink::write(const ConstBuffer *buffers, size_t count)
+{
+    return connection.send(buffers, count, count, nullptr);
+}
+
+bool enderman::net::Connection::SocketSink::write(const ConstBuffer *buffers, size_t count, size_t first_owned, const std::shared_ptr<const void> &owner)
+{
+    return connection.send(buffers, count, first_owned, owner);
+}
+
+bool enderman::net::Connection::SocketSink::defer_stream(const std::shared_ptr<const StreamBody> &body, const std::string &head, std::optional<size_t> content_length, bool chunked)
+{
+    return connection.start_stream(body, head, content_length, chunked);
+}
+
+bool enderman::net::Connection::send(const ConstBuffer *buffers, size_t count, size_t first_owned, const std::shared_ptr<const void> &owner)
+{
+    if (failed)
+        return false;
+    size_t written = 0;
+    size_t gathered = 0;
+    size_t gathered_size = 0;
+    if (!has_pending_output())
+    {
+        iovec iov[MAX_GATHER];
+        for (; gathered < count && gathered < MAX_GATHER; ++gathered)
+        {
+            iov[gathered].iov_base = const_cast<char *>(buffers[gathered].data);
+            iov[gathered].iov_len = buffers[gathered].size;
+            gathered_size += buffers[gathered].size;
+        }
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = gathered;
+        ssize_t sent;
+        do
+            sent = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+        while (sent < 0 && errno == EINTR);
+        if (sent < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                failed = true;
+                return false;
+            }
+            sent = 0;
+        }
+        written = static_cast<size_t>(sent);
+    }
+
+    // Keep what the socket did not take: the owned buffers by reference, copies of the others, which are only valid during this call.
+    size_t skip = written;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (skip >= buffers[i].size)
+        {
+            skip -= buffers[i].size;
+            continue;
+        }
+        const char *data = buffers[i].data + skip;
+        size_t size = buffers[i].size - skip;
+        skip = 0;
+        if (owner && i >= first_owned)
+            output.push_back(OutputSegment{std::string(), ConstBuffer{data, size}, owner});
+        else if (!output.empty() && !output.back().owner)
+            output.back().copy.append(data, size);
+        else
+            output.push_back(OutputSegment{std::string(data, size), ConstBuffer{}, nullptr});
+        output_size += size;
+    }
+    // Go on right away only if the socket took all it was given; otherwise it is full until it is writable again.
+    if (has_pending_output() && (gathered == 0 || (gathered < count && written == gathered_size)))
+        return flush();
+    return true;
+}
+
+bool enderman::net::Connection::flush()
+{
+    while (has_pending_output())
+    {
+        iovec iov[MAX_GATHER];
+        size_t count = 0;
+        for (auto it = output.begin(); it != output.end() && count < MAX_GATHER; ++it, ++count)
+        {
+            size_t skip = count == 0 ? output_offset : 0;
+            iov[count].iov_base = const_cast<char *>(it->data() + skip);
+            iov[count].iov_len = it->size() - skip;
+        }
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = count;
+        ssize_t sent = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+            failed = true;
+            return false;
+        }
+        size_t written = static_cast<size_t>(sent);
+        output_size -= written;
+        while (written > 0)
+        {
+            size_t left = output.front().size() - output_offset;
+            if (written < left)
+            {
+                output_offset += written;
+                break;
+            }
+            written -= left;
+            output.pop_front();
+            output_offset = 0;
+        }
+    }
+    output.clear();
+    output_offset = 0;
+    return true;
+}
+
+bool enderman::net::Connection::start_stream(const std::shared_ptr<const StreamBody> &body, const std::string &head, std::optional<size_t> content_length, bool chunked)
+{
+    // A body that fits below the watermark cannot get ahead of the client, so it is produced right away.
+    if (content_length && output_size + head.size() + *content_length <= OUTPUT_HIGH_WATERMARK)
+        return false;
+    if (!context.streams)
+        return false;
+    auto running = std::make_shared<Stream>();
+    running->unsent = output_size;
+    // A pool of its own rather than the executor: the producer waits whenever the client is slow, which would park a worker meanwhile.
+    context.streams->submit([sink = std::make_shared<StreamSink>(running, reactor, fd, connection_id), body, head, content_length, chunked]
+                            {
+                                bool complete = false;
+                                bool failed = false;
+                                try
+                                {
+                                    complete = ResponseWriter::write_stream(*body, head, content_length, chunked, *sink);
+                                }
+                                catch (...)
+                                {
+                                    failed = true;
+                                }
+                                sink->finish(complete, failed); });
+    stream = std::move(running);
+    return true;
+}
+
+void enderman::net::Connection::receive_stream(Stream &running, std::shared_ptr<const std::string> chunk)
+{
+    if (stream.get() != &running)
+        return;
+    // Time out only once the client stops taking this chunk, not for the time the producer took.
+    if (!has_pending_output())
+        last_active = std::chrono::steady_clock::now();
+    ConstBuffer buffer{chunk->data(), chunk->size()};
+    send(&buffer, 1, 0, chunk);
+    update_stream_credit(chunk->size());
+}
+
+void enderman::net::Connection::finish_stream(Stream &running, bool complete, bool producer_failed)
+{
+    if (stream.get() != &running)
+        return;
+    stream.reset();
+    last_active = std::chrono::steady_clock::now();
+    if (producer_failed)
+        http::write_error_response(sink);
+    if (!complete)
+        close_after_write = true;
+    process_input();
+    close_if_input_done();
+}
+
+void enderman::net::Connection::update_stream_credit(size_t received)
+{
+    if (!stream)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        if (received == 0 && stream->unsent == output_size)
+            return;
+        stream->received += received;
+        stream->unsent = output_size;
+    }
+    stream->credit.notify_all();
+}
+
+bool enderman::net::Connection::is_timed_out(std::chrono::steady_clock::time_point now) const
+{
+    if (handler_running || request_queued)
+        return false;
+    // Waiting for a producer with nothing left to write is not the client's doing.
+    if (stream && !has_pending_output())
+        return false;
+    bool between_requests = state == State::HEAD && input.empty() && !has_pending_output();
+    return now - last_active > (between_requests ? options.keep_alive_timeout : options.idle_timeout);
+}
@@ -0,0 +1,225 @@
+#ifndef ENDERMAN_NET_CONNECTION_HPP
+#define ENDERMAN_NET_CONNECTION_HPP
+
+#include "enderman/body.hpp"
+#include "enderman/cancellation.hpp"
+#include "enderman/route_options.hpp"
+#include "enderman/spooled_body.hpp"
+
+#include "../response_writer.hpp"
+#include "request_parser.hpp"
+#include "server.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace enderman
+{
+    namespace net
+    {
+        class Reactor;
+
+        /// @brief Client connection of a server loop: reads requests, frames their bodies and writes the responses.
+        /// Complete requests are queued with the loop's scheduler and handled on the loop thread once dispatched, pipelined requests in order;
+        /// the connection stops reading while its request is queued. Constant responses are answered right away.
+        /// Requests of offloaded routes run on the executor, requests of asynchronous routes resume on the loop when they are ready;
+        /// meanwhile the connection stops reading, and its loop writes their response once they are done, or 504 once their deadline passes.
+        /// Their request is cancelled when the deadline passes or the connection closes.
+        /// The loop never waits for a slow client: what the socket does not take stays pending until it is writable, see SocketSink.
+        class Connection
+        {
+        public:
+            /// @brief Pending output above which the connection stops reading and a streamed body waits for the client, see SocketSink.
+            static constexpr size_t OUTPUT_HIGH_WATERMARK = 256 * 1024;
+
+        private:
+            enum class State
+            {
+                HEAD,
+                /// @brief Reading a Content-Length body into a spool.
+                BODY,
+                /// @brief Reading a chunked body.
+                CHUNKED,
+            };
+
+            /// @brief Sink writing responses to the socket. Writes the new buffers right away if nothing is pending;
+            /// whatever the socket does not take is kept as pending output and written once the socket is writable again,
+            /// body buffers by reference to their body, the rest as a copy. Writes never wait for the client.
+            /// A StreamBody producer that could get ahead of the client by more than OUTPUT_HIGH_WATERMARK runs on the stream pool of the server,
+            /// hands its chunks to the loop and waits while more than OUTPUT_HIGH_WATERMARK of them is not written yet.
+            class SocketSink : public ResponseWriter::ResponseSink
+            {
+            private:
+                Connection &connection;
+
+            public:
+                explicit SocketSink(Connection &owner) : connection(owner) {}
+                bool write(const ConstBuffer *buffers, size_t count) override;
+                bool write(const ConstBuffer *buffers, size_t count, size_t first_owned, const std::shared_ptr<const void> &owner) override;
+                bool defer_stream(const std::shared_ptr<const StreamBody> &body, const std::string &head, std::optional<size_t> content_length, bool chunked) override;
+            };
+
+            /// @brief Part of the pending output: a copy, or a buffer viewing memory its owner keeps alive.
+            struct OutputSegment
+            {
+                std::string copy;
+                ConstBuffer view;
+                std::shared_ptr<const void> owner;
+
+                const char *data() const { return owner ? view.data : copy.data(); }
+                size_t size() const { return owner ? view.size : copy.size(); }
+            };
+
+            /// @brief Streamed body whose producer runs on the stream pool, shared with its producer.
+            struct Stream;
+            /// @brief Sink of a producer running on the stream pool, handing its chunks to the loop.
+            class StreamSink;
+
+            /// @brief Request of an offloaded or asynchronous route, owned by its handler and the loop until its response is written.
+            struct DetachedExchange;
+
+            int fd;
+            uint64_t connection_id;
+            std::string ip;
+            std::string port;
+            Reactor &reactor;
+            const ServerContext &context;
+            const ServerOptions &options;
+            SocketSink sink;
+            size_t requests_handled = 0;
+
+            State state = State::HEAD;
+            std::string input;
+            RequestHead head;
+            /// @brief Input size needed before the head parsed last can be handled, to avoid parsing it again on every read.
+            size_t awaited_size = 0;
+            bool continue_sent = false;
+            /// @brief Copy of the head while its body is read separately, since input is consumed meanwhile.
+            std::string head_storage;
+            RouteOptions route_options;
+            bool route_asynchronous = false;
+            size_t body_remaining = 0;
+            size_t body_size = 0;
+            std::unique_ptr<BodySpool> spool;
+            std::string chunked_body;
+            ChunkedDecoder chunked_decoder;
+
+            std::deque<OutputSegment> output;
+            /// @brief Bytes of the first segment already written.
+            size_t output_offset = 0;
+            /// @brief Bytes pending in total.
+            size_t output_size = 0;
+            /// @brief Stream whose producer runs, nullptr if none. The connection stops reading until it ends.
+            std::shared_ptr<Stream> stream;
+            bool close_after_write = false;
+            bool failed = false;
+            /// @brief True while the handler of an offloaded or asynchronous request runs.
+            bool handler_running = false;
+            /// @brief The client shut down its side; the connection closes once the complete requests are answered.
+            bool input_closed = false;
+            /// @brief Request whose offloaded or asynchronous handler runs, nullptr if none. A response it delivers later than its deadline is dropped.
+            std::shared_ptr<DetachedExchange> running_exchange;
+            /// @brief Deadline of the request run by dispatch(), applied by timed_handler.
+            std::chrono::steady_clock::time_point dispatch_deadline;
+            /// @brief Application handler setting the deadline of the request first. Kept for the connection to avoid wrapping the handler per request.
+            EndermanCallbackFunction timed_handler;
+
+            /// @brief True while the current request waits in the scheduler of the loop.
+            bool request_queued = false;
+            /// @brief Body of the queued request, viewing the input or chunked_body, which are left alone while it is queued.
+            std::string_view queued_body;
+            std::shared_ptr<Body> queued_spooled_body;
+            /// @brief Input to consume once the queued request is dispatched.
+            size_t queued_input_size = 0;
+            /// @brief Deadline of the queued request, see ServerOptions::request_timeout.
+            std::chrono::steady_clock::time_point queued_deadline;
+
+            /// @brief Handle every complete request in the input.
+            void process_input();
+            /// @brief Handle a request whose head is at the start of input.
+            /// @return False if processing has to stop until more input arrives.
+            bool handle_head();
+            /// @brief Start reading the body of the current head separately from the head.
+            void start_body_reading();
+            /// @brief Queue the request of the current head with the scheduler of the loop.
+            /// @param input_size Input taken by the request, consumed once it is dispatched.
+            void queue_request(std::string_view body, std::shared_ptr<Body> spooled_body, size_t input_size);
+            /// @param deadline Deadline of the request, time_point::max() for none.
+            void dispatch(std::string_view body, std::shared_ptr<Body> spooled_body, std::chrono::steady_clock::time_point deadline);
+            /// @brief Write the response of an offloaded or asynchronous request and resume reading, unless it was answered with 504 already. Runs on the loop thread.
+            void finish_detached(DetachedExchange &exchange);
+            /// @brief Answer the running offloaded or asynchronous request with 504 and cancel it, if its deadline passed. Runs on the loop thread.
+            /// @param cancellation Cancellation of the request the deadline is for, to tell it from the requests handled since.
+            void expire_detached(const CancellationToken &cancellation);
+            /// @brief Write the response of a queued request answered without running it, then go on like run_queued().
+            void answer_queued(Response &response);
+            /// @brief Answer with an error status and close the connection once it is written.
+            void reject(int status_code);
+            void send_continue();
+            void consume_input(size_t size);
+            /// @brief Close after the last response once the client shut down its side and no request is left.
+            void close_if_input_done();
+
+            /// @brief Write buffers, keeping what the socket does not take as pending output.
+            /// @param first_owned Index of the first buffer owner keeps valid; those are kept by reference, the ones before are copied.
+            bool send(const ConstBuffer *buffers, size_t count, size_t first_owned, const std::shared_ptr<const void> &owner);
+            /// @brief Queue the producer of a streamed body with the stream pool, unless the body is short enough to produce right away.
+            /// @return False if the producer has to run now.
+            bool start_stream(const std::shared_ptr<const StreamBody> &body, const std::string &head, std::optional<size_t> content_length, bool chunked);
+            /// @brief Write a chunk the producer of the stream handed over. Runs on the loop thread.
+            void receive_stream(Stream &running, std::shared_ptr<const std::string> chunk);
+            /// @brief End the stream once its producer returned, then resume reading. Runs on the loop thread.
+            /// @param complete The response was sent completely.
+            /// @param producer_failed The producer threw before anything was sent, so the response is an error.
+            void finish_stream(Stream &running, bool complete, bool producer_failed);
+            /// @brief Tell the producer of the stream how much of its output is still to be written.
+            /// @param received Bytes of the stream just received from the producer.
+            void update_stream_credit(size_t received = 0);
+
+        public:
+            /// @param id Identifier of the connection, unique within its loop.
+            /// @param owner Loop of the connection, to which offloaded requests hand back their response.
+            Connection(int socket, uint64_t id, std::string client_ip, std::string client_port, Reactor &owner, const ServerContext &server_context, const ServerOptions &server_options);
+            ~Connection();
+            Connection(const Connection &) = delete;
+            Connection &operator=(const Connection &) = delete;
+
+            int socket() const { return fd; }
+            uint64_t id() const { return connection_id; }
+            std::chrono::steady_clock::time_point last_active;
+
+            /// @brief Read what the client sent and handle complete requests.
+            /// @return False if the connection has to be closed.
+            bool on_readable();
+            /// @brief Write pending output.
+            /// @return False if the connection has to be closed.
+            bool on_writable();
+            /// @brief Handle the queued request, then the pipelined requests after it until one is queued again. Called by the loop when it is its turn.
+            void run_queued();
+            /// @brief Answer the queued request with 503 and Retry-After without running it, then go on like run_queued().
+            /// A request whose deadline passed in the queue is answered with 504 by run_queued() instead.
+            void shed(std::chrono::seconds retry_after);
+            /// @brief Write as much pending output as the socket takes.
+            /// @return False if the client is gone.
+            bool flush();
+
+            bool has_pending_output() const { return output_size > 0; }
+            /// @brief Reading stops while the client does not take its responses.
+            bool wants_input() const { return !close_after_write && !input_closed && !handler_running && !request_queued && !stream && output_size <= OUTPUT_HIGH_WATERMARK; }
+            bool is_finished() const { return failed || (close_after_write && !handler_running && !request_queued && !stream && !has_pending_output()); }
+            bool is_handler_running() const { return handler_running; }
+            bool is_request_queued() const { return request_queued; }
+            /// @brief Check the connection against keep_alive_timeout while it waits for a new request, against idle_timeout otherwise.
+            /// A connection whose request is queued or whose handler is still running does not time out, nor one waiting for the producer of its stream.
+            bool is_timed_out(std::chrono::steady_clock::time_point now) const;
+        };
+    }
+}
+
+#endif // ENDERMAN_NET_CONNECTION_HPP
@@ -0,0 +1,451 @@
+#include "reactor.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr int MAX_EVENTS = 256;
+    /// @brief Longest epoll wait, so idle connections are closed even when nothing happens.
+    constexpr std::chrono::milliseconds MAX_WAIT(1000);
+    /// @brief Longest the loop dispatches queued requests before it polls again, so requests arriving meanwhile are ranked against the rest of the queue.
+    constexpr std::chrono::milliseconds DISPATCH_SLICE(1);
+
+    std::string socket_error(const std::string &what)
+    {
+        return what + ": " + std::strerror(errno);
+    }
+}
+
+enderman::net::Reactor::Reactor(const ServerContext &server_context, const ServerOptions &server_options, unsigned short port, size_t connection_limit)
+    : context(server_context), options(server_options), max_connections(connection_limit), scheduler(server_options), admission(server_options)
+{
+    open_listening_socket(port);
+    epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0)
+    {
+        std::string message = socket_error("Unable to create epoll instance");
+        ::close(listen_fd);
+        throw Server::UnableToListenException(message);
+    }
+    wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0)
+    {
+        std::string message = socket_error("Unable to create wake up event");
+        ::close(epoll_fd);
+        ::close(listen_fd);
+        throw Server::UnableToListenException(message);
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd;
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    event.data.fd = wake_fd;
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+}
+
+void enderman::net::Reactor::open_listening_socket(unsigned short port)
+{
+    listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0)
+        throw Server::UnableToListenException(socket_error("Unable to create listening socket"));
+    auto set_option = [this](int level, int name, int value, const char *what)
+    {
+        if (::setsockopt(listen_fd, level, name, &value, sizeof(value)) < 0)
+        {
+            std::string message = socket_error(std::string("Unable to set ") + what);
+            ::close(listen_fd);
+            throw Server::UnableToListenException(message);
+        }
+    };
+    set_option(SOL_SOCKET, SO_REUSEADDR, 1, "SO_REUSEADDR");
+    set_option(SOL_SOCKET, SO_REUSEPORT, 1, "SO_REUSEPORT");
+    // Accepted connections inherit the buffer sizes; they must be set before listen() for the TCP window scale to match.
+    if (options.receive_buffer_size > 0)
+        set_option(SOL_SOCKET, SO_RCVBUF, static_cast<int>(options.receive_buffer_size), "SO_RCVBUF");
+    if (options.send_buffer_size > 0)
+        set_option(SOL_SOCKET, SO_SNDBUF, static_cast<int>(options.send_buffer_size), "SO_SNDBUF");
+    if (options.defer_accept.count() > 0)
+        set_option(IPPROTO_TCP, TCP_DEFER_ACCEPT, static_cast<int>(options.defer_accept.count()), "TCP_DEFER_ACCEPT");
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    int backlog = options.backlog > 0 ? static_cast<int>(options.backlog) : SOMAXCONN;
+    if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || ::listen(listen_fd, backlog) < 0)
+    {
+        std::string message = socket_error("Unable to listen on port " + std::to_string(port));
+        ::close(listen_fd);
+        throw Server::UnableToListenException(message);
+    }
+    // Fast Open can be disabled system wide (net.ipv4.tcp_fastopen), which is no reason not to serve.
+    if (options.fastopen_queue > 0)
+    {
+        int queue = static_cast<int>(options.fastopen_queue);
+        if (::setsockopt(listen_fd, IPPROTO_TCP, TCP_FASTOPEN, &queue, sizeof(queue)) < 0)
+            std::cerr << socket_error("TCP_FASTOPEN not enabled") << std::endl;
+    }
+}
+
+enderman::net::Reactor::~Reactor()
+{
+    connections.clear();
+    if (wake_fd >= 0)
+        ::close(wake_fd);
+    if (epoll_fd >= 0)
+        ::close(epoll_fd);
+    if (listen_fd >= 0)
+        ::close(listen_fd);
+}
+
+void enderman::net::Reactor::run()
+{
+    Binding binding(this);
+    epoll_event events[MAX_EVENTS];
+    auto last_sweep = std::chrono::steady_clock::now();
+    while (true)
+    {
+        int count = ::epoll_wait(epoll_fd, events, MAX_EVENTS, wait_timeout());
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            std::cerr << socket_error("Server loop stopped, epoll_wait failed") << std::endl;
+            return;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd)
+            {
+                accept_connections();
+                continue;
+            }
+            if (fd == wake_fd)
+            {
+                run_posted();
+                continue;
+            }
+            auto watched = watchers.find(fd);
+            if (watched != watchers.end())
+            {
+                run_watchers(watched, events[i].events);
+                continue;
+            }
+            auto it = connections.find(fd);
+            if (it == connections.end())
+                continue;
+            Connection &connection = *it->second.connection;
+            uint32_t ready = events[i].events;
+            // A client gone while its request is queued or its handler runs elsewhere cannot be answered; the request is dropped.
+            bool open = !(ready & EPOLLERR) && !((ready & EPOLLHUP) && (connection.is_request_queued() || connection.is_handler_running()));
+            if (open && (ready & EPOLLOUT))
+                open = connection.on_writable();
+            if (open && (ready & (EPOLLIN | EPOLLHUP | EPOLLRDHUP)))
+                open = connection.on_readable();
+            if (open)
+                update_events(it->second);
+            else
+                close_connection(fd);
+        }
+
+        run_timers();
+        dispatch_queued();
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_sweep >= std::chrono::seconds(1))
+        {
+            close_idle_connections();
+            last_sweep = now;
+        }
+    }
+}
+
+void enderman::net::Reactor::accept_connections()
+{
+    while (true)
+    {
+        sockaddr_in address{};
+        socklen_t length = sizeof(address);
+        int fd = ::accept4(listen_fd, reinterpret_cast<sockaddr *>(&address), &length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                std::cerr << socket_error("Unable to accept connection") << std::endl;
+            return;
+        }
+        // Responses are written whole, so delaying small segments only adds latency.
+        if (options.tcp_nodelay)
+        {
+            int enable = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+
+        char ip[INET_ADDRSTRLEN] = {};
+        ::inet_ntop(AF_INET, &address.sin_addr, ip, sizeof(ip));
+        Entry entry{std::make_unique<Connection>(fd, ++next_connection_id, ip, std::to_string(ntohs(address.sin_port)), *this, context, options), EPOLLIN | EPOLLRDHUP};
+        epoll_event event{};
+        event.events = entry.events;
+        event.data.fd = fd;
+        if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+        {
+            std::cerr << socket_error("Unable to watch connection") << std::endl;
+            continue;
+        }
+        connections.emplace(fd, std::move(entry));
+        if (max_connections > 0 && connections.size() >= max_connections)
+        {
+            set_accepting(false);
+            return;
+        }
+    }
+}
+
+void enderman::net::Reactor::set_accepting(bool enabled)
+{
+    if (accepting == enabled)
+        return;
+    epoll_event event{};
+    event.events = enabled ? static_cast<uint32_t>(EPOLLIN) : 0u;
+    event.data.fd = listen_fd;
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, listen_fd, &event);
+    accepting = enabled;
+}
+
+void enderman::net::Reactor::close_connection(int fd)
+{
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    auto it = connections.find(fd);
+    if (it == connections.end())
+        return;
+    if (it->second.in_flight)
+        scheduler.finish(*it->second.in_flight);
+    connections.erase(it);
+    if (!accepting && connections.size() < max_connections)
+        set_accepting(true);
+}
+
+void enderman::net::Reactor::update_events(Entry &entry)
+{
+    const Connection &connection = *entry.connection;
+    uint32_t events = 0;
+    if (connection.wants_input())
+        events |= EPOLLIN | EPOLLRDHUP;
+    if (connection.has_pending_output())
+        events |= EPOLLOUT;
+    if (events == entry.events)
+        return;
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = connection.socket();
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.socket(), &event);
+    entry.events = events;
+}
+
+void enderman::net::Reactor::close_idle_connections()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::vector<int> idle;
+    for (const auto &entry : connections)
+    {
+        if (entry.second.connection->is_timed_out(now))
+            idle.push_back(entry.first);
+    }
+    for (int fd : idle)
+        close_connection(fd);
+}
+
+void enderman::net::Reactor::post(int fd, uint64_t connection_id, Completion completion)
+{
+    post([this, fd, connection_id, completion = std::move(completion)]
+         {
+             auto it = connections.find(fd);
+             if (it == connections.end() || it->second.connection->id() != connection_id)
+                 return;
+             Connection &connection = *it->second.connection;
+             completion(connection);
+             if (it->second.in_flight && !connection.is_handler_running())
+             {
+                 scheduler.finish(*it->second.in_flight);
+                 it->second.in_flight = nullptr;
+             }
+             if (connection.is_finished())
+                 close_connection(fd);
+             else
+                 update_events(it->second); });
+}
+
+void enderman::net::Reactor::schedule(const Connection &connection, Priority priority, std::string_view client_key)
+{
+    scheduler.push(RequestScheduler::Entry{connection.socket(), connection.id(), priority, std::chrono::steady_clock::now()}, client_key);
+    if (context.monitor)
+        context.monitor->on_request_queued(priority);
+}
+
+void enderman::net::Reactor::dispatch_queued()
+{
+    auto now = std::chrono::steady_clock::now();
+    auto slice_end = now + DISPATCH_SLICE;
+    while (scheduler.ready())
+    {
+        RequestScheduler::Entry next = scheduler.pop(now);
+        if (context.monitor)
+            context.monitor->on_request_dequeued(next.priority, std::chrono::duration_cast<std::chrono::nanoseconds>(now - next.queued_at));
+        auto it = connections.find(next.fd);
+        if (it == connections.end() || it->second.connection->id() != next.connection_id)
+        {
+            scheduler.done(next, std::chrono::nanoseconds::zero(), false);
+            continue;
+        }
+        Connection &connection = *it->second.connection;
+        // High priority routes are exempt, and do not take part in the measurement: they skip the queue that is being judged.
+        if (next.priority != Priority::HIGH && admission.should_shed(now - next.queued_at, now))
+        {
+            connection.shed(options.shed_retry_after);
+            if (context.monitor)
+                context.monitor->on_request_shed();
+        }
+        else
+            connection.run_queued();
+        auto finished = std::chrono::steady_clock::now();
+        bool in_flight = connection.is_handler_running();
+        scheduler.done(next, std::chrono::duration_cast<std::chrono::nanoseconds>(finished - now), in_flight);
+        if (in_flight)
+            it->second.in_flight = next.client;
+        if (connection.is_finished())
+            close_connection(next.fd);
+        else
+            update_events(it->second);
+        now = finished;
+        if (now >= slice_end)
+            return;
+    }
+}
+
+void enderman::net::Reactor::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex);
+        posted.push_back(std::move(task));
+    }
+    uint64_t one = 1;
+    ssize_t written = ::write(wake_fd, &one, sizeof(one));
+    (void)written;
+}
+
+void enderman::net::Reactor::run_posted()
+{
+    uint64_t count;
+    ssize_t received = ::read(wake_fd, &count, sizeof(count));
+    (void)received;
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex);
+        ready.swap(posted);
+    }
+    for (auto &task : ready)
+        task();
+}
+
+void enderman::net::Reactor::add_timer(std::chrono::steady_clock::time_point deadline, std::function<void()> callback)
+{
+    timers.push(Timer{deadline, next_timer_sequence++, std::move(callback)});
+}
+
+void enderman::net::Reactor::run_timers()
+{
+    auto now = std::chrono::steady_clock::now();
+    while (!timers.empty() && timers.top().deadline <= now)
+    {
+        // A callback may add timers, so take it out first.
+        std::function<void()> callback = std::move(const_cast<Timer &>(timers.top()).callback);
+        timers.pop();
+        callback();
+    }
+}
+
+int enderman::net::Reactor::wait_timeout()
+{
+    if (scheduler.ready())
+        return 0;
+    if (timers.empty())
+        return static_cast<int>(MAX_WAIT.count());
+    auto remaining = timers.top().deadline - std::chrono::steady_clock::now();
+    if (remaining <= std::chrono::steady_clock::duration::zero())
+        return 0;
+    // Round up so the timer has expired when epoll returns.
+    auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(remaining);
+    return static_cast<int>(std::min(milliseconds, MAX_WAIT).count());
+}
+
+bool enderman::net::Reactor::watch(int fd, bool writable, std::function<void()> callback)
+{
+    uint32_t wanted = writable ? EPOLLOUT : EPOLLIN;
+    epoll_event event{};
+    event.events = wanted | EPOLLONESHOT;
+    event.data.fd = fd;
+    auto watched = watchers.find(fd);
+    if (watched != watchers.end())
+    {
+        // Several coroutines may wait for the same descriptor, or for both of its directions.
+        for (const Watcher &watcher : watched->second)
+            event.events |= watcher.events;
+        if (::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) < 0)
+            return false;
+        watched->second.push_back(Watcher{wanted, std::move(callback)});
+        return true;
+    }
+    if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+        return false;
+    watchers[fd].push_back(Watcher{wanted, std::move(callback)});
+    return true;
+}
+
+void enderman::net::Reactor::run_watchers(std::unordered_map<int, std::vector<Watcher>>::iterator watched, uint32_t ready)
+{
+    int fd = watched->first;
+    std::vector<Watcher> waiting = std::move(watched->second);
+    watchers.erase(watched);
+    std::vector<Watcher> resumed;
+    std::vector<Watcher> still_waiting;
+    uint32_t remaining = 0;
+    for (Watcher &watcher : waiting)
+    {
+        // Errors and hangups wake every watcher; the operation it retries reports them.
+        if (ready & (watcher.events | EPOLLERR | EPOLLHUP))
+            resumed.push_back(std::move(watcher));
+        else
+        {
+            remaining |= watcher.events;
+            still_waiting.push_back(std::move(watcher));
+        }
+    }
+    if (still_waiting.empty())
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    else
+    {
+        epoll_event event{};
+        event.events = remaining | EPOLLONESHOT;
+        event.data.fd = fd;
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+        watchers.emplace(fd, std::move(still_waiting));
+    }
+    // Registered again first, so a callback may watch the descriptor again.
+    for (Watcher &watcher : resumed)
+        watcher.callback();
+}
@@ -0,0 +1,131 @@
+#ifndef ENDERMAN_NET_REACTOR_HPP
+#define ENDERMAN_NET_REACTOR_HPP
+
+#include "admission.hpp"
+#include "connection.hpp"
+#include "scheduler.hpp"
+#include "server.hpp"
+
+#include "../event_loop.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace enderman
+{
+    namespace net
+    {
+        /// @brief One server loop: an epoll instance with its own listening socket and the connections it accepted.
+        /// All its work happens on the thread calling run(); other threads hand work back to it with post().
+        /// Complete requests wait in its RequestScheduler until it dispatches them after each round of I/O.
+        /// It is the EventLoop asynchronous handlers of its connections resume on.
+        class Reactor : public EventLoop
+        {
+        public:
+            /// @brief Work for a connection, run on the loop thread.
+            using Completion = std::function<void(Connection &connection)>;
+
+        private:
+            struct Entry
+            {
+                std::unique_ptr<Connection> connection;
+                /// @brief Events the connection is registered for.
+                uint32_t events;
+                /// @brief Client charged with the offloaded or asynchronous handler of the connection while it runs.
+                RequestScheduler::Client *in_flight = nullptr;
+            };
+
+            struct Timer
+            {
+                std::chrono::steady_clock::time_point deadline;
+                /// @brief Keeps timers with the same deadline in the order they were added.
+                uint64_t sequence;
+                std::function<void()> callback;
+
+                bool operator>(const Timer &other) const { return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence; }
+            };
+
+            struct Watcher
+            {
+                /// @brief EPOLLIN or EPOLLOUT.
+                uint32_t events;
+                std::function<void()> callback;
+            };
+
+            const ServerContext &context;
+            const ServerOptions &options;
+            /// @brief Most connections of this loop, 0 for no limit.
+            size_t max_connections;
+            int listen_fd = -1;
+            int epoll_fd = -1;
+            /// @brief False while the loop is at its connection limit; new connections then wait in the backlog.
+            bool accepting = true;
+            std::unordered_map<int, Entry> connections;
+            /// @brief Identifies connections across fd reuse, so work posted for a closed connection is dropped.
+            uint64_t next_connection_id = 0;
+            /// @brief eventfd waking the loop when work is posted.
+            int wake_fd = -1;
+            std::mutex posted_mutex;
+            std::vector<std::function<void()>> posted;
+            std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+            uint64_t next_timer_sequence = 0;
+            /// @brief Callbacks waiting for the file descriptors watched for asynchronous handlers, by descriptor.
+            /// A descriptor is registered once, for the union of the events its watchers wait for.
+            std::unordered_map<int, std::vector<Watcher>> watchers;
+            RequestScheduler scheduler;
+            AdmissionController admission;
+
+            void open_listening_socket(unsigned short port);
+            void set_accepting(bool enabled);
+            void accept_connections();
+            void close_connection(int fd);
+            /// @brief Register the connection for the events it waits for: input unless its output is backed up, output while some is pending.
+            void update_events(Entry &entry);
+            void close_idle_connections();
+            /// @brief Run the work posted since the last wake up.
+            void run_posted();
+            /// @brief Run the timers whose deadline passed.
+            void run_timers();
+            /// @brief Run the watchers of a descriptor the events are ready for, and register it again for the others.
+            void run_watchers(std::unordered_map<int, std::vector<Watcher>>::iterator watched, uint32_t ready);
+            /// @brief Run queued requests in scheduling order for one dispatch slice, shedding those the admission controller rejects.
+            void dispatch_queued();
+            /// @brief Time epoll may wait: not at all while requests are queued, otherwise until the next timer, at most a second so idle connections are swept.
+            int wait_timeout();
+
+        public:
+            /// @brief Open the listening socket of the loop, bound with SO_REUSEPORT and configured from the options.
+            /// @param connection_limit Most connections of this loop, 0 for no limit.
+            /// @throws Server::UnableToListenException if the socket cannot be opened, configured or bound.
+            Reactor(const ServerContext &server_context, const ServerOptions &server_options, unsigned short port, size_t connection_limit);
+            ~Reactor() override;
+            Reactor(const Reactor &) = delete;
+            Reactor &operator=(const Reactor &) = delete;
+
+            /// @brief Run the loop. Returns only if epoll fails.
+            void run();
+            /// @brief Run work for a connection on the loop thread. Thread safe.
+            /// The work is dropped if the connection is closed before the loop gets to it.
+            /// @param fd Socket of the connection.
+            /// @param connection_id Connection::id() of the connection.
+            void post(int fd, uint64_t connection_id, Completion completion);
+            /// @brief Queue the complete request of a connection for dispatch. The loop calls Connection::run_queued() once it is its turn.
+            /// @param client_key Client the request counts against for fair scheduling.
+            void schedule(const Connection &connection, Priority priority, std::string_view client_key);
+
+            void post(std::function<void()> task) override;
+            void add_timer(std::chrono::steady_clock::time_point deadline, std::function<void()> callback) override;
+            bool watch(int fd, bool writable, std::function<void()> callback) override;
+            Executor *executor() override { return context.executor; }
+        };
+    }
+}
+
+#endif // ENDERMAN_NET_REACTOR_HPP
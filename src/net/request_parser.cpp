@@ -0,0 +1,172 @@
+#include "request_parser.hpp"
+
+#include "enderman/headers.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+namespace
+{
+    std::string_view trim(std::string_view value)
+    {
+        size_t start = value.find_first_not_of(" \t");
+        if (start == std::string_view::npos)
+            return std::string_view();
+        size_t end = value.find_last_not_of(" \t");
+        return value.substr(start, end - start + 1);
+    }
+
+    /// @brief Check for a tchar, the characters of field names and transfer codings (RFC 9110 §5.6.2).
+    bool is_token_char(char c)
+    {
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
+            return true;
+        switch (c)
+        {
+        case '!':
+        case '#':
+        case '$':
+        case '%':
+        case '&':
+        case '\'':
+        case '*':
+        case '+':
+        case '-':
+        case '.':
+        case '^':
+        case '_':
+        case '`':
+        case '|':
+        case '~':
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool is_token(std::string_view value)
+    {
+        return !value.empty() && std::all_of(value.begin(), value.end(), is_token_char);
+    }
+
+    /// @brief Check a comma separated header value for a token, e.g. "close" in "Connection: keep-alive, close".
+    bool has_token(std::string_view value, std::string_view token)
+    {
+        while (!value.empty())
+        {
+            size_t comma = value.find(',');
+            if (enderman::Headers::equals_ignore_case(trim(value.substr(0, comma)), token))
+                return true;
+            value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+        }
+        return false;
+    }
+}
+
+enderman::net::RequestParser::Result enderman::net::RequestParser::parse_head(std::string_view data, RequestHead &head)
+{
+    head.clear();
+    size_t end = data.find("\r\n\r\n");
+    if (end == std::string_view::npos)
+        return data.size() > MAX_HEAD_SIZE ? Result::TOO_LARGE : Result::INCOMPLETE;
+    if (end + 4 > MAX_HEAD_SIZE)
+        return Result::TOO_LARGE;
+    head.size = end + 4;
+    // Lines end with CRLF only; a lone CR or LF is read as a line break by some parsers and not by others.
+    for (size_t i = 0; i < end + 2; ++i)
+    {
+        if (data[i] == '\0')
+            return Result::MALFORMED;
+        if (data[i] == '\r' && data[i + 1] != '\n')
+            return Result::MALFORMED;
+        if (data[i] == '\n' && (i == 0 || data[i - 1] != '\r'))
+            return Result::MALFORMED;
+    }
+
+    size_t line_end = data.find("\r\n");
+    std::string_view request_line = data.substr(0, line_end);
+    size_t first_space = request_line.find(' ');
+    size_t last_space = request_line.rfind(' ');
+    if (first_space == std::string_view::npos || first_space == 0 || last_space == first_space)
+        return Result::MALFORMED;
+    head.method.assign(request_line.data(), first_space);
+    head.uri = request_line.substr(first_space + 1, last_space - first_space - 1);
+    std::string_view version = request_line.substr(last_space + 1);
+    if (head.uri.empty() || version.substr(0, 7) != "HTTP/1.")
+        return Result::MALFORMED;
+    bool http_1_0 = version == "HTTP/1.0";
+    head.http_1_0 = http_1_0;
+    head.keep_alive = !http_1_0;
+
+    bool transfer_encoded = false;
+    bool unsupported_coding = false;
+    size_t position = line_end + 2;
+    while (position < end + 2)
+    {
+        line_end = data.find("\r\n", position);
+        std::string_view line = data.substr(position, line_end - position);
+        position = line_end + 2;
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos)
+            return Result::MALFORMED;
+        // Also rejects whitespace before the colon and obsolete line folding, which starts with whitespace (RFC 9112 §5.1, §5.2).
+        std::string_view name = line.substr(0, colon);
+        if (!is_token(name))
+            return Result::MALFORMED;
+        std::string_view value = trim(line.substr(colon + 1));
+        head.headers.emplace_back(name, value);
+
+        switch (Headers::classify(name))
+        {
+        case WellKnownHeader::CONTENT_LENGTH:
+        {
+            size_t length = 0;
+            auto result = std::from_chars(value.data(), value.data() + value.size(), length);
+            if (result.ec != std::errc() || result.ptr != value.data() + value.size())
+                return Result::MALFORMED;
+            if (head.content_length && *head.content_length != length)
+                return Result::MALFORMED;
+            head.content_length = length;
+            break;
+        }
+        case WellKnownHeader::TRANSFER_ENCODING:
+            // Codings apply in order across all the fields; chunked must be the final one, and only once (RFC 9112 §6.1).
+            transfer_encoded = true;
+            while (!value.empty())
+            {
+                size_t comma = value.find(',');
+                std::string_view coding = trim(value.substr(0, comma));
+                value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+                if (coding.empty())
+                    continue;
+                if (head.chunked)
+                    return Result::MALFORMED;
+                if (Headers::equals_ignore_case(coding, "chunked"))
+                    head.chunked = true;
+                else if (is_token(coding.substr(0, coding.find(';'))))
+                    unsupported_coding = true;
+                else
+                    return Result::MALFORMED;
+            }
+            break;
+        case WellKnownHeader::CONNECTION:
+            if (has_token(value, "close"))
+                head.keep_alive = false;
+            else if (http_1_0 && has_token(value, "keep-alive"))
+                head.keep_alive = true;
+            break;
+        default:
+            if (Headers::equals_ignore_case(name, "expect") && Headers::equals_ignore_case(value, "100-continue"))
+                head.expect_continue = true;
+            break;
+        }
+    }
+    // Without chunked last, the body length cannot be determined. A message with both is a request smuggling attempt.
+    if (transfer_encoded && !head.chunked)
+        return Result::MALFORMED;
+    if (head.chunked && head.content_length)
+        return Result::MALFORMED;
+    if (unsupported_coding)
+        return Result::UNSUPPORTED;
+    return Result::COMPLETE;
+}
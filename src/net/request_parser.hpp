@@ -0,0 +1,158 @@
+#ifndef ENDERMAN_NET_REQUEST_PARSER_HPP
+#define ENDERMAN_NET_REQUEST_PARSER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace enderman
+{
+    namespace net
+    {
+        /// @brief Request line and headers of an HTTP/1.x request, viewing the buffer they were parsed from.
+        struct RequestHead
+        {
+            std::string method;
+            std::string_view uri;
+            std::vector<std::pair<std::string_view, std::string_view>> headers;
+            /// @brief Size of the request line and the headers, including the empty line.
+            size_t size = 0;
+            /// @brief Body length from Content-Length, std::nullopt if there is none.
+            std::optional<size_t> content_length;
+            bool chunked = false;
+            /// @brief False for HTTP/1.0 requests without keep-alive and requests with Connection: close.
+            bool keep_alive = true;
+            /// @brief HTTP/1.0 request, whose client cannot read chunked bodies.
+            bool http_1_0 = false;
+            bool expect_continue = false;
+
+            void clear()
+            {
+                method.clear();
+                uri = std::string_view();
+                headers.clear();
+                size = 0;
+                content_length.reset();
+                chunked = false;
+                keep_alive = true;
+                http_1_0 = false;
+                expect_continue = false;
+            }
+        };
+
+        /// @brief Parser of HTTP/1.x request heads. Bodies are framed by the caller from content_length and chunked.
+        class RequestParser
+        {
+        public:
+            enum class Result
+            {
+                COMPLETE,
+                INCOMPLETE,
+                MALFORMED,
+                TOO_LARGE,
+                /// @brief The request uses a transfer coding other than chunked, answered with 501 (RFC 9112 §6.1).
+                UNSUPPORTED,
+            };
+
+            /// @brief Largest request head accepted.
+            static constexpr size_t MAX_HEAD_SIZE = 64 * 1024;
+
+            /// @brief Parse the head at the start of data.
+            /// Anything that could frame the body differently than a proxy in front does is MALFORMED: field names that are not tokens, e.g. with whitespace before the colon,
+            /// bare CR or LF, obsolete line folding, conflicting Content-Length values, and Transfer-Encoding whose final coding is not chunked.
+            /// @param head Parsed head, viewing data. Only valid if COMPLETE is returned.
+            /// @return INCOMPLETE until the empty line ending the head was received.
+            static Result parse_head(std::string_view data, RequestHead &head);
+        };
+
+        /// @brief Incremental decoder of Transfer-Encoding: chunked bodies.
+        class ChunkedDecoder
+        {
+        private:
+            enum class State
+            {
+                SIZE,
+                DATA,
+                DATA_END,
+                TRAILER,
+                DONE,
+            };
+            State state = State::SIZE;
+            size_t remaining = 0;
+
+        public:
+            /// @brief Decode as much of data as possible.
+            /// @param on_data Called with every decoded piece of the body.
+            /// @return Number of bytes of data consumed, or std::nullopt if the encoding is malformed.
+            template <typename OnData>
+            std::optional<size_t> feed(std::string_view data, OnData &&on_data);
+
+            bool done() const { return state == State::DONE; }
+            void reset()
+            {
+                state = State::SIZE;
+                remaining = 0;
+            }
+        };
+
+        template <typename OnData>
+        std::optional<size_t> ChunkedDecoder::feed(std::string_view data, OnData &&on_data)
+        {
+            size_t position = 0;
+            while (position < data.size() && state != State::DONE)
+            {
+                if (state == State::DATA)
+                {
+                    size_t size = std::min(remaining, data.size() - position);
+                    on_data(data.data() + position, size);
+                    position += size;
+                    remaining -= size;
+                    if (remaining == 0)
+                        state = State::DATA_END;
+                    continue;
+                }
+                size_t end = data.find("\r\n", position);
+                if (end == std::string_view::npos)
+                {
+                    // Size lines and trailers are short, anything longer is not a chunked body.
+                    if (data.size() - position > 1024)
+                        return std::nullopt;
+                    break;
+                }
+                std::string_view line = data.substr(position, end - position);
+                position = end + 2;
+                if (state == State::DATA_END)
+                {
+                    if (!line.empty())
+                        return std::nullopt;
+                    state = State::SIZE;
+                }
+                else if (state == State::SIZE)
+                {
+                    line = line.substr(0, line.find(';'));
+                    if (line.empty() || line.size() > 15)
+                        return std::nullopt;
+                    size_t size = 0;
+                    for (char c : line)
+                    {
+                        int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+                        if (digit < 0)
+                            return std::nullopt;
+                        size = size * 16 + static_cast<size_t>(digit);
+                    }
+                    remaining = size;
+                    state = size == 0 ? State::TRAILER : State::DATA;
+                }
+                else if (line.empty())
+                    state = State::DONE;
+            }
+            return position;
+        }
+    }
+}
+
+#endif // ENDERMAN_NET_REQUEST_PARSER_HPP
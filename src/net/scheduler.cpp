@@ -0,0 +1,169 @@
+#include "scheduler.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    /// @brief Loop time granted to a client per turn. Requests are charged what they took, so short requests are dispatched several per turn.
+    constexpr std::chrono::microseconds QUANTUM(500);
+}
+
+enderman::net::RequestScheduler::RequestScheduler(const ServerOptions &options)
+    : policy(options.scheduling),
+      weights(options.priority_weights),
+      starvation_timeout(options.starvation_timeout),
+      max_client_concurrency(options.max_client_concurrency) {}
+
+void enderman::net::RequestScheduler::push(Entry entry, std::string_view client_key)
+{
+    auto it = clients.find(std::string(client_key));
+    if (it == clients.end())
+    {
+        it = clients.emplace(std::string(client_key), Client()).first;
+        it->second.key = it->first;
+    }
+    Client &client = it->second;
+    size_t priority = static_cast<size_t>(entry.priority);
+    entry.client = &client;
+    client.lanes[priority].queue.push_back(entry);
+    ++client.queued;
+    ++count;
+    if (!at_limit(client))
+        activate(client, priority);
+}
+
+void enderman::net::RequestScheduler::activate(Client &client, size_t priority)
+{
+    Lane &lane = client.lanes[priority];
+    if (lane.active || lane.queue.empty())
+        return;
+    lane.active = true;
+    rounds[priority].push_back(&client);
+}
+
+void enderman::net::RequestScheduler::prune(size_t priority)
+{
+    std::deque<Client *> &round = rounds[priority];
+    while (!round.empty() && at_limit(*round.front()))
+    {
+        round.front()->lanes[priority].active = false;
+        round.pop_front();
+    }
+}
+
+bool enderman::net::RequestScheduler::ready()
+{
+    for (size_t i = 0; i < PRIORITY_CLASSES; ++i)
+    {
+        prune(i);
+        if (!rounds[i].empty())
+            return true;
+    }
+    return false;
+}
+
+enderman::net::RequestScheduler::Entry enderman::net::RequestScheduler::pop(std::chrono::steady_clock::time_point now)
+{
+    size_t priority = next_class(now);
+    std::deque<Client *> &round = rounds[priority];
+    while (true)
+    {
+        prune(priority);
+        Client &client = *round.front();
+        Lane &lane = client.lanes[priority];
+        // A client that used up its turn goes to the back with a new quantum.
+        if (lane.deficit <= std::chrono::nanoseconds::zero())
+        {
+            lane.deficit += QUANTUM;
+            round.pop_front();
+            round.push_back(&client);
+            continue;
+        }
+        Entry entry = lane.queue.front();
+        lane.queue.pop_front();
+        --client.queued;
+        --count;
+        if (lane.queue.empty())
+        {
+            lane.active = false;
+            round.pop_front();
+        }
+        return entry;
+    }
+}
+
+void enderman::net::RequestScheduler::done(const Entry &entry, std::chrono::nanoseconds cost, bool in_flight)
+{
+    Client &client = *entry.client;
+    Lane &lane = client.lanes[static_cast<size_t>(entry.priority)];
+    lane.deficit -= cost;
+    // An idle client keeps its debt but not its credit, which would let it burst once it comes back.
+    if (lane.queue.empty() && lane.deficit > std::chrono::nanoseconds::zero())
+        lane.deficit = std::chrono::nanoseconds::zero();
+    if (in_flight)
+        ++client.in_flight;
+    release_if_idle(client);
+}
+
+void enderman::net::RequestScheduler::finish(Client &client)
+{
+    --client.in_flight;
+    if (!at_limit(client))
+    {
+        for (size_t i = 0; i < PRIORITY_CLASSES; ++i)
+            activate(client, i);
+    }
+    release_if_idle(client);
+}
+
+void enderman::net::RequestScheduler::release_if_idle(Client &client)
+{
+    if (client.queued == 0 && client.in_flight == 0)
+        clients.erase(clients.find(client.key));
+}
+
+size_t enderman::net::RequestScheduler::next_class(std::chrono::steady_clock::time_point now)
+{
+    // The class whose next request waited past the starvation timeout goes first, whatever its priority.
+    if (starvation_timeout > std::chrono::steady_clock::duration::zero())
+    {
+        size_t starved = PRIORITY_CLASSES;
+        std::chrono::steady_clock::time_point oldest = now - starvation_timeout;
+        for (size_t i = 0; i < PRIORITY_CLASSES; ++i)
+        {
+            if (rounds[i].empty())
+                continue;
+            std::chrono::steady_clock::time_point queued_at = rounds[i].front()->lanes[i].queue.front().queued_at;
+            if (queued_at <= oldest)
+            {
+                oldest = queued_at;
+                starved = i;
+            }
+        }
+        if (starved != PRIORITY_CLASSES)
+            return starved;
+    }
+
+    if (policy == SchedulingPolicy::STRICT)
+    {
+        for (size_t i = 0; i < PRIORITY_CLASSES; ++i)
+        {
+            if (!rounds[i].empty())
+                return i;
+        }
+    }
+    // Weighted: each round grants every class its weight in dispatches, the most urgent classes spend theirs first.
+    // A class without queued requests forfeits the rest of its round.
+    while (true)
+    {
+        for (size_t i = 0; i < PRIORITY_CLASSES; ++i)
+        {
+            if (!rounds[i].empty() && credits[i] > 0)
+            {
+                --credits[i];
+                return i;
+            }
+        }
+        credits = weights;
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef ENDERMAN_NET_SCHEDULER_HPP
+#define ENDERMAN_NET_SCHEDULER_HPP
+
+#include "enderman/route_options.hpp"
+#include "enderman/server_options.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace enderman
+{
+    namespace net
+    {
+        /// @brief Queue of a server loop between parsing a request and running its handler. Complete requests wait here by priority class,
+        /// and the loop dispatches them in the order of ServerOptions::scheduling, so a burst of low priority requests delays the urgent ones
+        /// by at most one dispatch slice instead of the whole burst.
+        /// Within a class, clients take turns deficit round robin: each turn grants a client a quantum of loop time, and the loop time its
+        /// requests took is charged back, so a client with many connections or expensive requests gets the same share as any other.
+        /// A client at ServerOptions::max_client_concurrency is left out until one of its requests finishes.
+        class RequestScheduler
+        {
+        public:
+            struct Client;
+
+            /// @brief Connection whose current request waits for dispatch.
+            struct Entry
+            {
+                int fd;
+                /// @brief Connection::id() of the connection, so an entry of a connection closed meanwhile is recognised.
+                uint64_t connection_id;
+                Priority priority;
+                std::chrono::steady_clock::time_point queued_at;
+                /// @brief Client the request is charged to, set by push(). Valid until done() is called for the entry.
+                Client *client = nullptr;
+            };
+
+            /// @brief Requests of one client in one priority class.
+            struct Lane
+            {
+                std::deque<Entry> queue;
+                /// @brief Loop time the client may still use in its current turn; negative after a request took longer than the rest of its quantum.
+                std::chrono::nanoseconds deficit{0};
+                /// @brief True while the client is in the round robin of the class.
+                bool active = false;
+            };
+
+            struct Client
+            {
+                std::string key;
+                std::array<Lane, PRIORITY_CLASSES> lanes;
+                size_t queued = 0;
+                /// @brief Requests of the client dispatched to an offloaded or asynchronous handler that has not finished.
+                size_t in_flight = 0;
+            };
+
+        private:
+            SchedulingPolicy policy;
+            std::array<unsigned, PRIORITY_CLASSES> weights;
+            std::chrono::steady_clock::duration starvation_timeout;
+            size_t max_client_concurrency;
+            /// @brief Clients with queued requests or requests in flight. Their addresses are stable while they are in the map.
+            std::unordered_map<std::string, Client> clients;
+            /// @brief Round robin of the clients with requests queued in each class.
+            std::array<std::deque<Client *>, PRIORITY_CLASSES> rounds;
+            /// @brief Dispatches left to each class in the current weighted round.
+            std::array<unsigned, PRIORITY_CLASSES> credits{};
+            size_t count = 0;
+
+            bool at_limit(const Client &client) const { return max_client_concurrency > 0 && client.in_flight >= max_client_concurrency; }
+            /// @brief Drop the clients at their concurrency limit from the front of a round, so its front client can be dispatched.
+            /// They rejoin once a request of theirs finishes.
+            void prune(size_t priority);
+            /// @brief Class the next request is taken from. At least one class must be ready.
+            size_t next_class(std::chrono::steady_clock::time_point now);
+            void activate(Client &client, size_t priority);
+            /// @brief Forget a client without queued requests or requests in flight.
+            void release_if_idle(Client &client);
+
+        public:
+            explicit RequestScheduler(const ServerOptions &options);
+
+            /// @param client_key Client the request is charged to, e.g. its IP.
+            void push(Entry entry, std::string_view client_key);
+            /// @brief True if a queued request can be dispatched now.
+            bool ready();
+            /// @brief Take the next request to dispatch. The scheduler must be ready; done() must follow.
+            Entry pop(std::chrono::steady_clock::time_point now);
+            /// @brief Charge a popped request to its client.
+            /// @param cost Loop time the request took.
+            /// @param in_flight True if its handler still runs; finish() must follow once it is done.
+            void done(const Entry &entry, std::chrono::nanoseconds cost, bool in_flight);
+            /// @brief A request reported in flight by done() finished.
+            void finish(Client &client);
+            bool empty() const { return count == 0; }
+            size_t size() const { return count; }
+        };
+    }
+}
+
+#endif // ENDERMAN_NET_SCHEDULER_HPP
@@ -0,0 +1,35 @@
+#include "server.hpp"
+#include "reactor.hpp"
+
+#include <thread>
+
+enderman::net::Server::Server(ServerContext server_context, unsigned short port, const ServerOptions &server_options)
+    : context(std::move(server_context)), options(server_options)
+{
+    if (context.offload)
+    {
+        executor = std::make_unique<Executor>(options.offload_threads);
+        context.executor = executor.get();
+    }
+    stream_executor = std::make_unique<Executor>(options.stream_threads);
+    context.streams = stream_executor.get();
+    size_t workers = options.workers > 0 ? options.workers : 1;
+    size_t connections_per_loop = options.max_connections > 0 ? (options.max_connections + workers - 1) / workers : 0;
+    // Every socket is bound before any loop runs, so a failure leaves nothing running.
+    for (size_t i = 0; i < workers; ++i)
+        reactors.push_back(std::make_unique<Reactor>(context, options, port, connections_per_loop));
+}
+
+enderman::net::Server::~Server() = default;
+
+void enderman::net::Server::run()
+{
+    std::vector<std::thread> threads;
+    threads.reserve(reactors.size() - 1);
+    for (size_t i = 1; i < reactors.size(); ++i)
+        threads.emplace_back([reactor = reactors[i].get()]
+                             { reactor->run(); });
+    reactors[0]->run();
+    for (auto &thread : threads)
+        thread.join();
+}
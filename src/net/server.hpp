@@ -0,0 +1,85 @@
+#ifndef ENDERMAN_NET_SERVER_HPP
+#define ENDERMAN_NET_SERVER_HPP
+
+#include "enderman/constants.hpp"
+#include "enderman/route_options.hpp"
+#include "enderman/server_options.hpp"
+
+#include "../http/http_adapter.hpp"
+#include "../constant_routes.hpp"
+#include "../executor.hpp"
+#include "../loop_monitor.hpp"
+#include "../route_handler.hpp"
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace enderman
+{
+    namespace net
+    {
+        class Reactor;
+
+        /// @brief What the server loops need from the application. Shared by all loops and read only while they run.
+        struct ServerContext
+        {
+            /// @brief Runs a request through the application.
+            EndermanCallbackFunction handler;
+            /// @brief Runs a request to an asynchronous route through the application. done is called once the response is ready, from any thread.
+            std::function<void(Request &req, Response &res, std::function<void()> done)> start;
+            /// @brief Runs a request to an offloaded route through the application, on an executor worker. done is called once the response is ready,
+            /// from any worker: a request waiting for a bulkhead slot is run again on the executor once it gets one.
+            std::function<void(Request &req, Response &res, std::function<void()> done)> run_offloaded;
+            /// @brief Route a request goes to, used to limit and spool its body before it is read and to run asynchronous handlers.
+            std::function<RouteMatch(HttpMethod method, std::string_view raw_uri)> match_route;
+            /// @brief Constant responses answered before a request is built, nullptr for none.
+            const ConstantRoutes *constants = nullptr;
+            /// @brief True if some route is offloaded or asynchronous, so the server starts the executor.
+            bool offload = false;
+            /// @brief Executor running offloaded routes and work offloaded by asynchronous handlers, set by the server.
+            Executor *executor = nullptr;
+            /// @brief Pool running the StreamBody producers that could get ahead of their client, set by the server.
+            Executor *streams = nullptr;
+            /// @brief Monitor the loops report their queueing delays to, nullptr for none.
+            LoopMonitor *monitor = nullptr;
+        };
+
+        /// @brief Server made of independent epoll loops, one thread each. Every loop accepts connections on its own
+        /// listening socket bound with SO_REUSEPORT, and handles them from start to end, so the loops share nothing but the application.
+        class Server
+        {
+        private:
+            ServerContext context;
+            ServerOptions options;
+            /// @brief Declared before the loops so it stops after them: closing their connections stops the producers waiting for a client,
+            /// and a producer of a closed connection no longer touches its loop.
+            std::unique_ptr<Executor> stream_executor;
+            std::vector<std::unique_ptr<Reactor>> reactors;
+            /// @brief Declared after the loops so it stops first: its tasks hand their results to the loops.
+            std::unique_ptr<Executor> executor;
+
+        public:
+            /// @brief Open the listening sockets of all loops, one per worker of the options.
+            /// @param server_options Validated settings of the server.
+            /// @throws UnableToListenException if a socket cannot be opened, configured or bound.
+            Server(ServerContext server_context, unsigned short port, const ServerOptions &server_options);
+            ~Server();
+            Server(const Server &) = delete;
+            Server &operator=(const Server &) = delete;
+
+            /// @brief Run the loops on their threads. Blocks while the server runs.
+            void run();
+
+            struct UnableToListenException : public std::runtime_error
+            {
+                explicit UnableToListenException(const std::string &message) : std::runtime_error(message) {}
+            };
+        };
+    }
+}
+
+#endif // ENDERMAN_NET_SERVER_HPP
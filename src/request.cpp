@@ -1,6 +1,10 @@
 #include "enderman/request.hpp"
+#include "enderman/body.hpp"
 #include "request_builder.hpp"
 
+#include <memory>
+#include <utility>
+
 void enderman::RequestBuilder::set_base_path(Request &request, const std::string &base_path)
 {
     request._base_path = base_path;
@@ -26,7 +30,158 @@ void enderman::RequestBuilder::set_path_params(Request &request, const std::unor
     request._path_params = path_params;
 }
 
+void enderman::RequestBuilder::set_route(Request &request, const std::string &route)
+{
+    request._route.assign(route);
+}
+
 void enderman::RequestBuilder::set_query_params(Request &request, const std::unordered_map<std::string, std::string> &query_params)
 {
     request._query_params = query_params;
-}
\ No newline at end of file
+}
+
+void enderman::RequestBuilder::set_cancellation(Request &request, CancellationToken cancellation)
+{
+    request._cancellation = std::move(cancellation);
+    request._cancellation_set = true;
+}
+
+enderman::Request enderman::RequestBuilder::create_empty()
+{
+    return Request();
+}
+
+void enderman::RequestBuilder::reset(Request &request,
+                                     const std::string &ip,
+                                     const std::string &port,
+                                     HttpMethod method,
+                                     std::string_view raw_uri,
+                                     Headers headers)
+{
+    request._ip.assign(ip);
+    request._port.assign(port);
+    request._method = method;
+    request._raw_uri = raw_uri;
+    request._headers = std::move(headers);
+    request._borrowed = true;
+    request._media_type_parsed = false;
+    request._received_at = std::chrono::steady_clock::now();
+    request._cancellation = CancellationToken();
+    request._cancellation_set = false;
+}
+
+void enderman::RequestBuilder::clear(Request &request)
+{
+    request._raw_uri = std::string_view();
+    request._base_path.clear();
+    request._relative_path.clear();
+    request._route.clear();
+    request._base_path_segments.clear();
+    request._relative_path_segments.clear();
+    request._path_params.clear();
+    request._query_params.clear();
+    // Drops the header list together with the memory resource it was allocated from.
+    request._headers = Headers();
+    request._storage.clear();
+    request._borrowed = false;
+    request._media_type_parsed = false;
+    request._cancellation = CancellationToken();
+    request._cancellation_set = false;
+    request.body.reset();
+}
+
+enderman::Request::Request(const Request &other)
+    : _ip(other._ip),
+      _port(other._port),
+      _method(other._method),
+      _raw_uri(other._raw_uri),
+      _base_path(other._base_path),
+      _relative_path(other._relative_path),
+      _route(other._route),
+      _base_path_segments(other._base_path_segments),
+      _relative_path_segments(other._relative_path_segments),
+      _path_params(other._path_params),
+      _query_params(other._query_params),
+      _headers(other._headers),
+      _borrowed(true),
+      _received_at(other._received_at),
+      _cancellation(other._cancellation),
+      _cancellation_set(other._cancellation_set),
+      body(other.body)
+{
+    // The views still point into other's storage or the transport; take a private copy.
+    retain();
+}
+
+enderman::Request &enderman::Request::operator=(const Request &other)
+{
+    if (this != &other)
+    {
+        Request copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+void enderman::Request::retain()
+{
+    if (auto raw = std::dynamic_pointer_cast<RawBody>(body))
+        raw->retain();
+    if (!_borrowed)
+        return;
+
+    size_t total = _raw_uri.size();
+    for (const auto &header : _headers.entries)
+        total += header.first.size() + header.second.size();
+
+    std::vector<char> storage;
+    storage.reserve(total);
+    auto keep = [&storage](std::string_view value)
+    {
+        size_t offset = storage.size();
+        storage.insert(storage.end(), value.begin(), value.end());
+        return offset;
+    };
+
+    size_t uri_offset = keep(_raw_uri);
+    std::vector<std::pair<size_t, size_t>> offsets;
+    offsets.reserve(_headers.entries.size());
+    for (const auto &header : _headers.entries)
+    {
+        size_t name_offset = keep(header.first);
+        offsets.emplace_back(name_offset, keep(header.second));
+    }
+
+    // storage was reserved up front, so its data pointer is final.
+    // The header list may live in the per-request arena, so it is rebuilt on the default resource as well.
+    const char *base = storage.data();
+    _raw_uri = std::string_view(base + uri_offset, _raw_uri.size());
+    Headers owned(std::pmr::get_default_resource());
+    owned.entries.reserve(offsets.size());
+    for (size_t i = 0; i < offsets.size(); ++i)
+    {
+        const auto &header = _headers.entries[i];
+        owned.add(std::string_view(base + offsets[i].first, header.first.size()),
+                  std::string_view(base + offsets[i].second, header.second.size()));
+    }
+    _headers = std::move(owned);
+    _storage = std::move(storage);
+    _borrowed = false;
+    // The cached media type views the old memory.
+    _media_type_parsed = false;
+}
+
+std::unique_ptr<enderman::BodyReader> enderman::Request::body_reader() const
+{
+    if (!body)
+        return std::make_unique<MemoryBodyReader>(std::string_view());
+    return body->reader();
+}
+
+bool enderman::Request::is_borrowed() const
+{
+    if (_borrowed)
+        return true;
+    auto raw = std::dynamic_pointer_cast<RawBody>(body);
+    return raw && raw->is_borrowed();
+}
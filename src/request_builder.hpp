@@ -4,6 +4,7 @@
 #include "enderman/request.hpp"
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 
@@ -13,11 +14,32 @@ namespace enderman
     {
     public:
         static void set_base_path(Request &request, const std::string &base_path);
+        /// @brief Set the path pattern of the route matching the request, empty for none.
+        static void set_route(Request &request, const std::string &route);
         static void set_base_path_segments(Request &request, const std::vector<std::string> &base_path_segments);
         static void set_relative_path(Request &request, const std::string &relative_path);
         static void set_relative_path_segments(Request &request, const std::vector<std::string> &relative_path_segments);
         static void set_path_params(Request &request, const std::unordered_map<std::string, std::string> &path_params);
         static void set_query_params(Request &request, const std::unordered_map<std::string, std::string> &query_params);
+
+        /// @brief Set the deadline and cancellation of a request.
+        static void set_cancellation(Request &request, CancellationToken cancellation);
+        /// @brief Check if the transport or the framework already set the cancellation of a request.
+        static bool has_cancellation(const Request &request) { return request._cancellation_set; }
+
+        /// @brief Create an empty request to be reused across exchanges.
+        static Request create_empty();
+        /// @brief Start a new exchange on a reused request. Strings and containers keep their capacity.
+        /// @param raw_uri Raw URI, borrowed like in the borrowing constructor of Request.
+        /// @param headers Headers, borrowed. The request takes over their memory resource.
+        static void reset(Request &request,
+                          const std::string &ip,
+                          const std::string &port,
+                          HttpMethod method,
+                          std::string_view raw_uri,
+                          Headers headers);
+        /// @brief Drop the state of a finished exchange, including every view into the transport or the per-request arena.
+        static void clear(Request &request);
     };
 }
 
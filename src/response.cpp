@@ -1,9 +1,16 @@
 #include "enderman/response.hpp"
 #include "enderman/body.hpp"
+#include "enderman/headers.hpp"
+#include "enderman/stream_body.hpp"
 
 #include "response_writer.hpp"
+#include "http/response_head.hpp"
 
+#include <cstdio>
 #include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
 
 struct enderman::Response::Impl
 {
@@ -22,23 +29,331 @@ int enderman::ResponseWriter::get_status_code(const enderman::Response &response
     return response.pImpl->status_code;
 }
 
-std::string enderman::ResponseWriter::get_reason_phrase(const enderman::Response &response)
+const std::string &enderman::ResponseWriter::get_reason_phrase(const enderman::Response &response)
 {
     return response.pImpl->message;
 }
 
-std::unordered_map<std::string, std::string> enderman::ResponseWriter::get_headers(const enderman::Response &response)
+const std::unordered_map<std::string, std::string> &enderman::ResponseWriter::get_headers(const enderman::Response &response)
 {
     return response.pImpl->headers;
 }
 
 std::vector<char> enderman::ResponseWriter::get_body(const enderman::Response &response)
 {
-    if (response.pImpl->body)
+    BodyBuffers body;
+    collect_body(response, body);
+    if (body.buffers.empty())
+        return std::move(body.storage);
+    std::vector<char> data;
+    data.reserve(body.size);
+    for (const auto &buffer : body.buffers)
+        data.insert(data.end(), buffer.data, buffer.data + buffer.size);
+    return data;
+}
+
+void enderman::ResponseWriter::collect_body(const enderman::Response &response, BodyBuffers &out)
+{
+    out.clear();
+    const std::shared_ptr<Body> &body = response.pImpl->body;
+    if (!body)
+        return;
+    if (body->buffers(out.buffers))
+    {
+        for (const auto &buffer : out.buffers)
+            out.size += buffer.size;
+        return;
+    }
+    out.buffers.clear();
+    out.storage = body->serialize();
+    out.size = out.storage.size();
+}
+
+std::string_view enderman::ResponseWriter::default_reason_phrase(int status_code)
+{
+    return enderman::http::ResponseHead::reason_phrase(status_code);
+}
+
+void enderman::ResponseWriter::serialize_head(const enderman::Response &response, std::optional<size_t> content_length, bool include_body, bool chunked, std::string &out)
+{
+    const Response::Impl &impl = *response.pImpl;
+    bool framed = status_allows_body(impl.status_code);
+    // Without chunked encoding, a body of unknown length ends where the connection does.
+    bool close_delimited = framed && include_body && !content_length && !chunked;
+    std::string_view status_line = impl.message.empty() ? enderman::http::ResponseHead::status_line(impl.status_code) : std::string_view();
+
+    size_t head_size = 128;
+    bool has_date = false;
+    bool has_server = false;
+    for (const auto &header : impl.headers)
+    {
+        head_size += header.first.size() + 2 + header.second.size() + 2;
+        has_date = has_date || Headers::equals_ignore_case(header.first, "date");
+        has_server = has_server || Headers::equals_ignore_case(header.first, "server");
+    }
+    out.reserve(out.size() + head_size + impl.message.size());
+
+    if (!status_line.empty())
+        out += status_line;
+    else
+    {
+        // Custom reason phrase or a code without a pre-rendered status line.
+        std::string_view reason = impl.message.empty() ? default_reason_phrase(impl.status_code) : std::string_view(impl.message);
+        out += "HTTP/1.1 ";
+        out += std::to_string(impl.status_code);
+        out += ' ';
+        out += reason;
+        out += "\r\n";
+    }
+    if (!has_date)
+        out += enderman::http::ResponseHead::date_header();
+    if (!has_server)
+        out += enderman::http::ResponseHead::SERVER_HEADER;
+    bool has_content_length = false;
+    for (const auto &header : impl.headers)
+    {
+        // The framework frames the body itself.
+        if (Headers::equals_ignore_case(header.first, "transfer-encoding"))
+            continue;
+        if (Headers::equals_ignore_case(header.first, "content-length"))
+        {
+            // A handler may describe the body of a HEAD response itself; otherwise the actual size wins.
+            if (include_body || !framed)
+                continue;
+            has_content_length = true;
+        }
+        else if (close_delimited && Headers::equals_ignore_case(header.first, "connection"))
+            continue;
+        else if (header.first == "Content-Type")
+        {
+            std::string_view content_type = enderman::http::ResponseHead::content_type_header(header.second);
+            if (!content_type.empty())
+            {
+                out += content_type;
+                continue;
+            }
+        }
+        out += header.first;
+        out += ": ";
+        out += header.second;
+        out += "\r\n";
+    }
+    if (close_delimited)
+        out += "Connection: close\r\n";
+    else if (framed && !content_length && chunked)
+        out += "Transfer-Encoding: chunked\r\n";
+    else if (framed && content_length && !has_content_length)
+        enderman::http::ResponseHead::append_content_length(*content_length, out);
+    out += "\r\n";
+}
+
+namespace
+{
+    /// @brief Writer handed to StreamBody producers. Collects small writes into chunks of STREAM_CHUNK_SIZE and sends the head with the first chunk.
+    class StreamingWriter : public enderman::BodyWriter
+    {
+    private:
+        enderman::ResponseWriter::ResponseSink &sink;
+        const std::string &head;
+        bool head_sent = false;
+        /// @brief Remaining bytes of a body with a known length, std::nullopt for chunked or close-delimited bodies.
+        std::optional<size_t> remaining;
+        /// @brief A body of unknown length is sent in chunks; otherwise as it is, ended by closing the connection.
+        bool chunked;
+        std::vector<char> buffer;
+        bool failed = false;
+
+        bool send(const char *data, size_t size)
+        {
+            enderman::ConstBuffer parts[4];
+            size_t count = 0;
+            if (!head_sent)
+                parts[count++] = enderman::ConstBuffer{head.data(), head.size()};
+            char size_line[20];
+            if (size > 0)
+            {
+                if (!remaining && chunked)
+                {
+                    int length = std::snprintf(size_line, sizeof(size_line), "%zx\r\n", size);
+                    parts[count++] = enderman::ConstBuffer{size_line, static_cast<size_t>(length)};
+                }
+                parts[count++] = enderman::ConstBuffer{data, size};
+                if (!remaining && chunked)
+                    parts[count++] = enderman::ConstBuffer{"\r\n", 2};
+            }
+            if (count == 0)
+                return true;
+            head_sent = true;
+            if (!sink.write(parts, count))
+                failed = true;
+            return !failed;
+        }
+
+        bool send_buffer()
+        {
+            if (buffer.empty())
+                return !failed;
+            bool sent = send(buffer.data(), buffer.size());
+            buffer.clear();
+            return sent;
+        }
+
+    public:
+        StreamingWriter(enderman::ResponseWriter::ResponseSink &response_sink, const std::string &response_head, std::optional<size_t> content_length, bool chunked_body)
+            : sink(response_sink), head(response_head), remaining(content_length), chunked(chunked_body) {}
+
+        bool write(const char *data, size_t size) override
+        {
+            if (failed)
+                return false;
+            if (remaining)
+            {
+                if (size > *remaining)
+                {
+                    // Writing past the announced length would corrupt the next response on the connection.
+                    size = *remaining;
+                    failed = true;
+                }
+                *remaining -= size;
+            }
+            if (buffer.size() + size <= enderman::ResponseWriter::STREAM_CHUNK_SIZE)
+            {
+                buffer.insert(buffer.end(), data, data + size);
+                if (buffer.size() == enderman::ResponseWriter::STREAM_CHUNK_SIZE && !send_buffer())
+                    return false;
+                return !failed;
+            }
+            if (!send_buffer())
+                return false;
+            bool sent = send(data, size);
+            return sent && !failed;
+        }
+
+        bool flush() override
+        {
+            if (failed)
+                return false;
+            if (!send_buffer())
+                return false;
+            return send(nullptr, 0);
+        }
+
+        /// @brief Send what is left and terminate the body.
+        /// @return False if the body could not be sent completely.
+        bool finish()
+        {
+            if (failed || !send_buffer())
+                return false;
+            if (remaining)
+                return *remaining == 0 && send(nullptr, 0);
+            if (!chunked)
+                return send(nullptr, 0);
+            enderman::ConstBuffer parts[2];
+            size_t count = 0;
+            if (!head_sent)
+                parts[count++] = enderman::ConstBuffer{head.data(), head.size()};
+            parts[count++] = enderman::ConstBuffer{"0\r\n\r\n", 5};
+            head_sent = true;
+            return sink.write(parts, count);
+        }
+
+        bool is_head_sent() const { return head_sent; }
+    };
+
+    /// @brief Sink appending everything to a string.
+    class StringSink : public enderman::ResponseWriter::ResponseSink
+    {
+    private:
+        std::string &out;
+
+    public:
+        explicit StringSink(std::string &output) : out(output) {}
+        bool write(const enderman::ConstBuffer *buffers, size_t count) override
+        {
+            for (size_t i = 0; i < count; ++i)
+                out.append(buffers[i].data, buffers[i].size);
+            return true;
+        }
+    };
+}
+
+bool enderman::ResponseWriter::write_stream(const StreamBody &body, const std::string &head, std::optional<size_t> content_length, bool chunked, ResponseSink &sink)
+{
+    StreamingWriter writer(sink, head, content_length, chunked);
+    try
+    {
+        body.stream(writer);
+    }
+    catch (...)
     {
-        return response.pImpl->body->serialize();
+        // Nothing was sent yet, so the caller can still answer with an error.
+        if (!writer.is_head_sent())
+            throw;
+        return false;
     }
-    return std::vector<char>();
+    return writer.finish();
+}
+
+bool enderman::ResponseWriter::write_response(const enderman::Response &response, ResponseSink &sink, bool include_body, bool chunked)
+{
+    std::string head;
+    // A body the status does not allow would be read as the start of the next response.
+    include_body = include_body && status_allows_body(response.pImpl->status_code);
+    auto stream_body = std::dynamic_pointer_cast<const StreamBody>(response.pImpl->body);
+    if (stream_body)
+    {
+        std::optional<size_t> content_length = stream_body->content_length();
+        serialize_head(response, content_length, include_body, chunked, head);
+        if (!include_body)
+            return StreamingWriter(sink, head, content_length, chunked).flush();
+        bool complete = sink.defer_stream(stream_body, head, content_length, chunked) ||
+                        write_stream(*stream_body, head, content_length, chunked, sink);
+        // A close-delimited body only ends with the connection.
+        return complete && (content_length || chunked);
+    }
+
+    BodyBuffers body;
+    collect_body(response, body);
+    serialize_head(response, body.size, include_body, chunked, head);
+    std::vector<ConstBuffer> parts;
+    parts.reserve(1 + body.buffers.size() + 1);
+    parts.push_back(ConstBuffer{head.data(), head.size()});
+    if (!include_body)
+        return sink.write(parts.data(), parts.size());
+    // The body buffers stay valid while the body is alive, so a slow client can be served from them instead of a copy;
+    // except for a borrowed request body, which views the input of the transport.
+    std::shared_ptr<const void> owner = response.pImpl->body;
+    if (body.buffers.empty() && !body.storage.empty())
+    {
+        auto storage = std::make_shared<std::vector<char>>(std::move(body.storage));
+        parts.push_back(ConstBuffer{storage->data(), storage->size()});
+        owner = std::move(storage);
+    }
+    else
+    {
+        auto raw_body = std::dynamic_pointer_cast<const RawBody>(response.pImpl->body);
+        if (raw_body && raw_body->is_borrowed())
+            owner.reset();
+    }
+    parts.insert(parts.end(), body.buffers.begin(), body.buffers.end());
+    if (!owner)
+        return sink.write(parts.data(), parts.size());
+    return sink.write(parts.data(), parts.size(), 1, owner);
+}
+
+bool enderman::ResponseWriter::serialize(const enderman::Response &response, std::string &out, bool include_body)
+{
+    StringSink sink(out);
+    return write_response(response, sink, include_body);
+}
+
+void enderman::ResponseWriter::reset(enderman::Response &response)
+{
+    response.pImpl->status_code = 200;
+    response.pImpl->message.clear();
+    response.pImpl->headers.clear();
+    response.pImpl->body.reset();
+    response.pImpl->is_final = false;
 }
 
 enderman::Response::Response() : pImpl(new Impl()) {}
@@ -2,20 +2,104 @@
 #define ENDERMAN_RESPONSE_WRITER_HPP
 
 #include "enderman/types.hpp"
+#include "enderman/body.hpp"
 
+#include <cstddef>
+#include <memory>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include <string_view>
 
 namespace enderman
 {
+    class StreamBody;
+
     class ResponseWriter
     {
     public:
+        /// @brief Body of a response ready to be written: buffers viewing the body, or a serialized copy for bodies that expose no buffers.
+        /// The buffers are valid as long as the response keeps its body.
+        struct BodyBuffers
+        {
+            std::vector<ConstBuffer> buffers;
+            /// @brief Serialized body when Body::buffers() is not implemented.
+            std::vector<char> storage;
+            size_t size = 0;
+
+            void clear()
+            {
+                buffers.clear();
+                storage.clear();
+                size = 0;
+            }
+        };
+
         static int get_status_code(const Response &response);
-        static std::string get_reason_phrase(const Response &response);
-        static std::unordered_map<std::string, std::string> get_headers(const Response &response);
+        static const std::string &get_reason_phrase(const Response &response);
+        static const std::unordered_map<std::string, std::string> &get_headers(const Response &response);
         static std::vector<char> get_body(const Response &response);
+        /// @brief Collect the body of a response as buffers, serializing it only if the body does not expose its buffers.
+        /// @param out Buffers appended to, cleared first.
+        static void collect_body(const Response &response, BodyBuffers &out);
+        /// @brief Get the standard reason phrase of a status code, used when a response has no message.
+        /// @return Reason phrase, e.g. "Not Found", or an empty view for unknown codes.
+        static std::string_view default_reason_phrase(int status_code);
+        /// @brief Check if a response with a status code may have a body and framing headers. 1xx, 204 and 304 responses have neither (RFC 9110 §8.6, RFC 9112 §6.3).
+        static bool status_allows_body(int status_code) { return status_code >= 200 && status_code != 204 && status_code != 304; }
+        /// @brief Destination of a serialized response, e.g. a socket or a buffer.
+        class ResponseSink
+        {
+        public:
+            virtual ~ResponseSink() = default;
+            /// @brief Write buffers in order. Returns once they are accepted; the buffers are only valid during the call.
+            /// @return False if the destination is gone.
+            virtual bool write(const ConstBuffer *buffers, size_t count) = 0;
+            /// @brief Write buffers like write(), where the buffers from index first_owned on stay valid as long as owner is alive.
+            /// A destination that cannot take them right away may keep them and owner instead of copying them. The default copies like write().
+            virtual bool write(const ConstBuffer *buffers, size_t count, size_t /*first_owned*/, const std::shared_ptr<const void> &/*owner*/) { return write(buffers, count); }
+            /// @brief Take over a streamed body to run its producer elsewhere, for destinations where waiting for the client would hold up other work.
+            /// The destination then runs write_stream() itself, see there.
+            /// @param head Serialized head, to send with the first chunk.
+            /// @return False to have the producer run now, on the calling thread.
+            virtual bool defer_stream(const std::shared_ptr<const StreamBody> &/*body*/, const std::string &/*head*/, std::optional<size_t> /*content_length*/, bool /*chunked*/) { return false; }
+        };
+
+        /// @brief Size of the chunks a streamed body is sent in. Smaller writes of the producer are collected up to this size.
+        static constexpr size_t STREAM_CHUNK_SIZE = 16 * 1024;
+
+        /// @brief Serialize the status line and the headers of a response, ending with the empty line.
+        /// Responses whose status allows no body get no Content-Length or Transfer-Encoding.
+        /// @param content_length Size of the body, written as Content-Length, or std::nullopt for Transfer-Encoding: chunked.
+        /// @param include_body False for responses to HEAD requests, the only ones where a Content-Length set by the handler is kept.
+        /// @param chunked False for clients that cannot read chunked bodies. A body of unknown length then gets Connection: close instead.
+        /// @param out Buffer the head is appended to.
+        static void serialize_head(const Response &response, std::optional<size_t> content_length, bool include_body, bool chunked, std::string &out);
+        /// @brief Write a response to a sink. Buffered bodies go out with the head in one gather write;
+        /// StreamBody producers run now, unless the sink defers them, and their output is sent in chunks as it is produced.
+        /// @param include_body False for responses to HEAD requests. Bodies of responses whose status allows none are never written.
+        /// @param chunked False for HTTP/1.0 clients, which cannot read chunked bodies (RFC 9112 §6.1).
+        /// A streamed body of unknown length is then sent as it is produced and ended by closing the connection, announced with Connection: close.
+        /// @return False if the connection must be closed: the sink failed or a streamed body ended early, so the response is incomplete,
+        /// or the body is ended by closing the connection.
+        /// @throws Whatever a StreamBody producer throws before anything was written.
+        static bool write_response(const Response &response, ResponseSink &sink, bool include_body = true, bool chunked = true);
+        /// @brief Run the producer of a streamed body into a sink, sending the head with the first chunk.
+        /// @param head Serialized head of the response, see serialize_head().
+        /// @param content_length Length announced in the head, std::nullopt for chunked or close-delimited bodies.
+        /// @param chunked The body has no announced length and is sent in chunks.
+        /// @return False if the sink failed or the body did not match its announced length, so the response is incomplete.
+        /// @throws Whatever the producer throws before anything was written.
+        static bool write_stream(const StreamBody &body, const std::string &head, std::optional<size_t> content_length, bool chunked, ResponseSink &sink);
+        /// @brief Serialize the status line, the headers and the body of a response as one HTTP/1.1 message.
+        /// The framework frames the body itself, with Content-Length or chunked for streamed bodies of unknown length, so that the message is framed correctly on keep-alive connections.
+        /// @param out Buffer the message is appended to. Reuse it across responses to keep its capacity.
+        /// @param include_body False for responses to HEAD requests; Content-Length still describes the body.
+        /// @return False if a streamed body ended early; the message in out is then truncated.
+        static bool serialize(const Response &response, std::string &out, bool include_body = true);
+        /// @brief Return a response to its initial state so it can be reused for the next exchange. Strings and the header table keep their capacity.
+        static void reset(Response &response);
     };
 }
 
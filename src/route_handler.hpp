@@ -2,7 +2,12 @@
 #define ENDERMAN_ROUTE_HANDLER_HPP
 
 #include "enderman/types.hpp"
+#include "enderman/route_options.hpp"
 
+#include "bulkhead.hpp"
+#include "utils.hpp"
+
+#include <memory>
 #include <string>
 #include <vector>
 #include <functional>
@@ -13,9 +18,27 @@ namespace enderman
     struct RouteHandler
     {
         std::vector<std::string> path;
+        /// @brief Path as a string, e.g. /users/:id, reported by Request::route().
+        std::string pattern;
         RouteHandlerFunction handler;
-        explicit RouteHandler(const std::vector<std::string> _path, RouteHandlerFunction f)
-            : path(std::move(_path)), handler(std::move(f)) {}
+        /// @brief Set instead of handler for routes registered with Enderman::on_async() or a coroutine.
+        AsyncRouteHandlerFunction async_handler;
+        RouteOptions options;
+        /// @brief Limit on the requests of the route running at once, nullptr for none. Set from the options merged with the defaults.
+        std::shared_ptr<Bulkhead> bulkhead;
+        explicit RouteHandler(const std::vector<std::string> _path, RouteHandlerFunction f, const RouteOptions &route_options = RouteOptions())
+            : path(std::move(_path)), pattern(utils::PathTools::build_path(path)), handler(std::move(f)), options(route_options) {}
+        RouteHandler(const std::vector<std::string> _path, AsyncRouteHandlerFunction f, const RouteOptions &route_options)
+            : path(std::move(_path)), pattern(utils::PathTools::build_path(path)), async_handler(std::move(f)), options(route_options) {}
+    };
+
+    /// @brief What a transport learns about the route of a request before reading its body.
+    struct RouteMatch
+    {
+        /// @brief Options of the route merged with the defaults.
+        RouteOptions options;
+        /// @brief The route handler may finish after it returns.
+        bool asynchronous = false;
     };
 }
 
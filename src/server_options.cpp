@@ -0,0 +1,88 @@
+#include "enderman/server_options.hpp"
+
+#include <climits>
+#include <stdexcept>
+#include <string>
+
+#include <sys/socket.h>
+
+namespace
+{
+    constexpr size_t MAX_WORKERS = 1024;
+    constexpr size_t HTTP_SERVER_DEFAULT_LIMIT = 128;
+
+    void require(bool condition, const std::string &message)
+    {
+        if (!condition)
+            throw std::invalid_argument("Invalid server options: " + message);
+    }
+
+    std::string seconds(std::chrono::seconds value)
+    {
+        return std::to_string(value.count()) + "s";
+    }
+}
+
+void enderman::ServerOptions::validate() const
+{
+    require(workers <= MAX_WORKERS, "workers must be at most " + std::to_string(MAX_WORKERS));
+    require(backlog <= INT_MAX, "backlog must fit in an int");
+    require(max_connections <= INT_MAX, "max_connections must fit in an int");
+    require(max_connections == 0 || max_connections >= workers, "max_connections must allow at least one connection per worker");
+    require(idle_timeout.count() > 0 && idle_timeout.count() <= INT_MAX / 1000, "idle_timeout must be positive");
+    require(keep_alive_timeout.count() > 0, "keep_alive_timeout must be positive");
+    require(receive_buffer_size <= INT_MAX, "receive_buffer_size must fit in an int");
+    require(send_buffer_size <= INT_MAX, "send_buffer_size must fit in an int");
+    require(defer_accept.count() >= 0 && defer_accept.count() <= INT_MAX, "defer_accept must not be negative");
+    require(fastopen_queue <= INT_MAX, "fastopen_queue must fit in an int");
+    require(offload_threads <= MAX_WORKERS, "offload_threads must be at most " + std::to_string(MAX_WORKERS));
+    require(stream_threads <= MAX_WORKERS, "stream_threads must be at most " + std::to_string(MAX_WORKERS));
+    for (unsigned weight : priority_weights)
+        require(weight > 0, "priority_weights must be positive");
+    require(starvation_timeout.count() >= 0, "starvation_timeout must not be negative");
+    require(shed_target.count() >= 0, "shed_target must not be negative");
+    require(shed_target.count() == 0 || shed_interval.count() > 0, "shed_interval must be positive");
+    require(shed_retry_after.count() >= 0, "shed_retry_after must not be negative");
+    require(client_key_header.find_first_of(" \t\r\n:") == std::string::npos, "client_key_header must be a header name");
+    require(request_timeout.count() >= 0, "request_timeout must not be negative");
+    require(timeout_header.find_first_of(" \t\r\n:") == std::string::npos, "timeout_header must be a header name");
+}
+
+std::string enderman::ServerOptions::describe(unsigned short port) const
+{
+    bool loops = workers > 0;
+    const char *ignored = loops ? "" : " (ignored by Http-Server)";
+    std::string text = "Enderman listening on port " + std::to_string(port) + "\n";
+    text += loops ? "  transport: " + std::to_string(workers) + " server loop(s) with SO_REUSEPORT\n" : "  transport: Http-Server\n";
+    size_t effective_backlog = backlog > 0 ? backlog : loops ? static_cast<size_t>(SOMAXCONN) : HTTP_SERVER_DEFAULT_LIMIT;
+    text += "  backlog: " + std::to_string(effective_backlog) + "\n";
+    if (max_connections > 0)
+        text += "  max_connections: " + std::to_string(max_connections) + (loops ? " (" + std::to_string((max_connections + workers - 1) / workers) + " per loop)" : std::string()) + "\n";
+    else
+        text += loops ? "  max_connections: unlimited\n" : "  max_connections: " + std::to_string(HTTP_SERVER_DEFAULT_LIMIT) + "\n";
+    text += "  idle_timeout: " + seconds(idle_timeout) + "\n";
+    text += "  keep_alive_timeout: " + seconds(loops ? keep_alive_timeout : idle_timeout) + ignored + "\n";
+    text += "  max_requests_per_connection: " + (max_requests_per_connection > 0 ? std::to_string(max_requests_per_connection) : std::string("unlimited")) + ignored + "\n";
+    text += std::string("  tcp_nodelay: ") + (tcp_nodelay ? "on" : "off") + ignored + "\n";
+    text += "  receive_buffer_size: " + (receive_buffer_size > 0 ? std::to_string(receive_buffer_size) : std::string("system default")) + ignored + "\n";
+    text += "  send_buffer_size: " + (send_buffer_size > 0 ? std::to_string(send_buffer_size) : std::string("system default")) + ignored + "\n";
+    text += "  defer_accept: " + (defer_accept.count() > 0 ? seconds(defer_accept) : std::string("off")) + ignored + "\n";
+    text += "  fastopen_queue: " + (fastopen_queue > 0 ? std::to_string(fastopen_queue) : std::string("off")) + ignored + "\n";
+    text += "  offload_threads: " + (offload_threads > 0 ? std::to_string(offload_threads) : std::string("one per hardware thread")) + ignored + "\n";
+    text += "  stream_threads: " + (stream_threads > 0 ? std::to_string(stream_threads) : std::string("one per hardware thread")) + ignored + "\n";
+    if (scheduling == SchedulingPolicy::STRICT)
+        text += "  scheduling: strict priority";
+    else
+        text += "  scheduling: weighted " + std::to_string(priority_weights[0]) + ":" + std::to_string(priority_weights[1]) + ":" + std::to_string(priority_weights[2]);
+    text += (starvation_timeout.count() > 0 ? ", starvation_timeout " + std::to_string(starvation_timeout.count()) + "ms" : std::string()) + ignored + "\n";
+    text += "  fairness: per " + (client_key_header.empty() ? std::string("client IP") : client_key_header + " header") +
+            (max_client_concurrency > 0 ? ", at most " + std::to_string(max_client_concurrency) + " concurrent per client" : std::string()) + ignored + "\n";
+    if (shed_target.count() > 0)
+        text += "  load shedding: queueing delay above " + std::to_string(shed_target.count()) + "ms for " + std::to_string(shed_interval.count()) +
+                "ms, Retry-After " + std::to_string(shed_retry_after.count()) + ignored + "\n";
+    else
+        text += std::string("  load shedding: off") + ignored + "\n";
+    text += "  request_timeout: " + (request_timeout.count() > 0 ? std::to_string(request_timeout.count()) + "ms" : std::string("none")) +
+            (timeout_header.empty() ? std::string() : ", shortened by " + timeout_header) + "\n";
+    return text;
+}
@@ -0,0 +1,135 @@
+#include "enderman/spooled_body.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+
+    class FileBodyReader : public enderman::BodyReader
+    {
+    private:
+        std::ifstream file;
+        std::vector<char> buffer;
+
+    public:
+        explicit FileBodyReader(const std::filesystem::path &path)
+            : file(path, std::ios::binary), buffer(READ_CHUNK_SIZE)
+        {
+            if (!file)
+                throw enderman::SpoolException("Unable to open spooled body " + path.string());
+        }
+
+        std::string_view next() override
+        {
+            file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            return std::string_view(buffer.data(), static_cast<size_t>(file.gcount()));
+        }
+    };
+}
+
+enderman::SpooledBody::SpooledBody(std::filesystem::path path, size_t size)
+    : file_path(std::move(path)), file_size(size) {}
+
+enderman::SpooledBody::~SpooledBody()
+{
+    std::error_code ignored;
+    std::filesystem::remove(file_path, ignored);
+}
+
+std::vector<char> enderman::SpooledBody::serialize() const
+{
+    std::ifstream file(file_path, std::ios::binary);
+    std::vector<char> data(file_size);
+    if (!file || !file.read(data.data(), static_cast<std::streamsize>(data.size())))
+        throw SpoolException("Unable to read spooled body " + file_path.string());
+    return data;
+}
+
+std::unique_ptr<enderman::BodyReader> enderman::SpooledBody::reader() const
+{
+    return std::make_unique<FileBodyReader>(file_path);
+}
+
+enderman::BodySpool::BodySpool(size_t spool_threshold, std::filesystem::path spool_directory)
+    : threshold(spool_threshold), directory(std::move(spool_directory)) {}
+
+enderman::BodySpool::~BodySpool()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+        std::error_code ignored;
+        std::filesystem::remove(file_path, ignored);
+    }
+}
+
+void enderman::BodySpool::spool_to_file()
+{
+    std::string name = (directory / "enderman-body-XXXXXX").string();
+    fd = ::mkstemp(name.data());
+    if (fd < 0)
+        throw SpoolException("Unable to create spool file in " + directory.string() + ": " + std::strerror(errno));
+    file_path = name;
+    write_to_file(memory.data(), memory.size());
+    memory.clear();
+    memory.shrink_to_fit();
+}
+
+void enderman::BodySpool::write_to_file(const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw SpoolException("Unable to write spool file " + file_path.string() + ": " + std::strerror(errno));
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+void enderman::BodySpool::append(const char *data, size_t size)
+{
+    total += size;
+    if (fd < 0)
+    {
+        memory.insert(memory.end(), data, data + size);
+        if (threshold > 0 && memory.size() > threshold)
+            spool_to_file();
+        return;
+    }
+    write_to_file(data, size);
+}
+
+std::shared_ptr<enderman::Body> enderman::BodySpool::finish()
+{
+    std::shared_ptr<Body> body;
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+        body = std::make_shared<SpooledBody>(std::move(file_path), total);
+    }
+    else
+    {
+        auto raw = std::make_shared<RawBody>();
+        raw->parse_from(std::move(memory));
+        body = raw;
+    }
+    memory = std::vector<char>();
+    file_path.clear();
+    total = 0;
+    return body;
+}
@@ -3,11 +3,11 @@
 #include <sstream>
 #include <cctype>
 
-enderman::utils::UriParser::ParsedURI enderman::utils::UriParser::parse_uri(const std::string &uri)
+enderman::utils::UriParser::ParsedURI enderman::utils::UriParser::parse_uri(std::string_view uri)
 {
     try
     {
-        std::string uri_no_fragment = strip_uri_fragment(uri);
+        std::string uri_no_fragment(uri.substr(0, uri.find('#')));
         std::string path = path_from_uri(uri_no_fragment);
         std::string query = query_from_uri(uri_no_fragment);
 
@@ -89,14 +89,6 @@ std::string enderman::utils::UriParser::decode_url_encoding(const std::string &e
     }
 }
 
-std::string enderman::utils::UriParser::strip_uri_fragment(const std::string &uri)
-{
-    auto pos = uri.find('#');
-    if (pos == std::string::npos)
-        return uri;
-    return uri.substr(0, pos);
-}
-
 std::string enderman::utils::UriParser::path_from_uri(const std::string &uri)
 {
     auto pos = uri.find('?');
@@ -2,6 +2,7 @@
 #define ENDERMAN_UTILS_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <stdexcept>
@@ -14,7 +15,6 @@ namespace enderman
         {
         private:
             static std::string decode_url_encoding(const std::string &encoded);
-            static std::string strip_uri_fragment(const std::string &uri);
             static std::string path_from_uri(const std::string &uri);
             static std::string query_from_uri(const std::string &uri);
             static std::vector<std::string> split_path(const std::string &path);
@@ -51,7 +51,7 @@ namespace enderman
             /// @param uri URI string to parse
             /// @return ParsedURI struct containing path segments and query parameters. All URL decoded.
             /// @throws InvalidURIException if the URI is malformed or contains invalid characters.
-            static ParsedURI parse_uri(const std::string &uri);
+            static ParsedURI parse_uri(std::string_view uri);
             /// @brief Parse a path string into segments. This function is meant to be used on URL decoded paths.
             /// @param path Path string to parse
             /// @return Vector of path segments
@@ -0,0 +1,65 @@
+#include "enderman/loopback.hpp"
+
+#include <iostream>
+#include <string>
+
+using enderman::Loopback;
+
+namespace
+{
+    int failures = 0;
+
+    /// @brief Parse a raw request that must be rejected with MalformedRequestException, and nothing else.
+    void expect_malformed(const std::string &name, const std::string &raw)
+    {
+        try
+        {
+            Loopback::parse_request(raw);
+            std::cerr << name << ": parsed, expected MalformedRequestException" << std::endl;
+        }
+        catch (const Loopback::MalformedRequestException &)
+        {
+            return;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << name << ": expected MalformedRequestException, got " << e.what() << std::endl;
+        }
+        ++failures;
+    }
+
+    void check(const std::string &name, bool condition)
+    {
+        if (condition)
+            return;
+        std::cerr << name << ": check failed" << std::endl;
+        ++failures;
+    }
+}
+
+int main()
+{
+    const std::string head = "POST /upload HTTP/1.1\r\nHost: example.com\r\n";
+
+    auto request = Loopback::parse_request(head + "Content-Length: 5\r\n\r\nhello");
+    check("content length body", std::string(request.body.begin(), request.body.end()) == "hello");
+    request = Loopback::parse_request(head + "Transfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n1;ext=1\r\n!\r\n0\r\n\r\n");
+    check("chunked body", std::string(request.body.begin(), request.body.end()) == "hello!");
+
+    expect_malformed("negative content length", head + "Content-Length: -1\r\n\r\nhello");
+    expect_malformed("signed content length", head + "Content-Length: +5\r\n\r\nhello");
+    expect_malformed("huge content length", head + "Content-Length: 18446744073709551615\r\n\r\nhello");
+    expect_malformed("overflowing content length", head + "Content-Length: 99999999999999999999999\r\n\r\nhello");
+    expect_malformed("content length past the input", head + "Content-Length: 6\r\n\r\nhello");
+    expect_malformed("huge chunk size", head + "Transfer-Encoding: chunked\r\n\r\nffffffffffffffff\r\nhello\r\n0\r\n\r\n");
+    expect_malformed("negative chunk size", head + "Transfer-Encoding: chunked\r\n\r\n-1\r\nhello\r\n0\r\n\r\n");
+    expect_malformed("chunk past the input", head + "Transfer-Encoding: chunked\r\n\r\n6\r\nhello\r\n0\r\n\r\n");
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " loopback check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "loopback: all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "net/request_parser.hpp"
+
+#include <iostream>
+#include <string>
+
+using enderman::net::RequestHead;
+using enderman::net::RequestParser;
+
+namespace
+{
+    int failures = 0;
+
+    const char *result_name(RequestParser::Result result)
+    {
+        switch (result)
+        {
+        case RequestParser::Result::COMPLETE:
+            return "COMPLETE";
+        case RequestParser::Result::INCOMPLETE:
+            return "INCOMPLETE";
+        case RequestParser::Result::MALFORMED:
+            return "MALFORMED";
+        case RequestParser::Result::TOO_LARGE:
+            return "TOO_LARGE";
+        case RequestParser::Result::UNSUPPORTED:
+            return "UNSUPPORTED";
+        }
+        return "?";
+    }
+
+    /// @brief Parse a request head and compare the result.
+    RequestHead expect(const std::string &name, const std::string &data, RequestParser::Result expected)
+    {
+        RequestHead head;
+        RequestParser::Result result = RequestParser::parse_head(data, head);
+        if (result != expected)
+        {
+            std::cerr << name << ": expected " << result_name(expected) << ", got " << result_name(result) << std::endl;
+            ++failures;
+        }
+        return head;
+    }
+
+    void check(const std::string &name, bool condition)
+    {
+        if (condition)
+            return;
+        std::cerr << name << ": check failed" << std::endl;
+        ++failures;
+    }
+
+    std::string request(const std::string &headers)
+    {
+        return "POST /upload HTTP/1.1\r\nHost: example.com\r\n" + headers + "\r\n";
+    }
+}
+
+int main()
+{
+    using Result = RequestParser::Result;
+
+    RequestHead head = expect("content length", request("Content-Length: 5\r\n") + "hello", Result::COMPLETE);
+    check("content length value", head.content_length == 5u && !head.chunked);
+    head = expect("chunked", request("Transfer-Encoding: chunked\r\n"), Result::COMPLETE);
+    check("chunked flag", head.chunked && !head.content_length);
+    head = expect("chunked case-insensitive", request("transfer-encoding: Chunked\r\n"), Result::COMPLETE);
+    check("chunked case-insensitive flag", head.chunked);
+    expect("incomplete", "GET / HTTP/1.1\r\nHost: example.com\r\n", Result::INCOMPLETE);
+
+    // Field names are tokens: whitespace before the colon would hide Content-Length from this parser but not from others.
+    expect("space before colon", request("Content-Length : 5\r\n") + "hello", Result::MALFORMED);
+    expect("tab before colon", request("Content-Length\t: 5\r\n") + "hello", Result::MALFORMED);
+    expect("space in name", request("Content Length: 5\r\n") + "hello", Result::MALFORMED);
+    expect("non-token in name", request("Content-Length\x01: 5\r\n") + "hello", Result::MALFORMED);
+    expect("empty name", request(": 5\r\n"), Result::MALFORMED);
+    expect("missing colon", request("Content-Length 5\r\n"), Result::MALFORMED);
+
+    // Obsolete line folding.
+    expect("obs-fold space", request("X-Long: first\r\n second\r\n"), Result::MALFORMED);
+    expect("obs-fold tab", request("X-Long: first\r\n\tsecond\r\n"), Result::MALFORMED);
+
+    // Lines end with CRLF only.
+    expect("bare LF in value", request("X-Value: a\nContent-Length: 5\r\n") + "hello", Result::MALFORMED);
+    expect("bare CR in value", request("X-Value: a\rContent-Length: 5\r\n") + "hello", Result::MALFORMED);
+    expect("bare LF line end", "GET / HTTP/1.1\r\nHost: example.com\n\r\n\r\n", Result::MALFORMED);
+    expect("bare CR in request line", "GET /a\rb HTTP/1.1\r\nHost: example.com\r\n\r\n", Result::MALFORMED);
+    expect("NUL in value", request(std::string("X-Value: a\0b\r\n", 14)), Result::MALFORMED);
+
+    // chunked must be the final transfer coding, and other codings are not implemented.
+    expect("chunked not final", request("Transfer-Encoding: chunked, gzip\r\n"), Result::MALFORMED);
+    expect("chunked not final across fields", request("Transfer-Encoding: chunked\r\nTransfer-Encoding: gzip\r\n"), Result::MALFORMED);
+    expect("chunked twice", request("Transfer-Encoding: chunked, chunked\r\n"), Result::MALFORMED);
+    expect("no chunked", request("Transfer-Encoding: gzip\r\n"), Result::MALFORMED);
+    expect("empty transfer encoding", request("Transfer-Encoding: \r\n"), Result::MALFORMED);
+    expect("other coding before chunked", request("Transfer-Encoding: gzip, chunked\r\n"), Result::UNSUPPORTED);
+    expect("other coding in earlier field", request("Transfer-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n"), Result::UNSUPPORTED);
+    expect("malformed coding", request("Transfer-Encoding: g zip, chunked\r\n"), Result::MALFORMED);
+
+    // Conflicting framing.
+    expect("chunked and content length", request("Transfer-Encoding: chunked\r\nContent-Length: 5\r\n"), Result::MALFORMED);
+    expect("conflicting content lengths", request("Content-Length: 5\r\nContent-Length: 6\r\n"), Result::MALFORMED);
+    expect("signed content length", request("Content-Length: +5\r\n"), Result::MALFORMED);
+    expect("negative content length", request("Content-Length: -1\r\n"), Result::MALFORMED);
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " request parser check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "request parser: all checks passed" << std::endl;
+    return 0;
+}
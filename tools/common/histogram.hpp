@@ -0,0 +1,108 @@
+/// @file histogram.hpp
+/// @brief Log-linear latency histogram with bounded relative error, in the spirit of HdrHistogram.
+
+#ifndef ENDERMAN_TOOLS_HISTOGRAM_HPP
+#define ENDERMAN_TOOLS_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace enderman_tools
+{
+    /// @brief Histogram of non-negative integer values (nanoseconds in the tools).
+    /// Values below 2^SUB_BUCKET_BITS are counted exactly, larger values with a relative error below 2^-(SUB_BUCKET_BITS - 1).
+    /// Recording is O(1) and histograms of several threads can be merged.
+    class LatencyHistogram
+    {
+    public:
+        static constexpr int SUB_BUCKET_BITS = 8;
+
+        LatencyHistogram() : counts(bucket_count(), 0) {}
+
+        void record(uint64_t value)
+        {
+            ++counts[index_of(value)];
+            ++total;
+            sum += static_cast<double>(value);
+            max_value = std::max(max_value, value);
+            min_value = std::min(min_value, value);
+        }
+
+        void merge(const LatencyHistogram &other)
+        {
+            for (size_t i = 0; i < counts.size(); ++i)
+                counts[i] += other.counts[i];
+            total += other.total;
+            sum += other.sum;
+            max_value = std::max(max_value, other.max_value);
+            min_value = std::min(min_value, other.min_value);
+        }
+
+        uint64_t count() const { return total; }
+        uint64_t max() const { return total ? max_value : 0; }
+        uint64_t min() const { return total ? min_value : 0; }
+        double mean() const { return total ? sum / total : 0; }
+
+        /// @brief Get the value at a percentile. The upper bound of the bucket holding the percentile is returned, capped at the max value.
+        /// @param percentile Percentile in [0, 100].
+        /// @return Value at the percentile, 0 if the histogram is empty.
+        uint64_t percentile(double percentile) const
+        {
+            if (total == 0)
+                return 0;
+            uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * total));
+            rank = std::max<uint64_t>(1, std::min(rank, total));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts.size(); ++i)
+            {
+                seen += counts[i];
+                if (seen >= rank)
+                    return std::min(upper_bound_of(i), max_value);
+            }
+            return max_value;
+        }
+
+    private:
+        static constexpr uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BUCKET_BITS;
+        static constexpr uint64_t HALF = SUB_BUCKETS / 2;
+
+        std::vector<uint64_t> counts;
+        uint64_t total = 0;
+        double sum = 0;
+        uint64_t max_value = 0;
+        uint64_t min_value = UINT64_MAX;
+
+        static size_t bucket_count()
+        {
+            return SUB_BUCKETS + (64 - SUB_BUCKET_BITS + 1) * HALF;
+        }
+
+        static int msb(uint64_t value)
+        {
+            return 63 - __builtin_clzll(value);
+        }
+
+        static size_t index_of(uint64_t value)
+        {
+            if (value < SUB_BUCKETS)
+                return static_cast<size_t>(value);
+            int shift = msb(value) - (SUB_BUCKET_BITS - 1);
+            uint64_t sub = value >> shift;
+            return static_cast<size_t>(SUB_BUCKETS + (shift - 1) * HALF + (sub - HALF));
+        }
+
+        static uint64_t upper_bound_of(size_t index)
+        {
+            if (index < SUB_BUCKETS)
+                return index;
+            uint64_t offset = index - SUB_BUCKETS;
+            int shift = static_cast<int>(offset / HALF) + 1;
+            uint64_t sub = offset % HALF + HALF;
+            return ((sub + 1) << shift) - 1;
+        }
+    };
+}
+
+#endif // ENDERMAN_TOOLS_HISTOGRAM_HPP
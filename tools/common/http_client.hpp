@@ -0,0 +1,307 @@
+/// @file http_client.hpp
+/// @brief Minimal blocking HTTP/1.1 keep-alive client used by the load and replay tools.
+
+#ifndef ENDERMAN_TOOLS_HTTP_CLIENT_HPP
+#define ENDERMAN_TOOLS_HTTP_CLIENT_HPP
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace enderman_tools
+{
+    class ConnectionException : public std::runtime_error
+    {
+    public:
+        explicit ConnectionException(const std::string &message)
+            : std::runtime_error(message) {}
+    };
+
+    /// @brief Request as written on the wire by HttpConnection.
+    struct HttpRequestSpec
+    {
+        std::string method = "GET";
+        /// @brief Raw request target including the query string.
+        std::string uri = "/";
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;
+
+        /// @brief Serialize the request. Host and Content-Length are added unless already present.
+        /// @param host Value of the Host header.
+        std::string serialize(const std::string &host) const
+        {
+            bool has_host = false;
+            bool has_length = false;
+            for (const auto &header : headers)
+            {
+                has_host = has_host || strcasecmp(header.first.c_str(), "host") == 0;
+                has_length = has_length || strcasecmp(header.first.c_str(), "content-length") == 0 ||
+                             strcasecmp(header.first.c_str(), "transfer-encoding") == 0;
+            }
+
+            std::string out;
+            out.reserve(64 + uri.size() + body.size());
+            out += method;
+            out += ' ';
+            out += uri;
+            out += " HTTP/1.1\r\n";
+            if (!has_host)
+                out += "Host: " + host + "\r\n";
+            for (const auto &header : headers)
+                out += header.first + ": " + header.second + "\r\n";
+            if (!has_length && (!body.empty() || method == "POST" || method == "PUT" || method == "PATCH"))
+                out += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+            out += "\r\n";
+            out += body;
+            return out;
+        }
+    };
+
+    struct HttpResult
+    {
+        int status_code = 0;
+        /// @brief Bytes of the whole response message, head included.
+        size_t bytes = 0;
+        /// @brief False if the server asked to close the connection.
+        bool keep_alive = true;
+    };
+
+    /// @brief Blocking keep-alive connection. Responses are delimited by Content-Length, chunked transfer encoding or connection close.
+    /// Not thread safe; every thread of a tool owns its connections.
+    class HttpConnection
+    {
+    private:
+        std::string host;
+        std::string port;
+        int fd = -1;
+        std::string buffer;
+        size_t buffer_pos = 0;
+        /// @brief Bytes of responses consumed since the connection was created.
+        size_t consumed = 0;
+
+        [[noreturn]] static void fail(const std::string &what)
+        {
+            throw ConnectionException(what + ": " + std::strerror(errno));
+        }
+
+        /// @brief Read more data into the buffer.
+        /// @return False on orderly close by the peer.
+        bool fill()
+        {
+            if (buffer_pos > 0 && buffer_pos == buffer.size())
+            {
+                buffer.clear();
+                buffer_pos = 0;
+            }
+            char chunk[16384];
+            while (true)
+            {
+                ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n > 0)
+                {
+                    buffer.append(chunk, static_cast<size_t>(n));
+                    return true;
+                }
+                if (n == 0)
+                    return false;
+                if (errno != EINTR)
+                    fail("recv");
+            }
+        }
+
+        /// @brief Read a CRLF terminated line, the CRLF is consumed but not returned.
+        std::string read_line()
+        {
+            while (true)
+            {
+                size_t end = buffer.find("\r\n", buffer_pos);
+                if (end != std::string::npos)
+                {
+                    std::string line = buffer.substr(buffer_pos, end - buffer_pos);
+                    consumed += end + 2 - buffer_pos;
+                    buffer_pos = end + 2;
+                    return line;
+                }
+                if (!fill())
+                    throw ConnectionException("Connection closed in the middle of a response");
+            }
+        }
+
+        /// @brief Consume exactly count bytes.
+        void skip(size_t count)
+        {
+            while (buffer.size() - buffer_pos < count)
+            {
+                count -= buffer.size() - buffer_pos;
+                consumed += buffer.size() - buffer_pos;
+                buffer_pos = buffer.size();
+                if (!fill())
+                    throw ConnectionException("Connection closed in the middle of a body");
+            }
+            buffer_pos += count;
+            consumed += count;
+        }
+
+    public:
+        HttpConnection(std::string host_, std::string port_)
+            : host(std::move(host_)), port(std::move(port_)) {}
+        HttpConnection(const HttpConnection &) = delete;
+        HttpConnection &operator=(const HttpConnection &) = delete;
+        ~HttpConnection() { close(); }
+
+        bool is_open() const { return fd >= 0; }
+        const std::string &host_header() const { return host; }
+
+        void open()
+        {
+            close();
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo *addresses = nullptr;
+            int rc = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+            if (rc != 0)
+                throw ConnectionException("getaddrinfo: " + std::string(gai_strerror(rc)));
+            for (addrinfo *ai = addresses; ai; ai = ai->ai_next)
+            {
+                fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+                if (fd < 0)
+                    continue;
+                if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+                    break;
+                ::close(fd);
+                fd = -1;
+            }
+            ::freeaddrinfo(addresses);
+            if (fd < 0)
+                fail("connect to " + host + ":" + port);
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        void close()
+        {
+            if (fd >= 0)
+                ::close(fd);
+            fd = -1;
+            buffer.clear();
+            buffer_pos = 0;
+        }
+
+        /// @brief Write a serialized request, opening the connection first if needed.
+        void send(const std::string &data)
+        {
+            if (!is_open())
+                open();
+            size_t sent = 0;
+            while (sent < data.size())
+            {
+                ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    fail("send");
+                }
+                sent += static_cast<size_t>(n);
+            }
+        }
+
+        /// @brief Read one response. The body is discarded.
+        /// @param head_request True if the request was HEAD, whose response never has a body.
+        HttpResult read_response(bool head_request = false)
+        {
+            HttpResult result;
+            size_t start = consumed;
+
+            std::string status_line = read_line();
+            if (status_line.compare(0, 7, "HTTP/1.") != 0 || status_line.size() < 12)
+                throw ConnectionException("Invalid status line: " + status_line);
+            result.status_code = std::atoi(status_line.c_str() + 9);
+            if (status_line.compare(0, 8, "HTTP/1.0") == 0)
+                result.keep_alive = false;
+
+            long long content_length = -1;
+            bool chunked = false;
+            while (true)
+            {
+                std::string line = read_line();
+                if (line.empty())
+                    break;
+                size_t colon = line.find(':');
+                if (colon == std::string::npos)
+                    continue;
+                std::string name = line.substr(0, colon);
+                size_t value_start = line.find_first_not_of(" \t", colon + 1);
+                std::string value = value_start == std::string::npos ? "" : line.substr(value_start);
+                if (strcasecmp(name.c_str(), "content-length") == 0)
+                    content_length = std::atoll(value.c_str());
+                else if (strcasecmp(name.c_str(), "transfer-encoding") == 0)
+                    chunked = strcasestr(value.c_str(), "chunked") != nullptr;
+                else if (strcasecmp(name.c_str(), "connection") == 0)
+                {
+                    if (strcasestr(value.c_str(), "close"))
+                        result.keep_alive = false;
+                    else if (strcasestr(value.c_str(), "keep-alive"))
+                        result.keep_alive = true;
+                }
+            }
+
+            bool no_body = head_request || result.status_code == 204 || result.status_code == 304 ||
+                           (result.status_code >= 100 && result.status_code < 200);
+            if (no_body)
+            {
+                // Status codes and HEAD responses without a body.
+            }
+            else if (chunked)
+            {
+                while (true)
+                {
+                    std::string size_line = read_line();
+                    size_t chunk_size = std::strtoull(size_line.c_str(), nullptr, 16);
+                    if (chunk_size == 0)
+                    {
+                        // Trailer section ends with an empty line.
+                        while (!read_line().empty())
+                            ;
+                        break;
+                    }
+                    skip(chunk_size + 2);
+                }
+            }
+            else if (content_length >= 0)
+            {
+                skip(static_cast<size_t>(content_length));
+            }
+            else
+            {
+                // Body delimited by connection close.
+                do
+                {
+                    consumed += buffer.size() - buffer_pos;
+                    buffer_pos = buffer.size();
+                } while (fill());
+                result.keep_alive = false;
+            }
+
+            result.bytes = consumed - start;
+            if (!result.keep_alive)
+                close();
+            return result;
+        }
+    };
+}
+
+#endif // ENDERMAN_TOOLS_HTTP_CLIENT_HPP
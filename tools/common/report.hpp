@@ -0,0 +1,148 @@
+/// @file report.hpp
+/// @brief Result accounting and report output shared by the load and replay tools, so that their reports can be compared.
+
+#ifndef ENDERMAN_TOOLS_REPORT_HPP
+#define ENDERMAN_TOOLS_REPORT_HPP
+
+#include "histogram.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace enderman_tools
+{
+    /// @brief Results of one thread, merged into the totals after the run.
+    struct RunStats
+    {
+        /// @brief Time from the intended send time to the end of the response.
+        LatencyHistogram latency;
+        /// @brief Time from the actual send time to the end of the response.
+        LatencyHistogram service_time;
+        uint64_t requests = 0;
+        uint64_t errors = 0;
+        uint64_t bytes = 0;
+        std::map<int, uint64_t> status_codes;
+        std::map<std::string, uint64_t> error_messages;
+
+        void merge(const RunStats &other)
+        {
+            latency.merge(other.latency);
+            service_time.merge(other.service_time);
+            requests += other.requests;
+            errors += other.errors;
+            bytes += other.bytes;
+            for (const auto &status : other.status_codes)
+                status_codes[status.first] += status.second;
+            for (const auto &error : other.error_messages)
+                error_messages[error.first] += error.second;
+        }
+    };
+
+    inline std::string json_escape(const std::string &value)
+    {
+        std::string out;
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+                out += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    inline std::string local_date()
+    {
+        char date[64];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+        return date;
+    }
+
+    inline void write_latency_json(std::ostream &out, const char *name, const LatencyHistogram &histogram, bool last)
+    {
+        static const std::pair<const char *, double> percentiles[] = {
+            {"p50", 50}, {"p75", 75}, {"p90", 90}, {"p99", 99}, {"p99_9", 99.9}, {"p99_99", 99.99}};
+        out << "    \"" << name << "\": {\n";
+        out << "      \"count\": " << histogram.count() << ",\n";
+        out << "      \"min\": " << histogram.min() / 1e3 << ",\n";
+        out << "      \"mean\": " << histogram.mean() / 1e3 << ",\n";
+        for (const auto &p : percentiles)
+            out << "      \"" << p.first << "\": " << histogram.percentile(p.second) / 1e3 << ",\n";
+        out << "      \"max\": " << histogram.max() / 1e3 << "\n";
+        out << "    }" << (last ? "" : ",") << "\n";
+    }
+
+    /// @brief Write the "results" member of a report. The caller writes the surrounding object and the "context" member.
+    inline void write_results_json(std::ostream &out, const RunStats &total, double elapsed)
+    {
+        out << "  \"results\": {\n";
+        out << "    \"elapsed\": " << elapsed << ",\n";
+        out << "    \"requests\": " << total.requests << ",\n";
+        out << "    \"errors\": " << total.errors << ",\n";
+        out << "    \"bytes_received\": " << total.bytes << ",\n";
+        out << "    \"requests_per_second\": " << (elapsed > 0 ? total.requests / elapsed : 0) << ",\n";
+        out << "    \"bytes_per_second\": " << (elapsed > 0 ? total.bytes / elapsed : 0) << ",\n";
+        out << "    \"status_codes\": {";
+        bool first = true;
+        for (const auto &status : total.status_codes)
+        {
+            out << (first ? "" : ", ") << "\"" << status.first << "\": " << status.second;
+            first = false;
+        }
+        out << "},\n";
+        out << "    \"error_messages\": {";
+        first = true;
+        for (const auto &error : total.error_messages)
+        {
+            out << (first ? "" : ", ") << "\"" << json_escape(error.first) << "\": " << error.second;
+            first = false;
+        }
+        out << "},\n";
+        out << "    \"latency_unit\": \"us\",\n";
+        write_latency_json(out, "latency", total.latency, false);
+        write_latency_json(out, "service_time", total.service_time, true);
+        out << "  }\n";
+    }
+
+    /// @brief Print the results as a human readable table.
+    inline void print_results(const RunStats &total, double elapsed)
+    {
+        std::printf("  requests      %llu in %.2fs, %.1f req/s, %.2f MB/s\n",
+                    static_cast<unsigned long long>(total.requests), elapsed,
+                    elapsed > 0 ? total.requests / elapsed : 0, elapsed > 0 ? total.bytes / elapsed / 1e6 : 0);
+        std::printf("  errors        %llu\n", static_cast<unsigned long long>(total.errors));
+        for (const auto &error : total.error_messages)
+            std::printf("                %llu x %s\n", static_cast<unsigned long long>(error.second), error.first.c_str());
+        std::printf("  status codes ");
+        for (const auto &status : total.status_codes)
+            std::printf(" %d: %llu", status.first, static_cast<unsigned long long>(status.second));
+        std::printf("\n\n  %-10s %12s %12s\n", "latency", "corrected", "service");
+        static const std::pair<const char *, double> percentiles[] = {
+            {"p50", 50}, {"p75", 75}, {"p90", 90}, {"p99", 99}, {"p99.9", 99.9}, {"p99.99", 99.99}};
+        for (const auto &p : percentiles)
+        {
+            std::printf("  %-10s %10.1fus %10.1fus\n", p.first,
+                        total.latency.percentile(p.second) / 1e3, total.service_time.percentile(p.second) / 1e3);
+        }
+        std::printf("  %-10s %10.1fus %10.1fus\n", "max", total.latency.max() / 1e3, total.service_time.max() / 1e3);
+    }
+}
+
+#endif // ENDERMAN_TOOLS_REPORT_HPP
@@ -0,0 +1,358 @@
+/// @file main.cpp
+/// @brief enderman-load: HTTP load generator for benchmarking Enderman applications on one machine.
+/// @brief Latencies of open-loop runs are measured from the intended send time, which corrects for coordinated omission.
+
+#include "http_client.hpp"
+#include "report.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct MixEntry
+    {
+        double weight = 1;
+        enderman_tools::HttpRequestSpec spec;
+        /// @brief Serialized request, built once before the run.
+        std::string wire;
+    };
+
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        std::string port = "3000";
+        int connections = 16;
+        double duration = 10;
+        double warmup = 1;
+        /// @brief Total request rate in requests per second, 0 runs closed loop as fast as responses arrive.
+        double rate = 0;
+        uint64_t seed = 1;
+        std::string mix_path;
+        std::vector<std::string> requests;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string json_path;
+    };
+
+    std::string trim(const std::string &value)
+    {
+        size_t start = value.find_first_not_of(" \t\r\n");
+        if (start == std::string::npos)
+            return "";
+        size_t end = value.find_last_not_of(" \t\r\n");
+        return value.substr(start, end - start + 1);
+    }
+
+    std::string read_file(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            throw std::runtime_error("Unable to open " + path);
+        std::ostringstream out;
+        out << file.rdbuf();
+        return out.str();
+    }
+
+    std::string directory_of(const std::string &path)
+    {
+        size_t slash = path.find_last_of('/');
+        return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    }
+
+    /// @brief Parse a mix file. Every non-empty line not starting with '#' is
+    /// "<weight> <METHOD> <uri> [<body-file> [<content-type>]]". Body files are relative to the mix file.
+    std::vector<MixEntry> parse_mix(const std::string &path)
+    {
+        std::vector<MixEntry> mix;
+        std::istringstream lines(read_file(path));
+        std::string line;
+        int line_number = 0;
+        while (std::getline(lines, line))
+        {
+            ++line_number;
+            line = trim(line);
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::istringstream fields(line);
+            MixEntry entry;
+            std::string body_file;
+            std::string content_type;
+            if (!(fields >> entry.weight >> entry.spec.method >> entry.spec.uri) || entry.weight <= 0)
+                throw std::runtime_error(path + ":" + std::to_string(line_number) + ": expected <weight> <METHOD> <uri> [<body-file> [<content-type>]]");
+            if (fields >> body_file)
+            {
+                std::string body_path = body_file[0] == '/' ? body_file : directory_of(path) + body_file;
+                entry.spec.body = read_file(body_path);
+                if (fields >> content_type)
+                    entry.spec.headers.emplace_back("Content-Type", content_type);
+            }
+            mix.push_back(std::move(entry));
+        }
+        if (mix.empty())
+            throw std::runtime_error(path + ": no requests");
+        return mix;
+    }
+
+    void run_worker(int index, const Options &options, const std::vector<MixEntry> &mix,
+                    Clock::time_point start, Clock::time_point measure_start, Clock::time_point end,
+                    enderman_tools::RunStats &stats)
+    {
+        enderman_tools::HttpConnection connection(options.host, options.port);
+        std::mt19937_64 rng(options.seed + static_cast<uint64_t>(index));
+        std::vector<double> weights;
+        for (const auto &entry : mix)
+            weights.push_back(entry.weight);
+        std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+
+        // In open-loop mode every connection sends at rate / connections, with the connections evenly staggered.
+        Clock::duration interval{};
+        Clock::time_point next = start;
+        if (options.rate > 0)
+        {
+            interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.connections / options.rate));
+            next += interval * index / options.connections;
+        }
+
+        while (true)
+        {
+            Clock::time_point intended;
+            if (options.rate > 0)
+            {
+                if (next >= end)
+                    break;
+                std::this_thread::sleep_until(next);
+                intended = next;
+                next += interval;
+            }
+            else
+            {
+                intended = Clock::now();
+                if (intended >= end)
+                    break;
+            }
+
+            const MixEntry &entry = mix[pick(rng)];
+            bool measured = intended >= measure_start;
+            Clock::time_point sent = Clock::now();
+            try
+            {
+                connection.send(entry.wire);
+                enderman_tools::HttpResult result = connection.read_response(entry.spec.method == "HEAD");
+                Clock::time_point done = Clock::now();
+                if (!measured)
+                    continue;
+                stats.latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(done - intended).count()));
+                stats.service_time.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(done - sent).count()));
+                ++stats.requests;
+                stats.bytes += result.bytes;
+                ++stats.status_codes[result.status_code];
+            }
+            catch (const enderman_tools::ConnectionException &e)
+            {
+                connection.close();
+                if (measured)
+                {
+                    ++stats.errors;
+                    ++stats.error_messages[e.what()];
+                }
+                // Do not spin on a refused connection in closed-loop mode.
+                if (options.rate <= 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+    }
+
+    void write_json(std::ostream &out, const Options &options, const std::vector<MixEntry> &mix,
+                    const enderman_tools::RunStats &total, double elapsed)
+    {
+        out << "{\n  \"context\": {\n";
+        out << "    \"date\": \"" << enderman_tools::local_date() << "\",\n";
+        out << "    \"executable\": \"enderman-load\",\n";
+        out << "    \"target\": \"" << enderman_tools::json_escape(options.host) << ":" << enderman_tools::json_escape(options.port) << "\",\n";
+        out << "    \"connections\": " << options.connections << ",\n";
+        out << "    \"duration\": " << options.duration << ",\n";
+        out << "    \"warmup\": " << options.warmup << ",\n";
+        out << "    \"mode\": \"" << (options.rate > 0 ? "open" : "closed") << "\",\n";
+        out << "    \"rate\": " << options.rate << ",\n";
+        out << "    \"seed\": " << options.seed << ",\n";
+        out << "    \"mix\": [\n";
+        for (size_t i = 0; i < mix.size(); ++i)
+        {
+            out << "      {\"weight\": " << mix[i].weight << ", \"method\": \"" << enderman_tools::json_escape(mix[i].spec.method)
+                << "\", \"uri\": \"" << enderman_tools::json_escape(mix[i].spec.uri) << "\", \"body_bytes\": " << mix[i].spec.body.size() << "}"
+                << (i + 1 < mix.size() ? "," : "") << "\n";
+        }
+        out << "    ]\n  },\n";
+
+        enderman_tools::write_results_json(out, total, elapsed);
+        out << "}\n";
+    }
+
+    void print_summary(const Options &options, const enderman_tools::RunStats &total, double elapsed)
+    {
+        std::printf("%s:%s  %d connections  %s", options.host.c_str(), options.port.c_str(), options.connections,
+                    options.rate > 0 ? "open loop" : "closed loop");
+        if (options.rate > 0)
+            std::printf(" at %.0f req/s", options.rate);
+        std::printf("\n\n");
+        enderman_tools::print_results(total, elapsed);
+    }
+
+    void print_usage()
+    {
+        std::cout << "Usage: enderman-load [options]\n"
+                     "  --host <host>            Server host (default 127.0.0.1)\n"
+                     "  --port <port>            Server port (default 3000)\n"
+                     "  -c, --connections <n>    Keep-alive connections, one thread each (default 16)\n"
+                     "  -d, --duration <sec>     Measured duration (default 10)\n"
+                     "  --warmup <sec>           Unmeasured warmup before the measurement (default 1)\n"
+                     "  -R, --rate <req/s>       Total open-loop request rate; 0 runs closed loop (default 0)\n"
+                     "  -r, --request \"<METHOD> <uri>\"  Request to send, repeatable, equal weights (default \"GET /\")\n"
+                     "  --mix <file>             Request mix, lines of \"<weight> <METHOD> <uri> [<body-file> [<content-type>]]\"\n"
+                     "  -H, --header \"<name>: <value>\"  Header added to every request, repeatable\n"
+                     "  --seed <n>               Seed of the request mix selection (default 1)\n"
+                     "  --json <file|->          Write the report as JSON\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--host" && has_value)
+            options.host = argv[++i];
+        else if (arg == "--port" && has_value)
+            options.port = argv[++i];
+        else if ((arg == "-c" || arg == "--connections") && has_value)
+            options.connections = std::max(1, std::atoi(argv[++i]));
+        else if ((arg == "-d" || arg == "--duration") && has_value)
+            options.duration = std::atof(argv[++i]);
+        else if (arg == "--warmup" && has_value)
+            options.warmup = std::max(0.0, std::atof(argv[++i]));
+        else if ((arg == "-R" || arg == "--rate") && has_value)
+            options.rate = std::max(0.0, std::atof(argv[++i]));
+        else if ((arg == "-r" || arg == "--request") && has_value)
+            options.requests.push_back(argv[++i]);
+        else if (arg == "--mix" && has_value)
+            options.mix_path = argv[++i];
+        else if ((arg == "-H" || arg == "--header") && has_value)
+        {
+            std::string header = argv[++i];
+            size_t colon = header.find(':');
+            if (colon == std::string::npos || colon == 0)
+            {
+                std::cerr << "Invalid header: " << header << std::endl;
+                return 1;
+            }
+            options.headers.emplace_back(trim(header.substr(0, colon)), trim(header.substr(colon + 1)));
+        }
+        else if (arg == "--seed" && has_value)
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--json" && has_value)
+            options.json_path = argv[++i];
+        else
+        {
+            print_usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (options.duration <= 0)
+    {
+        std::cerr << "Duration must be positive" << std::endl;
+        return 1;
+    }
+
+    std::vector<MixEntry> mix;
+    try
+    {
+        if (!options.mix_path.empty())
+            mix = parse_mix(options.mix_path);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    for (const auto &request : options.requests)
+    {
+        std::istringstream fields(request);
+        MixEntry entry;
+        if (!(fields >> entry.spec.method >> entry.spec.uri))
+        {
+            std::cerr << "Invalid request: " << request << std::endl;
+            return 1;
+        }
+        mix.push_back(std::move(entry));
+    }
+    if (mix.empty())
+        mix.emplace_back();
+    for (auto &entry : mix)
+    {
+        entry.spec.headers.insert(entry.spec.headers.end(), options.headers.begin(), options.headers.end());
+        entry.wire = entry.spec.serialize(options.host + ":" + options.port);
+    }
+
+    // Fail early with a clear message rather than reporting every request as an error.
+    try
+    {
+        enderman_tools::HttpConnection probe(options.host, options.port);
+        probe.open();
+    }
+    catch (const enderman_tools::ConnectionException &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<enderman_tools::RunStats> stats(static_cast<size_t>(options.connections));
+    std::vector<std::thread> workers;
+    Clock::time_point start = Clock::now() + std::chrono::milliseconds(50);
+    Clock::time_point measure_start = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.warmup));
+    Clock::time_point end = measure_start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+    for (int i = 0; i < options.connections; ++i)
+    {
+        workers.emplace_back([&, i]()
+                             { run_worker(i, options, mix, start, measure_start, end, stats[static_cast<size_t>(i)]); });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    // Responses of requests intended before the end may still arrive after it; they are part of the measurement.
+    double elapsed = std::chrono::duration<double>(std::max(end, Clock::now()) - measure_start).count();
+
+    enderman_tools::RunStats total;
+    for (const auto &worker : stats)
+        total.merge(worker);
+
+    if (options.json_path == "-")
+    {
+        write_json(std::cout, options, mix, total, elapsed);
+        return 0;
+    }
+    print_summary(options, total, elapsed);
+    if (!options.json_path.empty())
+    {
+        std::ofstream file(options.json_path);
+        if (!file)
+        {
+            std::cerr << "Unable to open " << options.json_path << std::endl;
+            return 1;
+        }
+        write_json(file, options, mix, total, elapsed);
+    }
+    return 0;
+}
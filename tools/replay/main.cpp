@@ -0,0 +1,242 @@
+/// @file main.cpp
+/// @brief enderman-replay: replays a capture written by the traffic_capture middleware against a running server.
+/// @brief Requests are sent at their captured arrival times, optionally scaled, and latency is measured from that schedule.
+
+#include "http_client.hpp"
+#include "report.hpp"
+
+#include "enderman/debug/capture_format.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <strings.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        std::string port = "3000";
+        std::string file;
+        int connections = 8;
+        /// @brief Replay speed relative to the capture, 0 sends every connection's requests back to back.
+        double speed = 1.0;
+        size_t max_records = 0;
+        std::string json_path;
+    };
+
+    struct ReplayRequest
+    {
+        uint64_t offset_us = 0;
+        bool head = false;
+        std::string wire;
+    };
+
+    /// @brief Load the capture and serialize every request once up front.
+    /// Message framing headers are dropped, the body was captured decoded and gets a fresh Content-Length.
+    std::vector<ReplayRequest> load_capture(const Options &options)
+    {
+        std::ifstream file(options.file, std::ios::binary);
+        if (!file)
+            throw std::runtime_error("Unable to open " + options.file);
+
+        std::vector<ReplayRequest> requests;
+        std::string line;
+        size_t line_number = 0;
+        while (std::getline(file, line))
+        {
+            ++line_number;
+            if (line.empty())
+                continue;
+            if (options.max_records && requests.size() >= options.max_records)
+                break;
+            enderman::CaptureRecord record;
+            try
+            {
+                record = enderman::decode_capture_record(line);
+            }
+            catch (const std::exception &e)
+            {
+                throw std::runtime_error(options.file + ":" + std::to_string(line_number) + ": " + e.what());
+            }
+
+            enderman_tools::HttpRequestSpec spec;
+            spec.method = record.method;
+            spec.uri = record.uri;
+            for (auto &header : record.headers)
+            {
+                const char *name = header.first.c_str();
+                if (strcasecmp(name, "content-length") == 0 || strcasecmp(name, "transfer-encoding") == 0 ||
+                    strcasecmp(name, "connection") == 0)
+                    continue;
+                spec.headers.emplace_back(std::move(header.first), std::move(header.second));
+            }
+            spec.body = std::move(record.body);
+
+            ReplayRequest request;
+            request.offset_us = record.offset_us;
+            request.head = spec.method == "HEAD";
+            request.wire = spec.serialize(options.host + ":" + options.port);
+            requests.push_back(std::move(request));
+        }
+        // Records are written in completion order of the capture lock, which can differ slightly from arrival order.
+        std::stable_sort(requests.begin(), requests.end(), [](const ReplayRequest &a, const ReplayRequest &b)
+                         { return a.offset_us < b.offset_us; });
+        return requests;
+    }
+
+    void run_worker(int index, const Options &options, const std::vector<ReplayRequest> &requests,
+                    Clock::time_point start, enderman_tools::RunStats &stats)
+    {
+        enderman_tools::HttpConnection connection(options.host, options.port);
+        for (size_t i = static_cast<size_t>(index); i < requests.size(); i += static_cast<size_t>(options.connections))
+        {
+            const ReplayRequest &request = requests[i];
+            Clock::time_point scheduled = Clock::now();
+            if (options.speed > 0)
+            {
+                scheduled = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(request.offset_us / options.speed));
+                std::this_thread::sleep_until(scheduled);
+            }
+            Clock::time_point sent = Clock::now();
+            try
+            {
+                connection.send(request.wire);
+                enderman_tools::HttpResult result = connection.read_response(request.head);
+                Clock::time_point done = Clock::now();
+                stats.latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(done - scheduled).count()));
+                stats.service_time.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(done - sent).count()));
+                ++stats.requests;
+                stats.bytes += result.bytes;
+                ++stats.status_codes[result.status_code];
+            }
+            catch (const enderman_tools::ConnectionException &e)
+            {
+                connection.close();
+                ++stats.errors;
+                ++stats.error_messages[e.what()];
+            }
+        }
+    }
+
+    void write_json(std::ostream &out, const Options &options, const std::vector<ReplayRequest> &requests,
+                    const enderman_tools::RunStats &total, double elapsed)
+    {
+        double captured = requests.empty() ? 0 : requests.back().offset_us / 1e6;
+        out << "{\n  \"context\": {\n";
+        out << "    \"date\": \"" << enderman_tools::local_date() << "\",\n";
+        out << "    \"executable\": \"enderman-replay\",\n";
+        out << "    \"target\": \"" << enderman_tools::json_escape(options.host) << ":" << enderman_tools::json_escape(options.port) << "\",\n";
+        out << "    \"capture\": \"" << enderman_tools::json_escape(options.file) << "\",\n";
+        out << "    \"records\": " << requests.size() << ",\n";
+        out << "    \"capture_duration\": " << captured << ",\n";
+        out << "    \"connections\": " << options.connections << ",\n";
+        out << "    \"speed\": " << options.speed << "\n";
+        out << "  },\n";
+        enderman_tools::write_results_json(out, total, elapsed);
+        out << "}\n";
+    }
+
+    void print_usage()
+    {
+        std::cout << "Usage: enderman-replay --file <capture.jsonl> [options]\n"
+                     "  --host <host>            Server host (default 127.0.0.1)\n"
+                     "  --port <port>            Server port (default 3000)\n"
+                     "  -c, --connections <n>    Keep-alive connections, one thread each (default 8)\n"
+                     "  -s, --speed <factor>     Replay speed relative to the capture; 0 sends back to back (default 1)\n"
+                     "  -n, --max-records <n>    Replay only the first n records\n"
+                     "  --json <file|->          Write the report as JSON\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--host" && has_value)
+            options.host = argv[++i];
+        else if (arg == "--port" && has_value)
+            options.port = argv[++i];
+        else if ((arg == "-f" || arg == "--file") && has_value)
+            options.file = argv[++i];
+        else if ((arg == "-c" || arg == "--connections") && has_value)
+            options.connections = std::max(1, std::atoi(argv[++i]));
+        else if ((arg == "-s" || arg == "--speed") && has_value)
+            options.speed = std::max(0.0, std::atof(argv[++i]));
+        else if ((arg == "-n" || arg == "--max-records") && has_value)
+            options.max_records = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--json" && has_value)
+            options.json_path = argv[++i];
+        else
+        {
+            print_usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (options.file.empty())
+    {
+        print_usage();
+        return 1;
+    }
+
+    std::vector<ReplayRequest> requests;
+    try
+    {
+        requests = load_capture(options);
+        enderman_tools::HttpConnection probe(options.host, options.port);
+        probe.open();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<enderman_tools::RunStats> stats(static_cast<size_t>(options.connections));
+    std::vector<std::thread> workers;
+    Clock::time_point start = Clock::now() + std::chrono::milliseconds(50);
+    for (int i = 0; i < options.connections; ++i)
+    {
+        workers.emplace_back([&, i]()
+                             { run_worker(i, options, requests, start, stats[static_cast<size_t>(i)]); });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    enderman_tools::RunStats total;
+    for (const auto &worker : stats)
+        total.merge(worker);
+
+    if (options.json_path == "-")
+    {
+        write_json(std::cout, options, requests, total, elapsed);
+        return 0;
+    }
+    std::printf("%s -> %s:%s  %zu records  %d connections  speed %g\n\n", options.file.c_str(), options.host.c_str(),
+                options.port.c_str(), requests.size(), options.connections, options.speed);
+    enderman_tools::print_results(total, elapsed);
+    if (!options.json_path.empty())
+    {
+        std::ofstream file(options.json_path);
+        if (!file)
+        {
+            std::cerr << "Unable to open " << options.json_path << std::endl;
+            return 1;
+        }
+        write_json(file, options, requests, total, elapsed);
+    }
+    return 0;
+}